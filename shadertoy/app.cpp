@@ -1,21 +1,36 @@
 #include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <numeric>
+#include <iterator>
+#include <cstring>
+#include <cassert>
 #include <boost/filesystem/path.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
 #include "gl/shapes.hpp"
-#include "gles2/texture_loader_gles2.hpp"
 #include "gles2/property.hpp"
+#include "gles2/framebuffer_gles2.hpp"
+#include "gles2/gpu_memory.hpp"
+#include "gles2/texture_loader_gles2.hpp"
 #include "utility.hpp"
 #include "file_chooser_dialog.hpp"
 #include "project_file.hpp"
 #include "help.hpp"
+#include "y4m_sink.hpp"
+#include "sound_renderer.hpp"
+#include "wav_file.hpp"
+#include "startup_trace.hpp"
 #include "app.hpp"
 
 using std::string;
 using std::to_string;
 using std::cout;
+using std::cerr;
 using std::shared_ptr;
+using std::unique_ptr;
+using std::vector;
 using boost::algorithm::ends_with;
 using glm::vec2;
 using glm::ivec2;
@@ -23,9 +38,12 @@ using glm::vec4;
 using gl::make_quad_xy;
 using gles2::texture2d;
 using gles2::texture_property;
-using gles2::texture_from_file;
 namespace fs = boost::filesystem;
 
+//! keys handled by application, bit index in frame_input::keys mask
+static char const app_keys[] = {'O', 'E', 'R', 'H', 'P', '.', '[', ']', '-', '=', 'W'};
+static char const interactive_keys[] = "OEH";  //!< keys ignored in replay (dialogs, external programs)
+
 template <typename GlmT>
 struct label_holder
 {
@@ -53,16 +71,80 @@ label_holder<GlmT> with_label(std::string const & label, GlmT const & value)
 	return label_holder<GlmT>{label, value};
 }
 
-shadertoy_app::shadertoy_app(ivec2 const & size, string const & shader_fname)
+shadertoy_app::shadertoy_app(ivec2 const & size, string const & shader_fname, shadertoy_options const & opts)
 	: base{parameters{}.geometry(size[0], size[1])}
 	, _next_pressed{10}
+	, _param_dec_pressed{10}
+	, _param_inc_pressed{10}
 	, _fps_label_update{true}
 	, _time_label_update{true}
+	, _outdated_check{true}
+	, _opts{opts}
 	, _paused{false}
+	, _frame{1}
+	, _param_idx{0}
+	, _dwell_t{0.0f}
+	, _fade_t{-1.0f}
+	, _prev_frame{1}
+	, _frames_written{0}
 {
+	startup_trace::instance().phase("window created");
+
+	// image decoders and fonts are loaded in parallel with program loading, UI overlay waits for them
+	_warmup = std::async(std::launch::async, []{
+		startup_trace & trace = startup_trace::instance();
+		gles2::warm_up_image_library();
+		trace.phase("image decoders loaded");
+		string font = locate_font();
+		trace.phase("font located");
+		ui::preload_font(font, 12);
+		ui::preload_font(font, 10);
+		trace.phase("fonts loaded");
+	});
+
 	_quad = make_quad_xy<mesh>(vec2{-1,-1}, 2);
 
-	load_program(shader_fname);
+	_t.offset(opts.time_offset);
+	_t.wrap(opts.time_wrap);
+
+	_prog.optimize(opts.optimize, opts.compile_report);
+
+	if (!opts.playlist.empty())
+	{
+		if (!_playlist.load(opts.playlist))
+			throw std::runtime_error{"empty '" + opts.playlist + "' playlist"};
+
+		load_program(_playlist.current());
+
+		// shared context window needs to be created in the main thread
+		_preloader.reset(new program_preloader{native_window(), opts.optimize});
+		shadertoy_program::specialization spec = program_specialization();
+		spec.defines.clear();  // project defines are used
+		_preloader->prepare(_playlist.peek(), spec);
+	}
+	else
+		load_program(shader_fname);
+
+	if (!opts.output.empty())
+	{
+		_sink.reset(new y4m_sink{opts.output, opts.fps});
+		glfwSwapInterval(0);  // output is throttled by the consumer
+	}
+
+	if (!opts.shm.empty())
+	{
+		ivec2 size = framebuffer_size();  // larger frames (after resize) are not published
+		_shm.reset(new shm::frame_writer{opts.shm, opts.shm_slots, size_t(size.x) * size.y * 4});
+		cout << "publishing frames into '" << opts.shm << "' shared memory ring" << std::endl;
+	}
+
+	if (opts.http_port > 0)
+		_http.reset(new mjpeg_server{uint16_t(opts.http_port), opts.http_fps});
+
+	if (!opts.replay.empty())
+		_player.reset(new input_player{opts.replay});
+	else if (!opts.record.empty())
+		_recorder.reset(new input_recorder{opts.record, framebuffer_size()});
 
 	glClearColor(0,0,0,1);
 
@@ -70,10 +152,26 @@ shadertoy_app::shadertoy_app(ivec2 const & size, string const & shader_fname)
 		add_view(v);
 }
 
+shadertoy_app::~shadertoy_app()
+{
+	// free cached channel textures while the context is still alive, otherwise they are reported as leaks
+	for (auto const & v : _texture_panel)
+		remove_view(v);
+	_texture_panel.clear();
+	_textures.clear();
+	_prev_textures.clear();
+	_prog.free_textures();
+	_prev_prog.free_textures();
+	channel_texture_cache().clear();
+}
+
 void shadertoy_app::update(float dt)
 {
 	base::update(dt);
 
+	if (_overlay_pending && _frame_presented)  // first program frame is not delayed by UI
+		create_overlay();
+
 	// code there ...
 	if (_open_pressed)
 	{
@@ -117,11 +215,61 @@ void shadertoy_app::update(float dt)
 	if (_next_pressed)
 	{
 		float t_prev = _t.now();
-		float t = _t.next(1.0 / _step);
+		float t = _t.next(1, _step);
 		cout << "t=" << t_prev << "s -> " << t << "s" << std::endl;
 	}
 
+	vector<shader_param> & params = _prog.params();
+	if (!params.empty())
+	{
+		_param_idx = std::min(_param_idx, params.size() - 1);
+
+		if (_param_prev_pressed || _param_next_pressed)
+		{
+			_param_idx = (_param_idx + (_param_next_pressed ? 1 : params.size() - 1)) % params.size();
+			update_params_view();
+		}
+
+		if (_param_dec_pressed || _param_inc_pressed)
+		{
+			shader_param & p = params[_param_idx];
+			p.value = std::min(std::max(p.value + (_param_inc_pressed ? p.step : -p.step), p.min), p.max);
+			_param_file.save(params);  // no recompilation, value is uploaded in use()
+			update_params_view();
+		}
+
+		if (_write_params_pressed)
+		{
+			if (write_params_back(params))
+				cout << "parameters written into '" << _program_fname << "' source" << std::endl;
+			else
+				cerr << "error: unable to write parameters back into '" << _program_fname << "' source" << std::endl;
+		}
+	}
+
+	if (_preloader)
+		update_playlist(dt);
+
 	float const UPDATE_DELAY = 0.25f;
+	float const OUTDATED_CHECK_DELAY = 1.0f;
+
+	// reload program after the shader or one of its includes changed
+	_outdated_check.update(dt);
+	if (_outdated_check.get())
+	{
+		if (_prog.outdated())
+		{
+			cout << "'" << _prog.filename() << "' changed, reloading program ..." << std::endl;
+			reload_program();
+		}
+		else if (_param_file.changed())  // changed by other process
+		{
+			_param_file.load(_prog.params());
+			update_params_view();
+		}
+
+		_outdated_check = delayed_bool{false, true, OUTDATED_CHECK_DELAY};
+	}
 
 	_fps_label_update.update(dt);
 
@@ -130,6 +278,8 @@ void shadertoy_app::update(float dt)
 		if (_fps_label)
 		{
 			_fps_label->text(string("fps: ") + to_string(fps()));
+			_gpu_label->text("gpu: " + gles2::gpu_memory::instance().summary());
+			_gpu_label->position(vec2{2, height() - 16});
 			_fps_label_update = delayed_bool{false, true, UPDATE_DELAY};
 		}
 	}
@@ -164,53 +314,170 @@ void shadertoy_app::input(float dt)
 
 	// code there ...
 
-	_open_pressed.update(dt, in().key('O'));
-	_edit_pressed.update(dt, in().key('E'));
-	_reload_pressed.update(dt, in().key('R'));
-	_help_pressed.update(dt, in().key('H'));
-	_pause_pressed.update(dt, in().key('P'));
-	_next_pressed.update(dt, in().key('.'));
-
-	if (in().mouse(ui::event_handler::button::left))
+	if (_player)  // replayed by replay()
 	{
-		if (_click_position.x + _click_position.y == 0.0)
-			_click_position = in().mouse_position();
-
-		_mouse_position = in().mouse_position();
+		_mouse_position = vec2{_input.mouse.x, _input.mouse.y};
+		_click_position = vec2{_input.mouse.z, _input.mouse.w};
 	}
 	else
-		_click_position = _mouse_position = vec2{0, 0};
+	{
+		_input.dt = dt;
+		_input.keys = 0;
+		for (size_t i = 0; i < std::size(app_keys); ++i)
+			if (in().key(app_keys[i]))
+				_input.keys |= 1 << i;
+
+		if (in().mouse(ui::event_handler::button::left))
+		{
+			if (_click_position.x + _click_position.y == 0.0)
+				_click_position = in().mouse_position();
+
+			_mouse_position = in().mouse_position();
+		}
+		else
+			_click_position = _mouse_position = vec2{0, 0};
+	}
+
+	_open_pressed.update(dt, app_key('O'));
+	_edit_pressed.update(dt, app_key('E'));
+	_reload_pressed.update(dt, app_key('R'));
+	_help_pressed.update(dt, app_key('H'));
+	_pause_pressed.update(dt, app_key('P'));
+	_next_pressed.update(dt, app_key('.'));
+	_param_prev_pressed.update(dt, app_key('['));
+	_param_next_pressed.update(dt, app_key(']'));
+	_param_dec_pressed.update(dt, app_key('-'));
+	_param_inc_pressed.update(dt, app_key('='));
+	_write_params_pressed.update(dt, app_key('W'));
 }
 
-void shadertoy_app::display()
+bool shadertoy_app::app_key(char k) const
 {
-	auto now = std::chrono::system_clock::now();
-	if (_t0 == std::chrono::system_clock::time_point{})
-		_t0 = now;
+	if (_player && std::strchr(interactive_keys, k))
+		return false;
 
-	std::chrono::duration<double> dt = now - _t0;  // in s
+	char const * it = std::find(std::begin(app_keys), std::end(app_keys), k);
+	assert(it != std::end(app_keys) && "unknown application key");
+	return _input.keys & (1 << (it - std::begin(app_keys)));
+}
 
+void shadertoy_app::display()
+{
 	glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
 	glEnable(GL_DEPTH_TEST);
 
-	float t = _paused ? _t.now() : _t.next();
+	// fixed 1/fps time step for video output
+	float t = _paused ? _t.now() : (_sink ? _t.next(1, _opts.fps) : _t.next());
+
+	if (_player)  // replayed frame
+	{
+		t = _input.t;
+		_frame = _input.frame;
+	}
+
+	_input.t = t;
+	_input.frame = _frame;
+	_input.mouse = vec4{_mouse_position, _click_position};
+	if (_recorder)
+		_recorder->write(_input);
+
+	if (_opts.specialize && vec2{framebuffer_size()} != _prog.current_specialization().resolution)
+		_prog.specialize(program_specialization());  // cached variant after first use
+
+	if (_fade_t >= 0.0f)  // crossfade, render fading out program first
+	{
+		glDisable(GL_DEPTH_TEST);  // both passes are at the same depth
+
+		float prev_t = _paused ? _prev_t.now() : (_sink ? _prev_t.next(1, _opts.fps) : _prev_t.next());
+		for (auto & ch : _prev_channels)
+			ch->update(prev_t);
+
+		_prev_prog.use();
+		_prev_prog.update(
+			prev_t,
+			vec2(framebuffer_size()),
+			_prev_frame,
+			vec4{_mouse_position, _click_position});
+
+		if (!_paused)
+			++_prev_frame;
+
+		_quad.render();
+
+		float alpha = _opts.fade > 0.0f ? std::min(_fade_t / _opts.fade, 1.0f) : 1.0f;
+		glEnable(GL_BLEND);
+		glBlendColor(0, 0, 0, alpha);
+		glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+	}
 
-	static int __frame = 1;
+	for (auto & ch : _channels)  // before textures are bound
+		ch->update(t);
 
 	_prog.use();
 
 	_prog.update(
 		t,
 		vec2(framebuffer_size()),
-		__frame,
-		vec4{_mouse_position, _click_position});
+		_frame,
+		_input.mouse);
 
 	if (!_paused)
-		++__frame;
+		++_frame;
 
 	_quad.render();
 
+	if (_fade_t >= 0.0f)
+	{
+		glDisable(GL_BLEND);
+		glEnable(GL_DEPTH_TEST);
+	}
+
+	if ((_sink || _shm || _http) && !_paused)  // before UI is rendered
+		capture_frame();
+
 	base::display();
+
+	if (!_frame_presented)
+	{
+		_frame_presented = true;
+		startup_trace::instance().phase("first frame presented");
+	}
+}
+
+void shadertoy_app::capture_frame()
+{
+	ivec2 size = framebuffer_size();
+
+	if (_shm)
+	{
+		size_t frame_size = size_t(size.x) * size.y * 4;
+		if (frame_size <= _shm->slot_size())  // read directly into shared memory
+		{
+			glPixelStorei(GL_PACK_ALIGNMENT, 4);
+			glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, _shm->acquire());
+			_shm->publish(size.x, size.y, shm::pixel_format::rgba8, frame_size);
+		}
+	}
+
+	bool http_frame = _http && _http->wants_frame();  // rate capped
+	if (!http_frame && !_sink)
+		return;
+
+	video_frame frame = read_frame(size.x, size.y);  // read once for both consumers
+
+	if (http_frame)
+		_http->submit(_sink ? video_frame{frame} : std::move(frame));
+
+	if (!_sink)
+		return;
+
+	if (!_sink->write(std::move(frame)))
+	{
+		cerr << "error: video output failed, quit" << std::endl;
+		close();
+	}
+	else if (_opts.frames > 0 && ++_frames_written >= _opts.frames)
+		close();
 }
 
 void shadertoy_app::edit_program()
@@ -220,31 +487,26 @@ bool shadertoy_app::load_program(string const & fname)
 {
 	remove_view(_fps_label);
 	remove_view(_time_label);
+	remove_view(_gpu_label);
+	_fps_label.reset();
+	_time_label.reset();
+	_gpu_label.reset();
 	remove_view(_help_v);
+	remove_view(_params_v);
+	_params_v.reset();
 	for (auto const & v : _texture_panel)
 		remove_view(v);
 	_texture_panel.clear();
 	_textures.clear();
+	_channels.clear();
 
 	if (load_shader_or_project(fname))
 	{
-		_fps_label.reset(new ui::label);
-		_fps_label->init(locate_font(), 12, vec2{width(), height()}, vec2{2,2});
+		startup_trace::instance().phase("program '" + _program_fname + "' loaded");
 
-		_time_label.reset(new ui::label);
-		_time_label->init(locate_font(), 12, vec2{width(), height()}, vec2{width() - 100, 5});
-
-		add_view(_fps_label);
-		add_view(_time_label);
-
-		for (size_t i = 0; i < _textures.size(); ++i)
-		{
-			vec2 pos = vec2{width() - (i+1)*(64+10), height() - 64 - 10};
-			shared_ptr<ui::texture_view> tex{new ui::texture_view{pos, vec2{64, 64}}};
-			tex->reshape(vec2{width(), height()});
-			tex->load(_textures[i]);
-			_texture_panel.push_back(tex);
-		}
+		_overlay_pending = true;  // created by update() after the next frame
+		update_texture_panel();
+		load_params();
 
 		_prog.use();
 
@@ -257,48 +519,380 @@ bool shadertoy_app::load_program(string const & fname)
 	name(fn.native());
 
 	_t.reset();
+	_frame = 1;
 
 	return true;
 }
 
+void shadertoy_app::create_overlay()
+{
+	_overlay_pending = false;
+
+	if (_warmup.valid())
+		_warmup.wait();  // fonts are loaded in background
+
+	_fps_label.reset(new ui::label);
+	_fps_label->init(locate_font(), 12, vec2{width(), height()}, vec2{2,2});
+
+	_time_label.reset(new ui::label);
+	_time_label->init(locate_font(), 12, vec2{width(), height()}, vec2{width() - 100, 5});
+
+	_gpu_label.reset(new ui::label);
+	_gpu_label->init(locate_font(), 12, vec2{width(), height()}, vec2{2, height() - 16});
+
+	add_view(_fps_label);
+	add_view(_time_label);
+	add_view(_gpu_label);
+
+	update_params_view();
+
+	startup_trace & trace = startup_trace::instance();
+	if (!trace.finished())
+	{
+		trace.phase("overlay ready");
+		trace.finish();
+		if (_opts.startup_trace)
+			trace.write(cerr);
+	}
+}
+
+void shadertoy_app::update_texture_panel()
+{
+	for (auto const & v : _texture_panel)
+		remove_view(v);
+	_texture_panel.clear();
+
+	for (size_t i = 0; i < _textures.size(); ++i)
+	{
+		vec2 pos = vec2{width() - (i+1)*(64+10), height() - 64 - 10};
+		shared_ptr<ui::texture_view> tex{new ui::texture_view{pos, vec2{64, 64}}};
+		tex->reshape(vec2{width(), height()});
+		tex->load(_textures[i]);
+		_texture_panel.push_back(tex);
+	}
+}
+
+void shadertoy_app::load_params()
+{
+	_param_file = param_file{param_file_for(_program_fname)};
+	_param_file.load(_prog.params());
+	_param_idx = 0;
+	update_params_view();
+}
+
+void shadertoy_app::update_params_view()
+{
+	if (_overlay_pending)  // created with overlay
+		return;
+
+	vector<shader_param> const & params = _prog.params();
+	if (params.empty())
+	{
+		remove_view(_params_v);
+		_params_v.reset();
+		return;
+	}
+
+	if (!_params_v)
+	{
+		_params_v.reset(new ui::text_view);
+		_params_v->init(locate_font(), 10, vec2{width(), height()}, vec2{2, 20});
+		add_view(_params_v);
+	}
+
+	string text;
+	for (size_t i = 0; i < params.size(); ++i)
+	{
+		text += (i == _param_idx ? "> " : "  ") + params[i].name + " = " + to_string(params[i].value);
+		if (i + 1 < params.size())
+			text += "\n";
+	}
+
+	_params_v->text(text);
+}
+
+void shadertoy_app::update_playlist(float dt)
+{
+	_dwell_t += dt;
+
+	if (_fade_t >= 0.0f)
+	{
+		_fade_t += dt;
+		if (_fade_t >= _opts.fade)  // crossfade done
+		{
+			_fade_t = -1.0f;
+			_prev_prog = shadertoy_program{};
+			_prev_textures.clear();
+			_prev_channels.clear();
+		}
+	}
+
+	// keep showing current program until the next one is prepared
+	if (_dwell_t < _opts.dwell || _fade_t >= 0.0f || !_preloader->ready())
+		return;
+
+	unique_ptr<prepared_program> p = _preloader->take();
+
+	_playlist.next();
+	shadertoy_program::specialization spec = program_specialization();
+	spec.defines.clear();
+	_preloader->prepare(_playlist.peek(), spec);
+
+	if (!p->ok)
+	{
+		cerr << "error: unable to load '" << p->fname << "' program, skipped" << std::endl;
+		return;
+	}
+
+	switch_program(*p);
+}
+
+void shadertoy_app::switch_program(prepared_program & p)
+{
+	// current program fades out
+	_prev_prog = std::move(_prog);
+	_prev_textures = std::move(_textures);
+	_prev_channels = std::move(_channels);
+	_prev_t = _t;
+	_prev_frame = _frame;
+
+	_prog = std::move(p.prog);
+	_prog.optimize(_opts.optimize, _opts.compile_report);
+	_textures = std::move(p.textures);
+	_channels = std::move(p.channels);
+	_defines = std::move(p.defines);
+	_program_fname = _prog.filename();
+	_loaded_fname = p.fname;
+
+	_t.reset();
+	_frame = 1;
+	_dwell_t = 0.0f;
+	_fade_t = _opts.fade > 0.0f ? 0.0f : -1.0f;
+
+	if (_fade_t < 0.0f)  // no crossfade
+	{
+		_prev_prog = shadertoy_program{};
+		_prev_textures.clear();
+		_prev_channels.clear();
+	}
+
+	update_texture_panel();
+	for (auto const & v : _texture_panel)
+		add_view(v);
+
+	load_params();
+
+	name(fs::path{_program_fname}.filename().native());
+
+	cout << "program '" << p.fname << "' loaded" << std::endl;
+}
+
 bool shadertoy_app::reload_program()
 {
-	return load_program(_program_fname);
+	return load_program(_loaded_fname);  // project is reloaded with its channels and defines
 }
 
 bool shadertoy_app::load_shader_or_project(std::string const & fname)
 {
+	_loaded_fname = fname;
+
 	if (ends_with(fname, ".stoy"))  // project file
 	{
 		io::project_file prj;
 		if (!prj.load(fname))
 			return false;
-		_program_fname = prj.shader_program();
+		_program_fname = resolve_project_path(fname, prj.shader_program());
+		_defines = prj.defines();
 
-		if (!_prog.load(_program_fname))
-			return false;
-
-		// load textures there ...
-		for (string const & ftex : prj.program_textures())
+		// load textures there (before program, channel sizes can be part of the program) ...
+		_prog.free_textures();
+		for (string const & res : prj.program_textures())
 		{
-			_textures.push_back(
-				shared_ptr<texture2d>{new texture2d{texture_from_file(ftex)}});
+			string ftex = resolve_project_path(fname, res);
+			if (shared_ptr<channel_source> ch = make_channel_source(ftex))  // audio, video
+			{
+				_channels.push_back(ch);
+				_textures.push_back(ch->texture());
+			}
+			else
+				_textures.push_back(channel_texture_cache().from_file<texture2d>(ftex));
 
+			_textures.back()->label(ftex);
 			_prog.attach(_textures.back());
 		}
+
+		startup_trace::instance().phase("channel textures loaded");
+
+		if (!_prog.load(_program_fname, program_specialization()))
+			return false;
+	}
+	else if (ends_with(fname, ".stoyb"))  // packed project, textures are uploaded from the mapped bundle
+	{
+		prepared_program p;
+		p.prog.optimize(_opts.optimize, _opts.compile_report);
+
+		try {
+			prepare_program(fname, program_specialization(), p);
+		}
+		catch (std::runtime_error & e) {
+			cerr << "error: " << e.what() << std::endl;
+			return false;
+		}
+
+		_prog = std::move(p.prog);
+		_textures = std::move(p.textures);
+		_channels = std::move(p.channels);
+		_defines = std::move(p.defines);
+		_program_fname = fname;  // reloads the bundle
+
+		if (!p.ok)
+			return false;
 	}
 	else  // shader
 	{
 		_program_fname = fname;
+		_defines.clear();
 
 		_prog.free_textures();
-		if (!_prog.load(_program_fname))
+		if (!_prog.load(_program_fname, program_specialization()))
 			return false;
 	}
 
 	return true;
 }
 
+shadertoy_program::specialization shadertoy_app::program_specialization() const
+{
+	shadertoy_program::specialization spec;
+	spec.defines = _defines;
+
+	if (_opts.specialize)
+	{
+		spec.resolution = vec2{framebuffer_size()};
+		spec.channel_resolution = true;
+	}
+
+	return spec;
+}
+
+void shadertoy_app::bench(unsigned frames)
+{
+	shadertoy_program::specialization generic;
+	generic.defines = _defines;
+
+	shadertoy_program::specialization specialized = generic;
+	specialized.resolution = vec2{framebuffer_size()};
+	specialized.channel_resolution = true;
+
+	if (!_prog.specialize(generic))
+		return;
+	double generic_ms = render_frames(frames);
+
+	if (!_prog.specialize(specialized))
+		return;
+	double specialized_ms = render_frames(frames);
+
+	cout << "bench '" << _program_fname << "' (" << frames << " frames): "
+		<< "generic " << generic_ms << " ms/frame, specialized " << specialized_ms << " ms/frame, "
+		<< "speedup " << generic_ms / specialized_ms << "x" << std::endl;
+}
+
+bool shadertoy_app::render_sound(string const & wav, double duration)
+{
+	using clock = std::chrono::steady_clock;
+
+	sound_renderer sound;
+	if (!sound.load(_prog))
+	{
+		cerr << "error: '" << _program_fname << "' without valid mainSound() function" << std::endl;
+		return false;
+	}
+
+	clock::time_point t0 = clock::now();
+
+	wav_writer out{wav, 2, sound.sample_rate()};
+	sound.render(duration, [&out](float const * stereo, size_t frames){out.write(stereo, frames);});
+
+	std::chrono::duration<double, std::milli> dt = clock::now() - t0;
+	cout << duration << "s of sound rendered into '" << wav << "' in " << dt.count() << " ms" << std::endl;
+
+	return true;
+}
+
+void shadertoy_app::replay()
+{
+	using clock = std::chrono::steady_clock;
+
+	// render offscreen, hidden window framebuffer pixels can be skipped by driver
+	ivec2 size = _player->size();
+	glfwHideWindow(native_window());
+	glfwSetWindowSize(native_window(), size.x, size.y);
+	reshape(size.x, size.y);
+	glfwSwapInterval(0);
+
+	gles2::framebuffer fbo{unsigned(size.x), unsigned(size.y), true};
+	fbo.bind();
+
+	vector<double> frame_times;  // in ms
+	clock::time_point t0 = clock::now();
+
+	while (_player->next(_input))
+	{
+		clock::time_point frame_t0 = clock::now();
+
+		input(_input.dt);
+		update(_input.dt);
+		display();
+		glFinish();
+
+		frame_times.push_back(std::chrono::duration<double, std::milli>{clock::now() - frame_t0}.count());
+	}
+
+	std::chrono::duration<double, std::milli> total = clock::now() - t0;
+	fbo.unbind();
+
+	if (frame_times.empty())
+	{
+		cerr << "error: '" << _opts.replay << "' input trace without frames" << std::endl;
+		return;
+	}
+
+	size_t n = frame_times.size();
+	double mean = std::accumulate(frame_times.begin(), frame_times.end(), 0.0) / n;
+	std::sort(frame_times.begin(), frame_times.end());
+	auto percentile = [&frame_times, n](double p){return frame_times[std::min(n - 1, size_t(p * n))];};
+
+	cout << "replay '" << _opts.replay << "' (" << n << " frames, " << size.x << "x" << size.y << ") in "
+		<< total.count() << " ms: mean " << mean << " ms/frame, median " << percentile(0.5)
+		<< ", p95 " << percentile(0.95) << ", p99 " << percentile(0.99) << ", max " << frame_times.back()
+		<< " ms, " << 1000.0 / mean << " fps" << std::endl;
+}
+
+double shadertoy_app::render_frames(unsigned frames)
+{
+	using clock = std::chrono::steady_clock;
+
+	vec2 resolution{framebuffer_size()};
+
+	_prog.use();
+	_prog.update(0.0f, resolution, 0, vec4{0});  // warm up (driver can finish compilation on first draw)
+	_quad.render();
+	glFinish();
+
+	clock::time_point t0 = clock::now();
+
+	for (unsigned i = 0; i < frames; ++i)
+	{
+		glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+		_prog.update(i / 60.0f, resolution, i, vec4{0});
+		_quad.render();
+		glFinish();
+	}
+
+	std::chrono::duration<double, std::milli> dt = clock::now() - t0;
+	return dt.count() / std::max(frames, 1u);
+}
+
 void shadertoy_app::show_help()
 {
 	_help_v.reset(new ui::text_view);
@@ -1,7 +1,9 @@
 #pragma once
 #include <string>
-#include <chrono>
 #include <vector>
+#include <map>
+#include <memory>
+#include <future>
 #include <glm/vec2.hpp>
 #include "gl/glfw3_window.hpp"
 #include "gles2/mesh_gles2.hpp"
@@ -11,18 +13,50 @@
 #include "gles2/ui/texture_view.hpp"
 #include "gles2/ui/text.hpp"
 #include "shadertoy_program.hpp"
+#include "shader_params.hpp"
+#include "program_preloader.hpp"
+#include "playlist.hpp"
+#include "frame_sink.hpp"
+#include "shm_frame_ring.hpp"
+#include "mjpeg_server.hpp"
+#include "input_trace.hpp"
 #include "clock.hpp"
 #include "delayed_value.hpp"
 #include "key_press_event.hpp"
 
 using mesh = gles2::mesh;
 
+//! application options \sa shadertoy.cpp
+struct shadertoy_options
+{
+	bool optimize = false;  //!< optimize shader source before compilation
+	bool compile_report = false;  //!< print compilation statistics
+	bool specialize = false;  //!< bake resolution and channel sizes into the program
+	std::string playlist;  //!< playlist file or directory, playlist mode is disabled if empty
+	float dwell = 10.0f;  //!< time to show a playlist program (in s)
+	float fade = 1.0f;  //!< crossfade time between playlist programs (in s)
+	std::string output;  //!< y4m video output file or named pipe ("-" for standard output), disabled if empty
+	unsigned fps = 30;  //!< video output frame rate, frames are rendered with fixed 1/fps time step
+	unsigned frames = 0;  //!< number of video frames to write before quit, 0 for unlimited
+	std::string shm;  //!< shared memory frame ring name, disabled if empty
+	unsigned shm_slots = 3;
+	unsigned http_port = 0;  //!< MJPEG live preview server port, disabled if 0
+	float http_fps = 10.0f;  //!< live preview frame rate cap
+	std::string record;  //!< input trace file to record into, disabled if empty
+	std::string replay;  //!< input trace file to replay by replay()
+	bool startup_trace = false;  //!< print startup phase log after UI overlay is created
+	double time_offset = 0.0;  //!< iTime offset (in s)
+	double time_wrap = 0.0;  //!< iTime wrap period (in s), disabled if 0
+};
+
 class shadertoy_app : public ui::application
 {
 public:
 	using base = ui::application;
 
-	shadertoy_app(glm::ivec2 const & size, std::string const & shader_fname);
+	shadertoy_app(glm::ivec2 const & size, std::string const & shader_fname,
+		shadertoy_options const & opts = shadertoy_options{});
+	~shadertoy_app();
 	void display() override;
 	void input(float dt) override;
 	void update(float dt) override;
@@ -30,28 +64,79 @@ public:
 	bool load_program(std::string const & fname);
 	void edit_program();
 	bool reload_program();
+	void bench(unsigned frames);  //!< compares generic and specialized program frame times
+	bool render_sound(std::string const & wav, double duration);  //!< renders program mainSound() into WAV file
+
+	/*! replays recorded input trace (shadertoy_options::replay) frame by frame
+	offscreen and unthrottled, reports frame time statistics */
+	void replay();
 
 private:
 	bool load_shader_or_project(std::string const & fname);
 	void show_help();
+	shadertoy_program::specialization program_specialization() const;
+	double render_frames(unsigned frames);  //!< returns average frame time in ms
+	void create_overlay();  //!< fps, time and GPU memory labels (after the first frame is presented)
+	void update_texture_panel();
+	void update_playlist(float dt);
+	void switch_program(prepared_program & p);  //!< switches to preloaded program with crossfade
+	void capture_frame();
+	bool app_key(char k) const;  //!< application key state from the current frame input
+	void load_params();  //!< applies program parameter file values
+	void update_params_view();
 
-	std::chrono::system_clock::time_point _t0;
 	key_press_event _open_pressed, _edit_pressed, _reload_pressed,
-		_help_pressed, _pause_pressed, _next_pressed;
+		_help_pressed, _pause_pressed, _next_pressed,
+		_param_prev_pressed, _param_next_pressed, _param_dec_pressed, _param_inc_pressed,
+		_write_params_pressed;
 
-	delayed_bool _fps_label_update, _time_label_update;
+	delayed_bool _fps_label_update, _time_label_update, _outdated_check;
 
 	std::string _program_fname;
+	std::string _loaded_fname;  //!< shader, project or bundle file the program was loaded from (reloaded)
+	shadertoy_options _opts;
+	std::map<std::string, std::string> _defines;  //!< project defines
 	mesh _quad;
 	shadertoy_program _prog;
-	std::shared_ptr<ui::label> _fps_label, _time_label;
+	std::shared_ptr<ui::label> _fps_label, _time_label, _gpu_label;
 	std::shared_ptr<ui::text_view> _help_v;
+	std::future<void> _warmup;  //!< image decoders and fonts loading running in background
+	bool _overlay_pending = false;
+	bool _frame_presented = false;
 	std::vector<std::shared_ptr<ui::texture_view>> _texture_panel;
 	bool _paused;  // step mode
 	universe_clock _t;
+	int _frame;
 	int _step = 60;  // in fps
 	glm::vec2 _click_position, _mouse_position;
 
+	// input record and replay
+	frame_input _input;  //!< current frame input
+	std::unique_ptr<input_recorder> _recorder;
+	std::unique_ptr<input_player> _player;
+
+	// live parameters
+	param_file _param_file;
+	size_t _param_idx;  //!< selected parameter
+	std::shared_ptr<ui::text_view> _params_v;
+
+	// playlist mode
+	playlist _playlist;
+	std::unique_ptr<program_preloader> _preloader;
+	float _dwell_t, _fade_t;  //!< time since switch and crossfade time, negative if not fading
+	shadertoy_program _prev_prog;  //!< fading out program
+	std::vector<std::shared_ptr<gles2::texture2d>> _prev_textures;
+	std::vector<std::shared_ptr<channel_source>> _prev_channels;
+	universe_clock _prev_t;
+	int _prev_frame;
+
+	// video output
+	std::unique_ptr<frame_sink> _sink;
+	std::unique_ptr<shm::frame_writer> _shm;
+	std::unique_ptr<mjpeg_server> _http;
+	unsigned _frames_written;
+
 	// resources
 	std::vector<std::shared_ptr<gles2::texture2d>> _textures;
+	std::vector<std::shared_ptr<channel_source>> _channels;  //!< dynamic channels (audio)
 };
@@ -0,0 +1,143 @@
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include "wav_file.hpp"
+#include "audio_channel.hpp"
+
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::min;
+using std::max;
+using std::clamp;
+using gles2::texture2d;
+using gles2::pixel_format;
+using gles2::pixel_type;
+
+static unsigned const fft_size = 2 * audio_channel::texture_width;
+static float const min_db = -100.0f,  // WebAudio AnalyserNode defaults
+	max_db = -30.0f,
+	smoothing = 0.8f;
+
+audio_channel::audio_channel(string const & wav)
+	: _decoded{0}
+	, _total{0}
+	, _quit{false}
+	, _fft{fft_size}
+	, _window(fft_size)
+	, _re(fft_size)
+	, _im(fft_size)
+	, _spectrum(texture_width, 0.0f)
+	, _pixels(2 * texture_width, 0)
+	, _last_t{-1.0}
+{
+	wav_reader reader{wav};  // validates file in the caller thread
+	_sample_rate = reader.format().sample_rate;
+	_samples.resize(reader.format().frames);
+	_total = _samples.size();
+
+	for (unsigned i = 0; i < fft_size; ++i)  // Blackman window
+	{
+		double x = 2.0 * M_PI * i / fft_size;
+		_window[i] = float(0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x));
+	}
+
+	_tex = shared_ptr<texture2d>{new texture2d{texture_width, 2, pixel_format::luminance, pixel_type::ub8, _pixels.data(),
+		texture2d::parameters{}.filter(gles2::texture_filter::linear)}};
+
+	_decoder = std::thread{&audio_channel::decode, this, wav};
+}
+
+audio_channel::~audio_channel()
+{
+	_quit = true;
+	_decoder.join();
+}
+
+shared_ptr<texture2d> audio_channel::texture() const
+{
+	return _tex;
+}
+
+double audio_channel::duration() const
+{
+	return _sample_rate > 0 ? double(_total) / _sample_rate : 0.0;
+}
+
+void audio_channel::update(double t)
+{
+	if (t == _last_t || _total == 0)
+		return;
+
+	// smoothing is per update, a jump (seek, reload) resets it
+	bool seek = t < _last_t || t - _last_t > 1.0;
+	_last_t = t;
+
+	// the latest fft_size samples up to iTime
+	size_t end = min(size_t(max(t, 0.0) * _sample_rate), _total.load());
+	size_t available = wait_for(end);
+	end = min(end, available);
+
+	for (unsigned i = 0; i < fft_size; ++i)
+	{
+		ptrdiff_t idx = ptrdiff_t(end) - fft_size + i;
+		float s = idx >= 0 ? _samples[idx] : 0.0f;
+		_re[i] = s * _window[i];
+		_im[i] = 0.0f;
+
+		if (i >= fft_size - texture_width)  // waveform row
+			_pixels[texture_width + i - (fft_size - texture_width)] = uint8_t(clamp(128.0f + s * 127.0f, 0.0f, 255.0f));
+	}
+
+	_fft.transform(_re.data(), _im.data());
+
+	for (unsigned k = 0; k < texture_width; ++k)
+	{
+		float magnitude = std::sqrt(_re[k]*_re[k] + _im[k]*_im[k]) / fft_size;
+		_spectrum[k] = seek ? magnitude : smoothing * _spectrum[k] + (1.0f - smoothing) * magnitude;
+
+		float db = 20.0f * std::log10(max(_spectrum[k], 1e-12f));
+		_pixels[k] = uint8_t(clamp((db - min_db) / (max_db - min_db), 0.0f, 1.0f) * 255.0f);
+	}
+
+	_tex->write(0, 0, texture_width, 2, pixel_format::luminance, pixel_type::ub8, _pixels.data());
+}
+
+size_t audio_channel::wait_for(size_t samples)
+{
+	if (_decoded.load() >= samples)
+		return _decoded.load();
+
+	unique_lock<mutex> lock{_lock};
+	_cond.wait(lock, [this, samples]{return _decoded.load() >= samples || _decoded.load() == _total.load();});
+	return _decoded.load();
+}
+
+void audio_channel::decode(string const & wav)
+{
+	size_t const block = 16384;
+
+	try {
+		wav_reader reader{wav};
+		while (!_quit && _decoded < _total)
+		{
+			size_t n = reader.read(_samples.data() + _decoded, min(block, _total - _decoded));
+			if (n == 0)  // truncated file
+				break;
+
+			lock_guard<mutex> lock{_lock};
+			_decoded += n;
+			_cond.notify_all();
+		}
+	}
+	catch (std::exception & e) {
+		std::cerr << "error: unable to decode '" << wav << "', what: " << e.what() << std::endl;
+	}
+
+	lock_guard<mutex> lock{_lock};
+	_total = _decoded.load();  // unblocks waiting update() after failure
+	_cond.notify_all();
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "channel_source.hpp"
+#include "fft.hpp"
+
+/*! Shadertoy music channel (512x2 luminance texture).
+
+The first row is a spectrum (Blackman windowed FFT, magnitudes mapped from
+<-100, -30> dB range as WebAudio analyser does), the second row is
+a waveform. WAV file is decoded in a background thread, texture content
+is computed from samples at iTime (sample accurate, so offline export is
+deterministic) and written with glTexSubImage2D().
+\code
+# project file
+music.glsl
+song.wav
+\endcode */
+class audio_channel : public channel_source
+{
+public:
+	static unsigned const texture_width = 512;
+
+	audio_channel(std::string const & wav);  //!< throws std::runtime_error for unsupported file
+	~audio_channel() override;
+	std::shared_ptr<gles2::texture2d> texture() const override;
+	void update(double t) override;
+	double duration() const;  //!< in s
+
+private:
+	void decode(std::string const & wav);
+	size_t wait_for(size_t samples);  //!< waits until samples are decoded, returns number of available samples
+
+	std::shared_ptr<gles2::texture2d> _tex;
+	unsigned _sample_rate;
+	std::vector<float> _samples;  //!< mono, allocated for the whole file
+	std::atomic<size_t> _decoded;
+	std::atomic<size_t> _total;  //!< number of samples, less than _samples size for corrupted file
+	std::atomic<bool> _quit;
+	std::mutex _lock;
+	std::condition_variable _cond;
+	std::thread _decoder;
+
+	fft _fft;
+	std::vector<float> _window;
+	std::vector<float> _re, _im;
+	std::vector<float> _spectrum;  //!< smoothed magnitudes
+	std::vector<uint8_t> _pixels;
+	double _last_t;
+};
@@ -0,0 +1,151 @@
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include "headless_context.hpp"
+#include "shadertoy_program.hpp"
+#include "project_file.hpp"
+#include "utility.hpp"
+#include "batch_compile.hpp"
+
+using std::string;
+using std::vector;
+using std::unique_ptr;
+using std::thread;
+using std::atomic;
+using std::min;
+using std::max;
+using boost::algorithm::ends_with;
+namespace fs = boost::filesystem;
+
+struct compile_result
+{
+	string fname;
+	bool ok = false;
+	string log;
+	shadertoy_program::compile_stats stats;
+};
+
+static vector<string> shader_files(string const & dir);
+static compile_result compile_file(string const & fname);
+
+unsigned compile_directory(string const & dir, unsigned jobs, std::ostream & out)
+{
+	using clock = std::chrono::steady_clock;
+
+	vector<string> files = shader_files(dir);
+	jobs = max(1u, min(jobs, (unsigned)files.size()));
+
+	if (!glfwInit())
+		throw std::runtime_error{"unable to initialize GLFW"};
+
+	vector<unique_ptr<headless_context>> contexts;  // created in main thread
+	for (unsigned i = 0; i < jobs; ++i)
+		contexts.emplace_back(new headless_context{});
+
+	clock::time_point t0 = clock::now();
+
+	vector<compile_result> results(files.size());
+	atomic<size_t> next{0};
+
+	vector<thread> workers;
+	for (auto & ctx : contexts)
+	{
+		headless_context * c = ctx.get();
+		workers.emplace_back([c, &files, &results, &next]{
+			c->make_current();
+			for (size_t i = next++; i < files.size(); i = next++)
+				results[i] = compile_file(files[i]);
+			c->release();
+		});
+	}
+
+	for (thread & w : workers)
+		w.join();
+
+	std::chrono::duration<double, std::milli> total = clock::now() - t0;
+
+	contexts.clear();
+	glfwTerminate();
+
+	unsigned failed = count_if(results.begin(), results.end(), [](compile_result const & r){return !r.ok;});
+
+	// report
+	out << "{\n"
+		<< "  \"directory\": " << json_quote(dir) << ",\n"
+		<< "  \"jobs\": " << jobs << ",\n"
+		<< "  \"total_time_ms\": " << total.count() << ",\n"
+		<< "  \"passed\": " << results.size() - failed << ",\n"
+		<< "  \"failed\": " << failed << ",\n"
+		<< "  \"results\": [";
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		compile_result const & r = results[i];
+		out << (i > 0 ? "," : "") << "\n    {"
+			<< "\"file\": " << json_quote(r.fname) << ", "
+			<< "\"status\": " << (r.ok ? "\"ok\"" : "\"error\"") << ", "
+			<< "\"compile_time_ms\": " << r.stats.compile_time << ", "
+			<< "\"link_time_ms\": " << r.stats.link_time << ", "
+			<< "\"source_size\": " << r.stats.source_size << ", "
+			<< "\"log\": " << json_quote(r.log) << "}";
+	}
+
+	out << "\n  ]\n}" << std::endl;
+
+	return failed;
+}
+
+vector<string> shader_files(string const & dir)
+{
+	vector<string> result;
+	for (fs::directory_iterator it{dir}; it != fs::directory_iterator{}; ++it)
+	{
+		string fname = it->path().string();
+		if (fs::is_regular_file(it->path()) && (ends_with(fname, ".glsl") || ends_with(fname, ".stoy")))
+			result.push_back(fname);
+	}
+
+	sort(result.begin(), result.end());
+	return result;
+}
+
+compile_result compile_file(string const & fname)
+{
+	compile_result result;
+	result.fname = fname;
+
+	string shader = fname;
+	shadertoy_program::specialization spec;
+
+	if (ends_with(fname, ".stoy"))
+	{
+		io::project_file prj;
+		try {
+			if (!prj.load(fname))
+			{
+				result.log = "project file without shader program";
+				return result;
+			}
+		}
+		catch (std::runtime_error & e) {
+			result.log = e.what();
+			return result;
+		}
+
+		shader = resolve_project_path(fname, prj.shader_program());
+		spec.defines = prj.defines();
+	}
+
+	shadertoy_program prog;
+	result.ok = prog.load(shader, spec);
+	result.log = prog.error_log();
+	result.stats = prog.stats();
+
+	return result;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <string>
+#include <ostream>
+
+/*! Compiles and links all shader programs (*.glsl) and projects (*.stoy) in
+dir on jobs worker threads, each with its own headless context. Per file
+status, error log (with corrected line numbers) and compile/link times are
+written to out as JSON.
+\returns number of programs failed to compile */
+unsigned compile_directory(std::string const & dir, unsigned jobs, std::ostream & out);
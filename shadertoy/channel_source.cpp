@@ -0,0 +1,23 @@
+#include <boost/algorithm/string/predicate.hpp>
+#include "audio_channel.hpp"
+#include "video_channel.hpp"
+#include "channel_source.hpp"
+
+using std::string;
+using std::shared_ptr;
+using boost::algorithm::iends_with;
+
+shared_ptr<channel_source> make_channel_source(string const & fname)
+{
+	if (iends_with(fname, ".wav"))
+		return shared_ptr<channel_source>{new audio_channel{fname}};
+	else if (iends_with(fname, ".y4m") || fname.find('%') != string::npos)
+		return shared_ptr<channel_source>{new video_channel{fname}};
+	else
+		return nullptr;
+}
+
+bool is_channel_source(string const & fname)
+{
+	return iends_with(fname, ".wav") || iends_with(fname, ".y4m") || fname.find('%') != string::npos;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include <memory>
+#include "gles2/texture_gles2.hpp"
+
+/*! Dynamic iChannel input (texture content changes in time).
+\note Texture is created in the constructor and updated in update(), both
+need to be called with a GL context current. */
+class channel_source
+{
+public:
+	virtual ~channel_source() {}
+	virtual std::shared_ptr<gles2::texture2d> texture() const = 0;
+	virtual void update(double t) = 0;  //!< updates texture for iTime value t
+};
+
+/*! creates channel source for dynamic (audio, video) project resources based on file
+extension (or image sequence pattern), returns nullptr for still images (\sa gles2::texture_from_file()) */
+std::shared_ptr<channel_source> make_channel_source(std::string const & fname);
+
+//! true if fname is a dynamic (audio, video) resource \sa make_channel_source()
+bool is_channel_source(std::string const & fname);
@@ -1,42 +1,108 @@
 #include <cmath>
 #include "clock.hpp"
 
-using std::ceil;
+using std::fmod;
+using std::chrono::duration;
+using std::chrono::duration_cast;
 
 universe_clock::universe_clock()
-	: _now{0.0f}
+	: _now{0.0}
+	, _base{0.0}
+	, _frames{0}
+	, _num{0.0}
+	, _den{1}
+	, _offset{0.0}
+	, _wrap{0.0}
 {
 	reset();
 }
 
 float universe_clock::now() const
+{
+	return itime();
+}
+
+double universe_clock::seconds() const
 {
 	return _now;
 }
 
 float universe_clock::next()
 {
-	std::chrono::duration<double> dt = std::chrono::system_clock::now() - _t0;
-	_now = (float)(dt.count());
-	return _now;
+	_now = duration<double>{clock::now() - _t0}.count();
+	_frames = 0;  // fixed steps continue from the real time
+	_base = _now;
+	return itime();
 }
 
-float universe_clock::next(float step)
+float universe_clock::next(double step)
 {
-	_now += step;
-	return _now;
+	step_base(step, 1);
+	_now = _base + _frames * _num;
+	return itime();
 }
 
+float universe_clock::next(unsigned num, unsigned den)
+{
+	step_base(num, den);
+	_now = _base + (_frames * _num) / _den;
+	return itime();
+}
 
 void universe_clock::resume()
 {
-	auto offset = std::chrono::milliseconds{static_cast<unsigned>(
-		ceil(_now * 1000.0f))};
-
-	_t0 = std::chrono::system_clock::now() - offset;
+	_t0 = clock::now() - duration_cast<clock::duration>(duration<double>{_now});
+	_frames = 0;
+	_base = _now;
 }
 
 void universe_clock::reset()
 {
-	_t0 = std::chrono::system_clock::now();
+	_t0 = clock::now();
+	_now = _base = 0.0;
+	_frames = 0;
+}
+
+void universe_clock::offset(double t)
+{
+	_offset = t;
+}
+
+void universe_clock::wrap(double period)
+{
+	_wrap = period;
+}
+
+double universe_clock::offset() const
+{
+	return _offset;
+}
+
+double universe_clock::wrap() const
+{
+	return _wrap;
+}
+
+float universe_clock::itime() const
+{
+	double t = _now + _offset;
+	if (_wrap > 0.0)
+	{
+		t = fmod(t, _wrap);
+		if (t < 0.0)
+			t += _wrap;
+	}
+	return (float)t;
+}
+
+void universe_clock::step_base(double num, unsigned den)
+{
+	if (num != _num || den != _den)  // step changed, count frames from the current time
+	{
+		_base = _now;
+		_frames = 0;
+		_num = num;
+		_den = den;
+	}
+	++_frames;
 }
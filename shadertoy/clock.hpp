@@ -1,17 +1,54 @@
 #pragma once
 #include <chrono>
+#include <cstdint>
 
+/*! Program (universe) time.
+
+Time is measured by monotonic steady_clock (system time adjustments don't
+affect it) and kept in double precision, fixed steps are counted as whole
+frames of a rational step num/den, so the time doesn't drift even after
+days of running.
+
+iTime value returned by now() and next() is converted to float after
+an offset is added and wrapped by a period, use wrap() to keep iTime
+precise on long running displays.
+
+\code
+universe_clock t;
+t.wrap(3600.0);  // iTime in [0, 1h)
+float itime = t.next();  // real time
+float frame_itime = t.next(1, 30);  // 1/30 s step
+\endcode */
 class universe_clock
 {
 public:
+	using clock = std::chrono::steady_clock;
+
 	universe_clock();
-	float now() const;
-	float next();
-	float next(float step);
-	void resume();
+	float now() const;  //!< iTime
+	double seconds() const;  //!< time since reset (or resume) in s without offset and wrap
+	float next();  //!< real time step
+	float next(double step);  //!< fixed step in s
+	float next(unsigned num, unsigned den);  //!< exact fixed step num/den s (e.g. 1/fps)
+	void resume();  //!< continues real time from the current time (after pause or fixed steps)
 	void reset();
+	void offset(double t);  //!< added to time before conversion to iTime
+	void wrap(double period);  //!< iTime wraps to [0, period) for period > 0
+	double offset() const;
+	double wrap() const;
 
 private:
-	float _now;
-	std::chrono::system_clock::time_point _t0;
+	float itime() const;
+	void step_base(double num, unsigned den);
+
+	double _now;  //!< in s
+	clock::time_point _t0;
+
+	// fixed steps, time is _base + _frames*_num/_den
+	double _base;
+	std::int64_t _frames;
+	double _num;
+	unsigned _den;
+
+	double _offset, _wrap;
 };
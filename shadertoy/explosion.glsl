@@ -1,7 +1,7 @@
 // kaboom tinyraytracer tutorial shader
 
-const float noise_amplitude = 1.0;
-const float explosion_velocity = 0.7;
+const float noise_amplitude = 1.0;  // @param 0.0 2.0 0.05
+const float explosion_velocity = 0.7;  // @param 0.0 2.0 0.05
 
 float hash(in float n)
 {
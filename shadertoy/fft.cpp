@@ -0,0 +1,98 @@
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include "fft.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define HAVE_SSE_KERNEL
+	#include <xmmintrin.h>
+#endif
+
+using std::swap;
+
+fft::fft(unsigned n)
+	: _n{n}
+{
+	if (n < 2 || (n & (n - 1)))
+		throw std::invalid_argument{"FFT size needs to be power of 2"};
+
+	unsigned bits = 0;
+	while ((1u << bits) < n)
+		++bits;
+
+	_reversed.resize(n);
+	for (unsigned i = 0; i < n; ++i)
+	{
+		unsigned r = 0;
+		for (unsigned b = 0; b < bits; ++b)
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+		_reversed[i] = r;
+	}
+
+	// w_k = exp(-i*pi*k/h) for k < h, stored contiguously per stage
+	_cos.resize(n - 1);
+	_sin.resize(n - 1);
+	for (unsigned h = 1; h < n; h *= 2)
+	{
+		for (unsigned k = 0; k < h; ++k)
+		{
+			double a = -M_PI * k / h;
+			_cos[h - 1 + k] = float(std::cos(a));
+			_sin[h - 1 + k] = float(std::sin(a));
+		}
+	}
+}
+
+void fft::transform(float * re, float * im) const
+{
+	for (unsigned i = 0; i < _n; ++i)
+	{
+		unsigned j = _reversed[i];
+		if (i < j)
+		{
+			swap(re[i], re[j]);
+			swap(im[i], im[j]);
+		}
+	}
+
+	for (unsigned h = 1; h < _n; h *= 2)  // butterfly half size
+	{
+		float const * wr = _cos.data() + h - 1,
+			* wi = _sin.data() + h - 1;
+
+		for (unsigned g = 0; g < _n; g += 2*h)  // butterfly group
+		{
+			float * ar = re + g, * ai = im + g,
+				* br = re + g + h, * bi = im + g + h;
+
+			unsigned k = 0;
+#if defined(HAVE_SSE_KERNEL)
+			for (; k + 4 <= h; k += 4)
+			{
+				__m128 c = _mm_loadu_ps(wr + k), s = _mm_loadu_ps(wi + k),
+					xr = _mm_loadu_ps(br + k), xi = _mm_loadu_ps(bi + k),
+					yr = _mm_loadu_ps(ar + k), yi = _mm_loadu_ps(ai + k);
+
+				// t = b*w
+				__m128 tr = _mm_sub_ps(_mm_mul_ps(xr, c), _mm_mul_ps(xi, s)),
+					ti = _mm_add_ps(_mm_mul_ps(xr, s), _mm_mul_ps(xi, c));
+
+				_mm_storeu_ps(ar + k, _mm_add_ps(yr, tr));
+				_mm_storeu_ps(ai + k, _mm_add_ps(yi, ti));
+				_mm_storeu_ps(br + k, _mm_sub_ps(yr, tr));
+				_mm_storeu_ps(bi + k, _mm_sub_ps(yi, ti));
+			}
+#endif
+			for (; k < h; ++k)
+			{
+				float tr = br[k]*wr[k] - bi[k]*wi[k],
+					ti = br[k]*wi[k] + bi[k]*wr[k];
+
+				br[k] = ar[k] - tr;
+				bi[k] = ai[k] - ti;
+				ar[k] += tr;
+				ai[k] += ti;
+			}
+		}
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+
+/*! In place radix-2 complex FFT with split (real, imaginary) arrays.
+
+Butterflies are computed four at a time with SSE (scalar fallback for
+other architectures and the first two stages).
+\code
+fft f{1024};
+f.transform(re.data(), im.data());  // forward transform
+\endcode */
+class fft
+{
+public:
+	explicit fft(unsigned n);  //!< n needs to be power of 2
+	void transform(float * re, float * im) const;
+	unsigned size() const {return _n;}
+
+private:
+	unsigned _n;
+	std::vector<unsigned> _reversed;  //!< bit reversal permutation
+	std::vector<float> _cos, _sin;  //!< twiddles for each stage (stage with half size h starts at h-1)
+};
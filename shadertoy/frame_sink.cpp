@@ -0,0 +1,86 @@
+#include "gl/opengl.hpp"
+#include "frame_sink.hpp"
+
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+
+video_frame read_frame(unsigned width, unsigned height)
+{
+	video_frame result;
+	result.width = width;
+	result.height = height;
+	result.pixels.resize(width * height * 4);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, result.pixels.data());
+
+	return result;
+}
+
+frame_sink::frame_sink(size_t queue_size)
+	: _queue_size{queue_size}
+	, _quit{false}
+	, _failed{false}
+{
+	_worker = std::thread{&frame_sink::loop, this};
+}
+
+frame_sink::~frame_sink()
+{
+	stop();
+}
+
+bool frame_sink::write(video_frame && frame)
+{
+	unique_lock<mutex> lock{_lock};
+	_not_full.wait(lock, [this]{return _frames.size() < _queue_size || _failed;});
+	if (_failed)
+		return false;
+
+	_frames.push_back(std::move(frame));
+	_not_empty.notify_one();
+	return true;
+}
+
+bool frame_sink::failed() const
+{
+	lock_guard<mutex> lock{_lock};
+	return _failed;
+}
+
+void frame_sink::stop()
+{
+	{
+		lock_guard<mutex> lock{_lock};
+		_quit = true;
+	}
+	_not_empty.notify_one();
+
+	if (_worker.joinable())
+		_worker.join();
+}
+
+void frame_sink::loop()
+{
+	while (true)
+	{
+		video_frame frame;
+
+		{
+			unique_lock<mutex> lock{_lock};
+			_not_empty.wait(lock, [this]{return !_frames.empty() || _quit;});
+			if (_frames.empty() || _failed)  // quit
+				break;
+
+			frame = std::move(_frames.front());
+			_frames.pop_front();
+		}
+
+		bool ok = consume(frame);
+
+		lock_guard<mutex> lock{_lock};
+		_failed = !ok;
+		_not_full.notify_one();
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//! RGBA frame with bottom-up rows (glReadPixels() layout)
+struct video_frame
+{
+	unsigned width = 0,
+		height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+//! reads current framebuffer (w x h area from bottom-left corner)
+video_frame read_frame(unsigned width, unsigned height);
+
+/*! Rendered frames consumer running in a worker thread.
+
+Frames are passed through a bounded queue, write() blocks while the queue
+is full so a slow consumer throttles the renderer (back-pressure) instead
+of growing memory.
+\note Derived class needs to call stop() in its destructor, before its
+members are destroyed (consume() can be running in the worker thread). */
+class frame_sink
+{
+public:
+	frame_sink(size_t queue_size = 4);
+	virtual ~frame_sink();
+	bool write(video_frame && frame);  //!< returns false if sink failed (e.g. closed pipe)
+	bool failed() const;
+
+	frame_sink(frame_sink const &) = delete;
+	void operator=(frame_sink const &) = delete;
+
+protected:
+	virtual bool consume(video_frame const & frame) = 0;  //!< called from worker thread, returns false on error
+	void stop();  //!< waits for queued frames and stops worker thread
+
+private:
+	void loop();
+
+	std::deque<video_frame> _frames;
+	size_t _queue_size;
+	bool _quit, _failed;
+	mutable std::mutex _lock;
+	std::condition_variable _not_empty, _not_full;
+	std::thread _worker;
+};
@@ -0,0 +1,515 @@
+#include <set>
+#include <vector>
+#include <regex>
+#include <cmath>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include "glsl_optimizer.hpp"
+
+using std::string;
+using std::vector;
+using std::set;
+using std::regex;
+using std::sregex_iterator;
+
+namespace detail {
+
+enum class token_type
+{
+	identifier,
+	number,
+	punct,
+	directive,  //!< whole preprocessor line without the trailing newline
+	newline
+};
+
+struct token
+{
+	token_type type;
+	string text;
+};
+
+enum class item_kind
+{
+	other,  //!< can't be removed (directives, interface variables, structs, ...)
+	function,
+	prototype,
+	variable
+};
+
+//! top level item (function definition, declaration, directive, ...) as [first, last) tokens range
+struct item
+{
+	size_t first, last;
+	item_kind kind;
+	string name;
+};
+
+static vector<token> tokenize(string const & s);
+static vector<item> split_items(vector<token> const & toks);
+static item classify(vector<token> const & toks, size_t first, size_t last, bool function);
+static unsigned fold_constants(vector<token> & toks);
+static string join(vector<token> const & toks);
+static bool is_word_char(char c);
+
+}  // detail
+
+using namespace detail;
+
+string optimize_glsl(string const & source, glsl_optimizer_stats * stats)
+{
+	vector<token> toks = tokenize(source);
+	vector<item> items = split_items(toks);
+
+	// find live names, main() and everything referenced by not removable items are roots
+	set<string> live{"main"};
+
+	auto reference = [&toks, &live](item const & it) {
+		static regex const word_pat{R"([A-Za-z_]\w*)"};
+		for (size_t i = it.first; i < it.last; ++i)
+		{
+			token const & tk = toks[i];
+			if (tk.type == token_type::identifier)
+				live.insert(tk.text);
+			else if (tk.type == token_type::directive)
+			{
+				for (sregex_iterator w{tk.text.begin(), tk.text.end(), word_pat}; w != sregex_iterator{}; ++w)
+					live.insert(w->str());
+			}
+		}
+	};
+
+	for (item const & it : items)
+		if (it.kind == item_kind::other)
+			reference(it);
+
+	vector<bool> referenced(items.size(), false);
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (size_t i = 0; i < items.size(); ++i)
+		{
+			item const & it = items[i];
+			if (it.kind != item_kind::other && !referenced[i] && live.count(it.name))
+			{
+				referenced[i] = true;
+				reference(it);
+				changed = true;
+			}
+		}
+	}
+
+	// remove unreferenced items (only line structure is kept)
+	glsl_optimizer_stats result;
+	vector<token> optimized;
+	optimized.reserve(toks.size());
+
+	for (item const & it : items)
+	{
+		bool removed = it.kind != item_kind::other && !live.count(it.name);
+		if (removed)
+		{
+			if (it.kind == item_kind::function)
+				++result.removed_functions;
+			else if (it.kind == item_kind::variable)
+				++result.removed_globals;
+		}
+
+		for (size_t i = it.first; i < it.last; ++i)
+			if (!removed || toks[i].type == token_type::newline)
+				optimized.push_back(toks[i]);
+	}
+
+	result.folded_constants = fold_constants(optimized);
+
+	string code = join(optimized);
+
+	result.source_size = source.size();
+	result.optimized_size = code.size();
+	if (stats)
+		*stats = result;
+
+	return code;
+}
+
+namespace detail {
+
+vector<token> tokenize(string const & s)
+{
+	static char const * two_char_ops[] = {"++", "--", "+=", "-=", "*=", "/=", "%=", "<<", ">>",
+		"<=", ">=", "==", "!=", "&&", "||", "^^", "&=", "|=", "^="};
+
+	vector<token> result;
+	size_t n = s.size();
+	bool line_start = true;
+
+	for (size_t i = 0; i < n;)
+	{
+		char c = s[i];
+		char next = i+1 < n ? s[i+1] : '\0';
+
+		if (c == '\n')
+		{
+			result.push_back(token{token_type::newline, "\n"});
+			line_start = true;
+			++i;
+		}
+		else if (isspace(c))
+			++i;
+		else if (c == '/' && next == '/')  // line comment
+		{
+			while (i < n && s[i] != '\n')
+				++i;
+		}
+		else if (c == '/' && next == '*')  // block comment
+		{
+			for (i += 2; i < n && !(s[i] == '*' && i+1 < n && s[i+1] == '/'); ++i)
+			{
+				if (s[i] == '\n')
+				{
+					result.push_back(token{token_type::newline, "\n"});
+					line_start = true;
+				}
+			}
+			i += 2;
+		}
+		else if (c == '#' && line_start)  // directive up to the end of line (line continuations are kept)
+		{
+			string text;
+			unsigned comment_lines = 0;  // newlines inside block comments, emitted after the directive
+			while (i < n && !(s[i] == '\n' && (text.empty() || text.back() != '\\')))
+			{
+				if (s[i] == '/' && i+1 < n && s[i+1] == '/')
+				{
+					while (i < n && s[i] != '\n')
+						++i;
+				}
+				else if (s[i] == '/' && i+1 < n && s[i+1] == '*')
+				{
+					text += ' ';  // GLSL ES has no line continuation, directive stays on one line
+					for (i += 2; i < n && !(s[i] == '*' && i+1 < n && s[i+1] == '/'); ++i)
+						if (s[i] == '\n')
+							++comment_lines;
+					i += 2;
+				}
+				else
+					text += s[i++];
+			}
+
+			while (!text.empty() && isspace(text.back()))
+				text.pop_back();
+
+			result.push_back(token{token_type::directive, text});
+			for (; comment_lines > 0; --comment_lines)  // keeps line numbers
+				result.push_back(token{token_type::newline, "\n"});
+			line_start = false;
+		}
+		else
+		{
+			line_start = false;
+			size_t first = i;
+
+			if (isalpha(c) || c == '_')
+			{
+				while (i < n && is_word_char(s[i]))
+					++i;
+				result.push_back(token{token_type::identifier, s.substr(first, i - first)});
+			}
+			else if (isdigit(c) || (c == '.' && isdigit(next)))
+			{
+				bool hex = c == '0' && (next == 'x' || next == 'X');
+				while (i < n)
+				{
+					char d = s[i];
+					if (isalnum(d) || d == '.')
+						++i;
+					else if ((d == '+' || d == '-') && !hex && (s[i-1] == 'e' || s[i-1] == 'E'))  // exponent sign
+						++i;
+					else
+						break;
+				}
+				result.push_back(token{token_type::number, s.substr(first, i - first)});
+			}
+			else
+			{
+				string op{c};
+				for (char const * two : two_char_ops)
+				{
+					if (two[0] == c && two[1] == next)
+					{
+						op = two;
+						break;
+					}
+				}
+
+				i += op.size();
+				result.push_back(token{token_type::punct, op});
+			}
+		}
+	}
+
+	return result;
+}
+
+vector<item> split_items(vector<token> const & toks)
+{
+	vector<item> result;
+
+	for (size_t i = 0; i < toks.size();)
+	{
+		if (toks[i].type == token_type::newline || toks[i].type == token_type::directive)
+		{
+			result.push_back(item{i, i+1, item_kind::other, string{}});
+			++i;
+			continue;
+		}
+
+		size_t first = i;
+		int paren = 0, brace = 0;
+		bool function = false;
+		string prev;  // previous significant token
+
+		for (; i < toks.size(); ++i)
+		{
+			token const & tk = toks[i];
+			if (tk.type == token_type::newline || tk.type == token_type::directive)
+				continue;
+
+			if (tk.type == token_type::punct)
+			{
+				if (tk.text == "(")
+					++paren;
+				else if (tk.text == ")")
+					--paren;
+				else if (tk.text == "{")
+				{
+					if (brace == 0 && paren == 0 && prev == ")")
+						function = true;
+					++brace;
+				}
+				else if (tk.text == "}")
+				{
+					if (--brace == 0 && function)
+					{
+						++i;
+						break;
+					}
+				}
+				else if (tk.text == ";" && brace == 0 && paren == 0)
+				{
+					++i;
+					break;
+				}
+			}
+
+			prev = tk.text;
+		}
+
+		result.push_back(classify(toks, first, i, function));
+	}
+
+	return result;
+}
+
+item classify(vector<token> const & toks, size_t first, size_t last, bool function)
+{
+	static set<string> const interface_keywords{"uniform", "attribute", "varying", "precision", "invariant", "struct"};
+
+	item result{first, last, item_kind::other, string{}};
+
+	vector<token const *> sig;  // significant tokens
+	for (size_t i = first; i < last; ++i)
+	{
+		if (toks[i].type == token_type::directive)  // conditional code, keep it
+			return result;
+
+		if (toks[i].type != token_type::newline)
+			sig.push_back(&toks[i]);
+	}
+
+	if (sig.empty() || interface_keywords.count(sig[0]->text))
+		return result;
+
+	// first '(', '=' and ',' on the top level
+	size_t paren_idx = sig.size(), assign_idx = sig.size(), comma_idx = sig.size(), bracket_idx = sig.size();
+	int depth = 0;
+	for (size_t i = 0; i < sig.size(); ++i)
+	{
+		string const & t = sig[i]->text;
+		if (depth == 0)
+		{
+			if (t == "(" && paren_idx == sig.size())
+				paren_idx = i;
+			else if (t == "=" && assign_idx == sig.size())
+				assign_idx = i;
+			else if (t == "," && comma_idx == sig.size())
+				comma_idx = i;
+			else if (t == "[" && bracket_idx == sig.size())
+				bracket_idx = i;
+			else if (t == "{" && !function)  // not a function and not a simple declaration
+				return result;
+		}
+
+		if (t == "(" || t == "[" || t == "{")
+			++depth;
+		else if (t == ")" || t == "]" || t == "}")
+			--depth;
+	}
+
+	if (function || (paren_idx < assign_idx && paren_idx < sig.size()))  // function definition or prototype
+	{
+		if (paren_idx == 0 || paren_idx == sig.size() || sig[paren_idx-1]->type != token_type::identifier)
+			return result;
+
+		result.kind = function ? item_kind::function : item_kind::prototype;
+		result.name = sig[paren_idx-1]->text;
+		return result;
+	}
+
+	if (comma_idx < sig.size() || sig.back()->text != ";")  // more declarators
+		return result;
+
+	size_t name_end = std::min(std::min(assign_idx, bracket_idx), sig.size() - 1);
+	if (name_end < 2 || sig[name_end-1]->type != token_type::identifier)  // expects at least type and name
+		return result;
+
+	result.kind = item_kind::variable;
+	result.name = sig[name_end-1]->text;
+	return result;
+}
+
+static bool is_int_literal(string const & s)
+{
+	static regex const pat{R"(0|[1-9][0-9]*)"};
+	return regex_match(s, pat);
+}
+
+static bool is_float_literal(string const & s)
+{
+	static regex const pat{R"((\d+\.\d*|\.\d+)([eE][+-]?\d+)?|\d+[eE][+-]?\d+)"};
+	return regex_match(s, pat);
+}
+
+static string float_to_literal(float v)
+{
+	char buf[32];
+	snprintf(buf, sizeof buf, "%.9g", v);
+	string result{buf};
+	if (result.find_first_of(".e") == string::npos)
+		result += ".0";
+	return result;
+}
+
+//! evaluates `a op b` literals expression, returns empty string if it can't be folded
+static string evaluate(string const & a, string const & op, string const & b)
+{
+	if (is_float_literal(a) && is_float_literal(b))
+	{
+		float x = strtof(a.c_str(), nullptr), y = strtof(b.c_str(), nullptr), r;
+		if (op == "+") r = x + y;
+		else if (op == "-") r = x - y;
+		else if (op == "*") r = x * y;
+		else if (op == "/" && y != 0.0f) r = x / y;
+		else return string{};
+
+		return (std::isfinite(r) && r >= 0.0f) ? float_to_literal(r) : string{};
+	}
+	else if (is_int_literal(a) && is_int_literal(b))
+	{
+		long long x = strtoll(a.c_str(), nullptr, 10), y = strtoll(b.c_str(), nullptr, 10), r;
+		if (op == "+") r = x + y;
+		else if (op == "-") r = x - y;
+		else if (op == "*") r = x * y;
+		else if (op == "/" && y != 0) r = x / y;
+		else return string{};
+
+		return (r >= 0 && r <= INT_MAX) ? std::to_string(r) : string{};
+	}
+	else
+		return string{};
+}
+
+unsigned fold_constants(vector<token> & toks)
+{
+	unsigned count = 0;
+
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (size_t i = 0; i + 4 < toks.size(); ++i)
+		{
+			// (number op number)
+			if (toks[i].text != "(" || toks[i+1].type != token_type::number || toks[i+2].type != token_type::punct
+				|| toks[i+3].type != token_type::number || toks[i+4].text != ")")
+			{
+				continue;
+			}
+
+			string value = evaluate(toks[i+1].text, toks[i+2].text, toks[i+3].text);
+			if (value.empty())
+				continue;
+
+			toks[i+1].text = value;
+			toks.erase(toks.begin() + i + 2, toks.begin() + i + 4);  // now (value)
+
+			// remove grouping parentheses (not function call or constructor ones)
+			bool call = i > 0 && (toks[i-1].type == token_type::identifier || toks[i-1].text == ")" || toks[i-1].text == "]");
+			bool member = i + 3 < toks.size() && (toks[i+3].text == "." || toks[i+3].text == "[");
+			if (!call && !member)
+			{
+				toks.erase(toks.begin() + i + 2);
+				toks.erase(toks.begin() + i);
+			}
+
+			++count;
+			changed = true;
+		}
+	}
+
+	return count;
+}
+
+string join(vector<token> const & toks)
+{
+	static char const * merging_ops[] = {"++", "--", "+=", "-=", "*=", "/=", "%=", "<<", ">>",
+		"<=", ">=", "==", "!=", "&&", "||", "^^", "&=", "|=", "^=", "//", "/*"};
+
+	string result;
+	token const * prev = nullptr;
+
+	for (token const & tk : toks)
+	{
+		if (tk.type == token_type::newline)
+		{
+			result += '\n';
+			prev = nullptr;
+			continue;
+		}
+
+		if (prev)
+		{
+			char a = prev->text.back(), b = tk.text.front();
+			bool space = is_word_char(a) && is_word_char(b);
+			for (char const * op : merging_ops)
+				if (op[0] == a && op[1] == b)
+					space = true;
+
+			if (space)
+				result += ' ';
+		}
+
+		result += tk.text;
+		prev = &tk;
+	}
+
+	return result;
+}
+
+bool is_word_char(char c)
+{
+	return isalnum(c) || c == '_';
+}
+
+}  // detail
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+
+struct glsl_optimizer_stats
+{
+	size_t source_size = 0,  //!< in bytes
+		optimized_size = 0;
+	unsigned removed_functions = 0,
+		removed_globals = 0,
+		folded_constants = 0;
+};
+
+/*! Source level GLSL ES 1.0 optimizer.
+
+Removes comments and redundant white-spaces, functions not reachable from
+main() (including prototypes), unused global (non interface) variables and
+folds parenthesized constant expressions like `(2.0*3.14)`.
+
+\note Line structure is preserved (removed code is replaced by empty lines),
+so compile log line numbers are valid for the original source.
+
+\code
+glsl_optimizer_stats stats;
+string code = optimize_glsl(read_file("explosion.glsl"), &stats);
+\endcode */
+std::string optimize_glsl(std::string const & source, glsl_optimizer_stats * stats = nullptr);
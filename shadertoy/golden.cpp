@@ -0,0 +1,282 @@
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <Magick++.h>
+#include <boost/filesystem/operations.hpp>
+#include <glm/vec4.hpp>
+#include "gl/shapes.hpp"
+#include "gles2/mesh_gles2.hpp"
+#include "gles2/framebuffer_gles2.hpp"
+#include "headless_context.hpp"
+#include "program_preloader.hpp"
+#include "playlist.hpp"
+#include "image_diff.hpp"
+#include "utility.hpp"
+#include "golden.hpp"
+
+using std::string;
+using std::vector;
+using std::thread;
+using std::atomic;
+using std::ostringstream;
+using std::min;
+using std::max;
+using glm::vec2;
+using glm::ivec2;
+using glm::vec4;
+using gl::make_quad_xy;
+using gles2::framebuffer;
+namespace fs = boost::filesystem;
+
+struct golden_case
+{
+	string fname;  //!< shader or project file
+	float time;
+	string name;  //!< PATH@TIME (path relative to the checked directory)
+	bool rendered = false;
+	string log;
+	vector<uint8_t> pixels;  //!< top-down RGBA pixels
+	string status;  //!< pass, fail, missing (without reference), error, skipped (not rendered, without reference) or updated
+	image_diff_stats stats;
+	string diff;  //!< difference image file
+};
+
+static void render_cases(vector<golden_case> & cases, ivec2 const & size);
+static void compare_case(golden_case & c, golden_options const & opts, fs::path const & reference, fs::path const & output);
+static bool failed(golden_case const & c);
+
+unsigned check_golden_images(string const & dir, golden_options const & opts, std::ostream & report)
+{
+	using clock = std::chrono::steady_clock;
+
+	playlist files;
+	if (!files.load(dir))
+		throw std::runtime_error{"no shader found in '" + dir + "'"};
+
+	fs::path reference = opts.reference.empty() ? fs::path{dir} / "golden" : fs::path{opts.reference},
+		output = opts.output.empty() ? reference / "failed" : fs::path{opts.output};
+	fs::create_directories(reference);
+
+	vector<golden_case> cases;
+	for (size_t i = 0; i < files.size(); ++i, files.next())
+	{
+		for (float t : opts.times)
+		{
+			golden_case c;
+			c.fname = files.current();
+			c.time = t;
+			ostringstream name;
+			name << flattened_path(relative_path(c.fname, dir)) << "@" << t;  // same named shaders from other directories don't collide
+			c.name = name.str();
+			cases.push_back(c);
+		}
+	}
+
+	clock::time_point t0 = clock::now();
+	render_cases(cases, opts.size);
+	clock::time_point t1 = clock::now();
+
+	// compare in parallel
+	unsigned jobs = max(1u, min(opts.jobs, (unsigned)cases.size()));
+	atomic<size_t> next{0};
+	vector<thread> workers;
+	for (unsigned i = 0; i < jobs; ++i)
+	{
+		workers.emplace_back([&cases, &opts, &reference, &output, &next]{
+			for (size_t i = next++; i < cases.size(); i = next++)
+				compare_case(cases[i], opts, reference, output);
+		});
+	}
+
+	for (thread & w : workers)
+		w.join();
+
+	clock::time_point t2 = clock::now();
+
+	unsigned failures = count_if(cases.begin(), cases.end(), failed);
+	unsigned missing = count_if(cases.begin(), cases.end(), [](golden_case const & c){return c.status == "missing";});
+
+	// report
+	using ms = std::chrono::duration<double, std::milli>;
+	report << "{\n"
+		<< "  \"directory\": " << json_quote(dir) << ",\n"
+		<< "  \"reference\": " << json_quote(reference.string()) << ",\n"
+		<< "  \"size\": [" << opts.size.x << ", " << opts.size.y << "],\n"
+		<< "  \"kernel\": " << json_quote(compare_images_kernel()) << ",\n"
+		<< "  \"render_time_ms\": " << ms{t1 - t0}.count() << ",\n"
+		<< "  \"compare_time_ms\": " << ms{t2 - t1}.count() << ",\n"
+		<< "  \"passed\": " << cases.size() - failures - missing << ",\n"
+		<< "  \"failed\": " << failures << ",\n"
+		<< "  \"missing\": " << missing << ",\n"
+		<< "  \"results\": [";
+
+	for (size_t i = 0; i < cases.size(); ++i)
+	{
+		golden_case const & c = cases[i];
+		report << (i > 0 ? "," : "") << "\n    {"
+			<< "\"file\": " << json_quote(c.fname) << ", "
+			<< "\"time\": " << c.time << ", "
+			<< "\"status\": " << json_quote(c.status);
+
+		if (c.status == "pass" || c.status == "fail")
+		{
+			report << ", \"max_diff\": " << c.stats.max_diff
+				<< ", \"mean_diff\": " << c.stats.mean_diff
+				<< ", \"differing_pixels\": " << c.stats.differing_pixels
+				<< ", \"ssim\": " << c.stats.ssim;
+		}
+
+		if (!c.diff.empty())
+			report << ", \"diff\": " << json_quote(c.diff);
+
+		if (!c.log.empty())
+			report << ", \"log\": " << json_quote(c.log);
+
+		report << "}";
+	}
+
+	report << "\n  ]\n}" << std::endl;
+
+	std::cerr << cases.size() - failures - missing << " golden image(s) passed, " << failures << " failed" << std::endl;
+	if (missing > 0)
+		std::cerr << missing << " reference image(s) missing (skipped), create them with --golden-update" << std::endl;
+
+	return failures;
+}
+
+void render_cases(vector<golden_case> & cases, ivec2 const & size)
+{
+	if (!glfwInit())
+		throw std::runtime_error{"unable to initialize GLFW"};
+
+	{
+		headless_context ctx;
+		ctx.make_current();
+
+		framebuffer fbo{unsigned(size.x), unsigned(size.y)};
+		gles2::mesh quad = make_quad_xy<gles2::mesh>(vec2{-1,-1}, 2);
+		vector<uint8_t> pixels(size.x * size.y * 4);
+
+		fbo.bind();
+		glDisable(GL_DEPTH_TEST);
+		glClearColor(0, 0, 0, 1);
+
+		// cases of one shader are consecutive, program is prepared once
+		prepared_program p;
+		for (golden_case & c : cases)
+		{
+			if (p.fname != c.fname)
+			{
+				p = prepared_program{};
+				try {
+					prepare_program(c.fname, shadertoy_program::specialization{}, p);
+				}
+				catch (std::exception & e) {
+					p.ok = false;
+					c.log = e.what();
+				}
+				p.fname = c.fname;
+			}
+
+			if (!p.ok)
+			{
+				if (c.log.empty())
+					c.log = p.prog.error_log();
+				continue;
+			}
+
+			for (auto & ch : p.channels)
+				ch->update(c.time);
+
+			glClear(GL_COLOR_BUFFER_BIT);
+			p.prog.use();
+			p.prog.update(c.time, vec2{size}, int(c.time * 60.0f), vec4{0});
+			quad.render();
+
+			fbo.read_pixels(0, 0, size.x, size.y, pixels.data());
+
+			c.pixels.resize(pixels.size());
+			size_t row = size.x * 4;
+			for (int y = 0; y < size.y; ++y)  // bottom-up to top-down
+				std::copy_n(pixels.data() + y * row, row, c.pixels.data() + (size.y - 1 - y) * row);
+
+			c.rendered = true;
+		}
+
+		fbo.unbind();
+		p = prepared_program{};
+		channel_texture_cache().clear();  // while context is current
+		ctx.release();
+	}  // context needs to be destroyed before glfwTerminate()
+
+	glfwTerminate();
+}
+
+void compare_case(golden_case & c, golden_options const & opts, fs::path const & reference, fs::path const & output)
+{
+	ivec2 const & size = opts.size;
+	string ref_png = (reference / (c.name + ".png")).string();
+
+	try {
+		if (!c.rendered)
+		{
+			c.status = fs::exists(ref_png) ? "error" : "skipped";
+			return;
+		}
+
+		if (opts.update)
+		{
+			Magick::Image im{(size_t)size.x, (size_t)size.y, "RGBA", Magick::CharPixel, c.pixels.data()};
+			im.write(ref_png);
+			c.status = "updated";
+			return;
+		}
+
+		if (!fs::exists(ref_png))
+		{
+			c.status = "missing";
+			return;
+		}
+
+		Magick::Image ref{ref_png};
+		if (int(ref.columns()) != size.x || int(ref.rows()) != size.y)
+		{
+			c.status = "fail";
+			c.log = "reference image size differs";
+			return;
+		}
+
+		vector<uint8_t> ref_pixels(c.pixels.size()), diff(c.pixels.size());
+		ref.write(0, 0, size.x, size.y, "RGBA", Magick::CharPixel, ref_pixels.data());
+
+		c.stats = compare_images(ref_pixels.data(), c.pixels.data(), size.x, size.y, opts.threshold, diff.data());
+
+		double differing = double(c.stats.differing_pixels) / (size_t(size.x) * size.y);
+		c.status = (differing <= opts.max_differing && c.stats.ssim >= opts.min_ssim) ? "pass" : "fail";
+
+		if (c.status == "fail")
+		{
+			fs::create_directories(output);
+			Magick::Image{(size_t)size.x, (size_t)size.y, "RGBA", Magick::CharPixel, c.pixels.data()}.write(
+				(output / (c.name + ".png")).string());
+
+			c.diff = (output / (c.name + ".diff.png")).string();
+			Magick::Image{(size_t)size.x, (size_t)size.y, "RGBA", Magick::CharPixel, diff.data()}.write(c.diff);
+		}
+	}
+	catch (std::exception & e) {
+		c.status = "error";
+		c.log = e.what();
+	}
+}
+
+bool failed(golden_case const & c)
+{
+	return c.status == "fail" || c.status == "error";
+}
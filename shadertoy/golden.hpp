@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ostream>
+#include <glm/vec2.hpp>
+
+//! golden image regression options \sa check_golden_images()
+struct golden_options
+{
+	glm::ivec2 size = glm::ivec2{160, 90};  //!< rendered image size
+	std::vector<float> times = {0.5f, 2.0f};  //!< iTime values each shader is rendered for
+	std::string reference;  //!< reference images directory, DIR/golden if empty
+	std::string output;  //!< directory for failed images and diffs, DIR/golden/failed if empty
+	bool update = false;  //!< writes rendered images as new references instead of comparing
+	unsigned threshold = 8;  //!< channel difference a pixel is counted as different above
+	double max_differing = 0.001;  //!< maximal fraction of differing pixels
+	double min_ssim = 0.98;  //!< minimal structural similarity
+	unsigned jobs = 1;  //!< number of comparison threads
+};
+
+/*! Renders each shader program and project in a directory (or a playlist
+file) headless at fixed times and compares results with `PATH@TIME.png`
+reference images, see compare_images(). PATH is the shader path relative
+to dir with `/` replaced by `_`. Comparisons run in parallel on opts.jobs
+threads, rendered image and difference image are written for each
+failed comparison, JSON report is written to report.
+
+Shader failing to render is a regression only if it has reference images,
+comparison without reference image is skipped (reported as missing), so
+a fresh checkout passes until references are created with opts.update.
+\return number of failed comparisons */
+unsigned check_golden_images(std::string const & dir, golden_options const & opts, std::ostream & report);
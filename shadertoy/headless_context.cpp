@@ -0,0 +1,37 @@
+#include <stdexcept>
+#include "headless_context.hpp"
+
+headless_context::headless_context(unsigned width, unsigned height, GLFWwindow * share)
+{
+	glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	_window = glfwCreateWindow(width, height, "headless", nullptr, share);
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);  // restore default
+
+	if (!_window)
+		throw std::runtime_error{"unable to create an OpenGL ES 2 context"};
+}
+
+headless_context::~headless_context()
+{
+	glfwDestroyWindow(_window);
+}
+
+void headless_context::make_current()
+{
+	glfwMakeContextCurrent(_window);
+}
+
+void headless_context::release()
+{
+	glfwMakeContextCurrent(nullptr);
+}
+
+GLFWwindow * headless_context::native_window() const
+{
+	return _window;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <GLFW/glfw3.h>
+
+/*! Hidden GLFW window providing OpenGL ES 2 context for off-screen work.
+\note GLFW requires windows to be created (and destroyed) from the main
+thread, the context itself can be made current in any (but only one) thread.
+\code
+glfwInit();
+headless_context ctx;
+std::thread worker{[&ctx]{
+	ctx.make_current();
+	// ...
+	ctx.release();
+}};
+\endcode */
+class headless_context
+{
+public:
+	headless_context(unsigned width = 64, unsigned height = 64, GLFWwindow * share = nullptr);
+	~headless_context();
+	void make_current();
+	void release();  //!< detach context from the calling thread
+	GLFWwindow * native_window() const;
+
+	headless_context(headless_context const &) = delete;
+	void operator=(headless_context const &) = delete;
+
+private:
+	GLFWwindow * _window;
+};
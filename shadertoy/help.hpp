@@ -5,11 +5,14 @@ inline std::string help_keys()
 {
 	return std::string{
 		"{keys}\n"
-		"O: open shadertoy program or project file (*.stoy)\n"
+		"O: open shadertoy program, project or bundle file (*.stoy, *.stoyb)\n"
 		"R: reload shader program\n"
 		"E: edit shader program\n"
 		"P: pause/play\n"
 		".: next step\n"
+		"[, ]: select shader parameter\n"
+		"-, =: decrease/increase shader parameter\n"
+		"W: write shader parameters back into source\n"
 		"H: show this help"};
 }
 
@@ -0,0 +1,277 @@
+#include <vector>
+#include <algorithm>
+#include "image_diff.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define HAVE_X86_KERNELS
+	#include <immintrin.h>
+#endif
+
+using std::vector;
+using std::max;
+using std::min;
+
+namespace {
+
+struct diff_sums
+{
+	uint64_t sum = 0;  //!< sum of absolute channel differences
+	unsigned max = 0;
+	size_t count = 0;  //!< differing pixels
+};
+
+using diff_function = void (*)(uint8_t const * a, uint8_t const * b, size_t n, uint8_t threshold,
+	uint8_t * diff, diff_sums & result);
+
+inline uint8_t amplified(int d)
+{
+	return uint8_t(min(d * 4, 255));
+}
+
+//! compares pixels starting at from
+void diff_scalar(uint8_t const * a, uint8_t const * b, size_t from, size_t n, uint8_t threshold,
+	uint8_t * diff, diff_sums & result)
+{
+	for (size_t i = from; i < n; ++i)
+	{
+		uint8_t const * p = a + 4*i, * q = b + 4*i;
+		int d[3] = {std::abs(p[0] - q[0]), std::abs(p[1] - q[1]), std::abs(p[2] - q[2])};
+		int m = max(d[0], max(d[1], d[2]));
+
+		result.sum += d[0] + d[1] + d[2];
+		result.max = max(result.max, unsigned(m));
+		if (m > threshold)
+			++result.count;
+
+		if (diff)
+		{
+			uint8_t * o = diff + 4*i;
+			o[0] = amplified(d[0]);
+			o[1] = amplified(d[1]);
+			o[2] = amplified(d[2]);
+			o[3] = 255;
+		}
+	}
+}
+
+#if !defined(HAVE_X86_KERNELS)  // SIMD kernels are used instead
+void diff_scalar(uint8_t const * a, uint8_t const * b, size_t n, uint8_t threshold, uint8_t * diff,
+	diff_sums & result)
+{
+	diff_scalar(a, b, 0, n, threshold, diff, result);
+}
+#endif
+
+#if defined(HAVE_X86_KERNELS)
+
+inline unsigned horizontal_max_sse2(__m128i v)
+{
+	v = _mm_max_epu8(v, _mm_srli_si128(v, 8));
+	v = _mm_max_epu8(v, _mm_srli_si128(v, 4));
+	v = _mm_max_epu8(v, _mm_srli_si128(v, 2));
+	v = _mm_max_epu8(v, _mm_srli_si128(v, 1));
+	return unsigned(_mm_cvtsi128_si32(v) & 0xff);
+}
+
+inline uint64_t horizontal_sum_sse2(__m128i v)
+{
+	alignas(16) uint64_t s[2];
+	_mm_store_si128((__m128i *)s, v);
+	return s[0] + s[1];
+}
+
+//! 4 pixels per iteration
+void diff_sse2(uint8_t const * a, uint8_t const * b, size_t n, uint8_t threshold, uint8_t * diff,
+	diff_sums & result)
+{
+	__m128i const rgb = _mm_set1_epi32(0x00ffffff),
+		alpha = _mm_set1_epi32(int(0xff000000)),
+		thr = _mm_set1_epi8(char(threshold)),
+		zero = _mm_setzero_si128();
+
+	__m128i sum = zero, vmax = zero;
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128i p = _mm_and_si128(_mm_loadu_si128((__m128i const *)(a + 4*i)), rgb),
+			q = _mm_and_si128(_mm_loadu_si128((__m128i const *)(b + 4*i)), rgb);
+
+		__m128i d = _mm_or_si128(_mm_subs_epu8(p, q), _mm_subs_epu8(q, p));  // |p - q|
+		sum = _mm_add_epi64(sum, _mm_sad_epu8(d, zero));
+		vmax = _mm_max_epu8(vmax, d);
+
+		// pixel differs if any of its channels is above threshold
+		__m128i over = _mm_cmpeq_epi32(_mm_subs_epu8(d, thr), zero);
+		result.count += 4 - __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(over)));
+
+		if (diff)
+		{
+			__m128i x2 = _mm_adds_epu8(d, d);
+			_mm_storeu_si128((__m128i *)(diff + 4*i), _mm_or_si128(_mm_adds_epu8(x2, x2), alpha));
+		}
+	}
+
+	result.sum += horizontal_sum_sse2(sum);
+	result.max = max(result.max, horizontal_max_sse2(vmax));
+
+	diff_scalar(a, b, i, n, threshold, diff, result);
+}
+
+//! 8 pixels per iteration
+__attribute__((target("avx2")))
+void diff_avx2(uint8_t const * a, uint8_t const * b, size_t n, uint8_t threshold, uint8_t * diff,
+	diff_sums & result)
+{
+	__m256i const rgb = _mm256_set1_epi32(0x00ffffff),
+		alpha = _mm256_set1_epi32(int(0xff000000)),
+		thr = _mm256_set1_epi8(char(threshold)),
+		zero = _mm256_setzero_si256();
+
+	__m256i sum = zero, vmax = zero;
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i p = _mm256_and_si256(_mm256_loadu_si256((__m256i const *)(a + 4*i)), rgb),
+			q = _mm256_and_si256(_mm256_loadu_si256((__m256i const *)(b + 4*i)), rgb);
+
+		__m256i d = _mm256_or_si256(_mm256_subs_epu8(p, q), _mm256_subs_epu8(q, p));
+		sum = _mm256_add_epi64(sum, _mm256_sad_epu8(d, zero));
+		vmax = _mm256_max_epu8(vmax, d);
+
+		__m256i over = _mm256_cmpeq_epi32(_mm256_subs_epu8(d, thr), zero);
+		result.count += 8 - __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(over)));
+
+		if (diff)
+		{
+			__m256i x2 = _mm256_adds_epu8(d, d);
+			_mm256_storeu_si256((__m256i *)(diff + 4*i), _mm256_or_si256(_mm256_adds_epu8(x2, x2), alpha));
+		}
+	}
+
+	result.sum += horizontal_sum_sse2(_mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)));
+	result.max = max(result.max, horizontal_max_sse2(
+		_mm_max_epu8(_mm256_castsi256_si128(vmax), _mm256_extracti128_si256(vmax, 1))));
+
+	diff_scalar(a, b, i, n, threshold, diff, result);
+}
+
+#endif  // HAVE_X86_KERNELS
+
+struct kernel
+{
+	diff_function diff;
+	char const * name;
+};
+
+kernel const & select_kernel()
+{
+#if defined(HAVE_X86_KERNELS)
+	static kernel const k = __builtin_cpu_supports("avx2") ? kernel{diff_avx2, "avx2"} : kernel{diff_sse2, "sse2"};
+#else
+	static kernel const k{diff_scalar, "scalar"};
+#endif
+	return k;
+}
+
+//! (width+1)*(height+1) summed area table of f(luma) values
+template <typename F>
+vector<uint64_t> summed_area_table(vector<uint8_t> const & img, unsigned width, unsigned height, F f)
+{
+	size_t const stride = width + 1;
+	vector<uint64_t> result(stride * (height + 1), 0);
+	for (unsigned y = 0; y < height; ++y)
+	{
+		uint64_t row = 0;
+		for (unsigned x = 0; x < width; ++x)
+		{
+			row += f(size_t(y) * width + x);
+			result[(y+1)*stride + x+1] = result[y*stride + x+1] + row;
+		}
+	}
+	return result;
+}
+
+vector<uint8_t> luma_plane(uint8_t const * rgba, size_t n)
+{
+	vector<uint8_t> result(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		uint8_t const * p = rgba + 4*i;
+		result[i] = uint8_t((77*p[0] + 150*p[1] + 29*p[2] + 128) >> 8);  // BT.601 full range
+	}
+	return result;
+}
+
+}  // namespace
+
+image_diff_stats compare_images(uint8_t const * a, uint8_t const * b, unsigned width, unsigned height,
+	unsigned threshold, uint8_t * diff)
+{
+	size_t const n = size_t(width) * height;
+
+	diff_sums sums;
+	select_kernel().diff(a, b, n, uint8_t(min(threshold, 255u)), diff, sums);
+
+	image_diff_stats result;
+	result.max_diff = sums.max;
+	result.mean_diff = n > 0 ? double(sums.sum) / (3.0 * n) : 0.0;
+	result.differing_pixels = sums.count;
+	result.ssim = ssim(a, b, width, height);
+	return result;
+}
+
+double ssim(uint8_t const * a, uint8_t const * b, unsigned width, unsigned height)
+{
+
+	unsigned const window = min(8u, min(width, height)),
+		step = max(1u, window / 2);
+
+	if (window == 0)
+		return 1.0;
+
+	size_t const n = size_t(width) * height;
+	vector<uint8_t> x = luma_plane(a, n),
+		y = luma_plane(b, n);
+
+	vector<uint64_t> sx = summed_area_table(x, width, height, [&x](size_t i){return uint64_t(x[i]);}),
+		sy = summed_area_table(y, width, height, [&y](size_t i){return uint64_t(y[i]);}),
+		sxx = summed_area_table(x, width, height, [&x](size_t i){return uint64_t(x[i]) * x[i];}),
+		syy = summed_area_table(y, width, height, [&y](size_t i){return uint64_t(y[i]) * y[i];}),
+		sxy = summed_area_table(x, width, height, [&x, &y](size_t i){return uint64_t(x[i]) * y[i];});
+
+	size_t const stride = width + 1;
+	auto window_sum = [stride, window](vector<uint64_t> const & t, unsigned x0, unsigned y0){
+		return double(t[(y0+window)*stride + x0+window] - t[y0*stride + x0+window]
+			- t[(y0+window)*stride + x0] + t[y0*stride + x0]);
+	};
+
+	double const c1 = (0.01 * 255) * (0.01 * 255),
+		c2 = (0.03 * 255) * (0.03 * 255),
+		count = double(window) * window;
+
+	double total = 0.0;
+	size_t windows = 0;
+	for (unsigned y0 = 0; y0 + window <= height; y0 += step)
+	{
+		for (unsigned x0 = 0; x0 + window <= width; x0 += step)
+		{
+			double mx = window_sum(sx, x0, y0) / count,
+				my = window_sum(sy, x0, y0) / count,
+				vx = window_sum(sxx, x0, y0) / count - mx*mx,
+				vy = window_sum(syy, x0, y0) / count - my*my,
+				cxy = window_sum(sxy, x0, y0) / count - mx*my;
+
+			total += ((2*mx*my + c1) * (2*cxy + c2)) / ((mx*mx + my*my + c1) * (vx + vy + c2));
+			++windows;
+		}
+	}
+
+	return windows > 0 ? total / windows : 1.0;
+}
+
+char const * compare_images_kernel()
+{
+	return select_kernel().name;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+//! image comparison result \sa compare_images()
+struct image_diff_stats
+{
+	unsigned max_diff = 0;  //!< maximal channel difference
+	double mean_diff = 0.0;  //!< mean absolute channel difference
+	size_t differing_pixels = 0;  //!< pixels with a channel difference above threshold
+	double ssim = 1.0;  //!< mean structural similarity of luma (1 for identical images)
+};
+
+/*! Compares two top-down RGBA images of the same size, alpha channel is
+ignored. Per pixel differences are computed by AVX2 or SSE2 kernel when
+available (chosen at run time), SSIM is computed from luma over 8x8 windows
+(with 4 pixel step) using summed area tables.
+\param diff optional width*height*4 bytes buffer for difference image
+(absolute difference amplified 4 times, alpha is 255)
+\code
+image_diff_stats s = compare_images(ref.data(), out.data(), w, h, 8);
+if (s.ssim < 0.98) ...
+\endcode */
+image_diff_stats compare_images(uint8_t const * a, uint8_t const * b, unsigned width, unsigned height,
+	unsigned threshold, uint8_t * diff = nullptr);
+
+double ssim(uint8_t const * a, uint8_t const * b, unsigned width, unsigned height);  //!< mean SSIM of RGBA images luma
+
+char const * compare_images_kernel();  //!< returns name of the kernel used ("avx2", "sse2" or "scalar")
@@ -0,0 +1,137 @@
+#include <cstring>
+#include <stdexcept>
+#include "input_trace.hpp"
+
+using std::string;
+using glm::ivec2;
+using glm::vec4;
+
+namespace {
+
+char const magic[4] = {'S', 'T', 'I', 'T'};
+uint16_t const version = 1;
+
+enum record_flags : uint8_t
+{
+	mouse_changed = 1,
+	keys_changed = 2,
+	frame_changed = 4  //!< iFrame is not previous + 1
+};
+
+template <typename T>
+void write_value(std::ostream & out, T const & v)
+{
+	out.write(reinterpret_cast<char const *>(&v), sizeof(T));
+}
+
+template <typename T>
+bool read_value(std::istream & in, T & v)
+{
+	return bool(in.read(reinterpret_cast<char *>(&v), sizeof(T)));
+}
+
+}  // namespace
+
+bool frame_input::operator==(frame_input const & rhs) const
+{
+	return dt == rhs.dt && t == rhs.t && frame == rhs.frame && mouse == rhs.mouse && keys == rhs.keys;
+}
+
+input_recorder::input_recorder(string const & fname, ivec2 const & size)
+	: _fout{fname, std::ios::binary}
+	, _frames{0}
+{
+	if (!_fout.is_open())
+		throw std::runtime_error{"unable to create '" + fname + "' input trace"};
+
+	_fout.write(magic, sizeof(magic));
+	write_value(_fout, version);
+	write_value(_fout, uint32_t(size.x));
+	write_value(_fout, uint32_t(size.y));
+
+	_prev.frame = -1;
+}
+
+void input_recorder::write(frame_input const & in)
+{
+	uint8_t flags = 0;
+	if (in.mouse != _prev.mouse)
+		flags |= mouse_changed;
+	if (in.keys != _prev.keys)
+		flags |= keys_changed;
+	if (in.frame != _prev.frame + 1)
+		flags |= frame_changed;
+
+	write_value(_fout, flags);
+	write_value(_fout, in.dt);
+	write_value(_fout, in.t);
+
+	if (flags & mouse_changed)
+		write_value(_fout, in.mouse);
+	if (flags & keys_changed)
+		write_value(_fout, in.keys);
+	if (flags & frame_changed)
+		write_value(_fout, int32_t(in.frame));
+
+	_prev = in;
+	++_frames;
+}
+
+size_t input_recorder::frames() const
+{
+	return _frames;
+}
+
+input_player::input_player(string const & fname)
+	: _fin{fname, std::ios::binary}
+{
+	if (!_fin.is_open())
+		throw std::runtime_error{"unable to open '" + fname + "' input trace"};
+
+	char m[4];
+	uint16_t ver;
+	uint32_t w, h;
+	if (!_fin.read(m, sizeof(m)) || memcmp(m, magic, sizeof(magic)) != 0
+		|| !read_value(_fin, ver) || !read_value(_fin, w) || !read_value(_fin, h))
+	{
+		throw std::runtime_error{"'" + fname + "' is not an input trace"};
+	}
+
+	if (ver != version)
+		throw std::runtime_error{"'" + fname + "' unsupported input trace version " + std::to_string(ver)};
+
+	_size = ivec2{w, h};
+	_prev.frame = -1;
+}
+
+ivec2 const & input_player::size() const
+{
+	return _size;
+}
+
+bool input_player::next(frame_input & in)
+{
+	uint8_t flags;
+	frame_input f = _prev;
+	f.frame = _prev.frame + 1;
+
+	if (!read_value(_fin, flags) || !read_value(_fin, f.dt) || !read_value(_fin, f.t))
+		return false;
+
+	if ((flags & mouse_changed) && !read_value(_fin, f.mouse))
+		return false;
+
+	if ((flags & keys_changed) && !read_value(_fin, f.keys))
+		return false;
+
+	int32_t frame;
+	if (flags & frame_changed)
+	{
+		if (!read_value(_fin, frame))
+			return false;
+		f.frame = frame;
+	}
+
+	in = _prev = f;
+	return true;
+}
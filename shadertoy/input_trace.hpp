@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+//! per frame application input
+struct frame_input
+{
+	float dt = 0.0f;  //!< input/update time step (in s)
+	float t = 0.0f;  //!< iTime
+	int frame = 0;  //!< iFrame
+	glm::vec4 mouse = glm::vec4{0};  //!< iMouse
+	uint16_t keys = 0;  //!< pressed application keys mask (bit index is application defined)
+
+	bool operator==(frame_input const & rhs) const;
+};
+
+/*! Compact binary input trace writer.
+
+Trace starts with `STIT` magic, version and framebuffer size followed by
+frame records. Frame record is a flags byte, dt and t followed by iMouse,
+keys mask and iFrame only if they changed (iFrame if not incremented), so a
+typical record takes 9 bytes. Values are stored in native (little endian)
+byte order.
+\code
+input_recorder rec{"session.trace", framebuffer_size()};
+rec.write(in);  // each frame
+\endcode \sa input_player */
+class input_recorder
+{
+public:
+	input_recorder(std::string const & fname, glm::ivec2 const & size);  //!< throws std::runtime_error
+	void write(frame_input const & in);
+	size_t frames() const;
+
+	input_recorder(input_recorder const &) = delete;
+	void operator=(input_recorder const &) = delete;
+
+private:
+	std::ofstream _fout;
+	frame_input _prev;
+	size_t _frames;
+};
+
+//! input trace reader \sa input_recorder
+class input_player
+{
+public:
+	input_player(std::string const & fname);  //!< throws std::runtime_error for unsupported or corrupted file
+	glm::ivec2 const & size() const;  //!< recorded framebuffer size
+	bool next(frame_input & in);  //!< reads next frame input, returns false at the end of trace
+
+	input_player(input_player const &) = delete;
+	void operator=(input_player const &) = delete;
+
+private:
+	std::ifstream _fin;
+	glm::ivec2 _size;
+	frame_input _prev;
+};
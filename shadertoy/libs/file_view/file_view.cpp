@@ -0,0 +1,163 @@
+#include <utility>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "file_view.hpp"
+
+namespace io {
+
+using std::string;
+using std::string_view;
+using std::swap;
+
+line_range::iterator::iterator(string_view rest)
+	: _rest{rest}
+{
+	++*this;
+}
+
+line_range::iterator & line_range::iterator::operator++()
+{
+	if (_rest.empty())  // end
+	{
+		_line = string_view{};
+		_rest = string_view{};
+		return *this;
+	}
+
+	size_t eol = _rest.find('\n');
+	if (eol == string_view::npos)  // unterminated last line
+	{
+		_line = _rest;
+		_rest = _rest.substr(_rest.size());
+	}
+	else
+	{
+		_line = _rest.substr(0, eol);
+		_rest = _rest.substr(eol + 1);
+	}
+
+	return *this;
+}
+
+line_range::line_range(string_view text)
+	: _text{text}
+{}
+
+line_range::iterator line_range::begin() const
+{
+	return iterator{_text};
+}
+
+line_range::iterator line_range::end() const
+{
+	return iterator{string_view{}};
+}
+
+
+file_view::file_view()
+	: _addr{nullptr}, _size{0}, _open{false}
+{}
+
+file_view::file_view(string const & fname)
+	: file_view{}
+{
+	open(fname);
+}
+
+file_view::file_view(file_view && other)
+	: _addr{other._addr}, _size{other._size}, _open{other._open}
+{
+	other._addr = nullptr;
+	other._size = 0;
+	other._open = false;
+}
+
+file_view::~file_view()
+{
+	close();
+}
+
+void file_view::open(string const & fname)
+{
+	close();
+
+	int fd = ::open(fname.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw std::runtime_error{"can't open '" + fname + "' file"};
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode))
+	{
+		::close(fd);
+		throw std::runtime_error{"can't open '" + fname + "' file (not a regular file)"};
+	}
+
+	if (st.st_size > 0)  // zero length mapping is not allowed
+	{
+		void * addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED)
+		{
+			::close(fd);
+			throw std::runtime_error{"can't map '" + fname + "' file"};
+		}
+
+		madvise(addr, st.st_size, MADV_SEQUENTIAL);
+		_addr = addr;
+		_size = st.st_size;
+	}
+
+	::close(fd);  // mapping stays valid
+	_open = true;
+}
+
+void file_view::close()
+{
+	if (_addr)
+		munmap(_addr, _size);
+
+	_addr = nullptr;
+	_size = 0;
+	_open = false;
+}
+
+bool file_view::is_open() const
+{
+	return _open;
+}
+
+char const * file_view::data() const
+{
+	return static_cast<char const *>(_addr);
+}
+
+size_t file_view::size() const
+{
+	return _size;
+}
+
+bool file_view::empty() const
+{
+	return _size == 0;
+}
+
+string_view file_view::view() const
+{
+	return string_view{data(), _size};
+}
+
+line_range file_view::lines() const
+{
+	return line_range{view()};
+}
+
+void file_view::operator=(file_view && other)
+{
+	swap(_addr, other._addr);
+	swap(_size, other._size);
+	swap(_open, other._open);
+}
+
+}  // io
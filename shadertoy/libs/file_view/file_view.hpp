@@ -0,0 +1,74 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <iterator>
+#include <cstddef>
+
+namespace io {
+
+//! text lines of a buffer without line ending ('\n'), the last line can be unterminated
+class line_range
+{
+public:
+	struct iterator
+	{
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::string_view const *;
+		using reference = std::string_view const &;
+
+		iterator(std::string_view rest);
+		std::string_view const & operator*() const {return _line;}
+		std::string_view const * operator->() const {return &_line;}
+		iterator & operator++();
+		bool operator==(iterator const & rhs) const {return _rest.data() == rhs._rest.data() && _line.data() == rhs._line.data();}
+		bool operator!=(iterator const & rhs) const {return !(*this == rhs);}
+
+	private:
+		std::string_view _rest;  //!< text after the current line
+		std::string_view _line;
+	};
+
+	line_range(std::string_view text);
+	iterator begin() const;
+	iterator end() const;
+
+private:
+	std::string_view _text;
+};
+
+/*! Read only memory mapped file. Content is accessible as string_view (valid
+while the view lives) without copying it into memory first.
+\code
+io::file_view f{"scene.stoy"};
+for (string_view line : f.lines())
+	// do something with line
+\endcode */
+class file_view
+{
+public:
+	file_view();
+	file_view(std::string const & fname);  //!< throws std::runtime_error if file can't be opened
+	file_view(file_view && other);
+	~file_view();
+	void open(std::string const & fname);
+	void close();
+	bool is_open() const;
+	char const * data() const;
+	size_t size() const;
+	bool empty() const;
+	std::string_view view() const;  //!< whole file
+	line_range lines() const;
+	void operator=(file_view && other);
+
+	file_view(file_view const &) = delete;
+	void operator=(file_view const &) = delete;
+
+private:
+	void * _addr;  //!< mapped memory (nullptr for empty file)
+	size_t _size;
+	bool _open;
+};
+
+}  // io
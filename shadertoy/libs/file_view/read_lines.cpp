@@ -3,26 +3,26 @@
 namespace io {
 
 using std::string;
-using std::ifstream;
 
 read_lines_range::read_lines_range()
+	: _line_it{std::string_view{}}
+	, _empty{true}
 {}
 
 read_lines_range::read_lines_range(string const & fname)
-	: _fin{fname}
+	: _file{fname}
+	, _line_it{_file.view()}
 {
-	if (!_fin.is_open())
-		throw std::runtime_error{"unable to open '" + fname + "' file"};
-
-	getline(_fin, _line);
+	_empty = !next();
 }
 
 bool read_lines_range::next()
 {
-	if (!_fin)
+	if (_line_it == line_range::iterator{std::string_view{}})
 		return false;
 
-	getline(_fin, _line);
+	_line.assign(_line_it->data(), _line_it->size());  // reuses line storage
+	++_line_it;
 	return true;
 }
 
@@ -38,7 +38,7 @@ read_lines_range read_lines(string const & fname)
 
 read_lines_range::iterator read_lines_range::begin() const
 {
-	return iterator{const_cast<read_lines_range *>(this)};
+	return iterator{_empty ? nullptr : const_cast<read_lines_range *>(this)};
 }
 
 read_lines_range::iterator read_lines_range::end() const
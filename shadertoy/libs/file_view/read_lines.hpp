@@ -1,8 +1,8 @@
 #pragma once
 #include <string>
-#include <fstream>
 #include <stdexcept>
 #include <iterator>
+#include "file_view.hpp"
 
 namespace io {
 
@@ -41,11 +41,13 @@ private:
 	std::string const & current() const;
 
 	std::string _line;
-	std::ifstream _fin;
+	file_view _file;
+	line_range::iterator _line_it;  //!< next line
+	bool _empty;
 };
 
 
-/*! read text file lines
+/*! read text file lines (prefer file_view::lines() to avoid line copies)
 \code
 for (string const & line : io::read_lines("test.txt"))
 	// do something with line
@@ -1,34 +1,70 @@
+#include <utility>
 #include "glfw3_user_input.hpp"
 
 namespace ui { namespace glfw3 {
 
+using std::vector;
 using glm::vec2;
 
+static int button_code(event_handler::button b);
+static event_handler::modifier to_modifier(int mods);
+
 user_input::user_input()
-	: _window{nullptr}
+	: _mouse{0, 0}
+	, _wheel{0}
+	, _cursor{0, 0}
+	, _scroll{0.0}
+	, _window{nullptr}
+	, _mode{input_mode::window}
+	, _center{vec2{0, 0}}
 {}
 
 user_input::user_input(GLFWwindow * window, input_mode mode)
-	: _mouse{0,0}
-	, _window{window}
-	, _mode{mode}
-	, _center{vec2{0, 0}}
+	: user_input{}
+{
+	attach(window, mode);
+}
+
+user_input::~user_input()
+{
+	detach();
+}
+
+void user_input::attach(GLFWwindow * window, input_mode mode)
 {
 	assert(window);
 
+	detach();
+	_window = window;
+
+	glfwSetWindowUserPointer(window, this);
+	glfwSetKeyCallback(window, key_callback);
+	glfwSetMouseButtonCallback(window, mouse_button_callback);
+	glfwSetCursorPosCallback(window, cursor_position_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	double x, y;
+	glfwGetCursorPos(window, &x, &y);
+	_cursor = vec2(x, y);
+
 	this->mode(mode);
+}
 
-	for (int i = GLFW_MOUSE_BUTTON_1; i < GLFW_MOUSE_BUTTON_LAST+1; ++i)
-	{
-		_mouse_button[i] = GLFW_RELEASE;
-		_mouse_button_up[i] = false;
-	}
+void user_input::detach()
+{
+	if (!_window)
+		return;
 
-	for (int i = 0; i < GLFW_KEY_LAST; ++i)
+	if (glfwGetWindowUserPointer(_window) == this)
 	{
-		_key[i] = GLFW_RELEASE;
-		_key_up[i] = false;
+		glfwSetKeyCallback(_window, nullptr);
+		glfwSetMouseButtonCallback(_window, nullptr);
+		glfwSetCursorPosCallback(_window, nullptr);
+		glfwSetScrollCallback(_window, nullptr);
+		glfwSetWindowUserPointer(_window, nullptr);
 	}
+
+	_window = nullptr;
 }
 
 void user_input::input(double dt)
@@ -36,81 +72,106 @@ void user_input::input(double dt)
 	assert(_window);
 
 	// mouse position
-	double x, y;
-	glfwGetCursorPos(_window, &x, &y);
-
 	if (_mode == input_mode::camera)
 	{
+		_mouse = _cursor - _center;
 		glfwSetCursorPos(_window, _center.x, _center.y);
-		_mouse = vec2(x - _center.x, y - _center.y);
+		_cursor = _center;
 	}
 	else
-		_mouse = vec2(x, y);
+		_mouse = _cursor;
 
-	// mouse buttons
-	for (int i = GLFW_MOUSE_BUTTON_1; i < GLFW_MOUSE_BUTTON_LAST+1; ++i)
-	{
-		int state = glfwGetMouseButton(_window, i);
-		if (_mouse_button[i] == GLFW_PRESS && state == GLFW_RELEASE)
-			_mouse_button_up[i] = true;
-		else
-			_mouse_button_up[i] = false;
+	// buttons and keys pressed since the last frame are down for this frame even if already released
+	_mouse_button = _buttons_down | _buttons_pressed;
+	_mouse_button_up = _buttons_released;
+	_buttons_pressed.reset();
+	_buttons_released.reset();
 
-		_mouse_button[i] = state;
-	}
+	_key = _keys_down | _keys_pressed;
+	_key_up = _keys_released;
+	_keys_pressed.reset();
+	_keys_released.reset();
 
-	// keyboard
-	for (int i = 0; i < GLFW_KEY_LAST; ++i)
-	{
-		int state = glfwGetKey(_window, i);
-		if (_key[i] == GLFW_PRESS && state == GLFW_RELEASE)
-			_key_up[i] = true;
-		else
-			_key_up[i] = false;
+	_wheel = _scroll > 0.0 ? 1 : (_scroll < 0.0 ? -1 : 0);
+	_scroll = 0.0;
 
-		_key[i] = state;
-	}
+	std::swap(_events, _pending);
+	_pending.clear();
 }
 
-vec2 const & user_input::mouse_position() const
+vector<user_input::event> const & user_input::events() const
 {
-	return _mouse;
+	return _events;
 }
 
-bool user_input::mouse(event_handler::button b) const
+void user_input::key_callback(GLFWwindow * window, int key, int scancode, int action, int mods)
 {
-	// TODO: cast function
-	int button_code;
-	if (b == event_handler::button::left)
-		button_code = GLFW_MOUSE_BUTTON_LEFT;
-	else if (b == event_handler::button::right)
-		button_code = GLFW_MOUSE_BUTTON_RIGHT;
-	else if (b == event_handler::button::middle)
-		button_code = GLFW_MOUSE_BUTTON_MIDDLE;
+	user_input * in = static_cast<user_input *>(glfwGetWindowUserPointer(window));
+	if (!in || key < 0 || key > GLFW_KEY_LAST || action == GLFW_REPEAT)
+		return;
+
+	bool down = action == GLFW_PRESS;
+	in->_keys_down[key] = down;
+	if (down)
+		in->_keys_pressed[key] = true;
 	else
-		return false;  // unsupported button
+		in->_keys_released[key] = true;
 
-	return _mouse_button[button_code] == GLFW_PRESS;
+	in->_pending.push_back(event{down ? event::type::key_down : event::type::key_up, key, to_modifier(mods), in->_cursor});
 }
 
-bool user_input::mouse_up(event_handler::button b) const
+void user_input::mouse_button_callback(GLFWwindow * window, int button, int action, int mods)
 {
-	int button_code;
-	if (b == event_handler::button::left)
-		button_code = GLFW_MOUSE_BUTTON_LEFT;
-	else if (b == event_handler::button::right)
-		button_code = GLFW_MOUSE_BUTTON_RIGHT;
-	else if (b == event_handler::button::middle)
-		button_code = GLFW_MOUSE_BUTTON_MIDDLE;
+	user_input * in = static_cast<user_input *>(glfwGetWindowUserPointer(window));
+	if (!in || button < 0 || button > GLFW_MOUSE_BUTTON_LAST)
+		return;
+
+	bool down = action == GLFW_PRESS;
+	in->_buttons_down[button] = down;
+	if (down)
+		in->_buttons_pressed[button] = true;
 	else
-		return false;  // unsupported button
+		in->_buttons_released[button] = true;
 
-	return _mouse_button_up[button_code];
+	in->_pending.push_back(event{down ? event::type::button_down : event::type::button_up, button, to_modifier(mods), in->_cursor});
+}
+
+void user_input::cursor_position_callback(GLFWwindow * window, double x, double y)
+{
+	if (user_input * in = static_cast<user_input *>(glfwGetWindowUserPointer(window)))
+		in->_cursor = vec2(x, y);
+}
+
+void user_input::scroll_callback(GLFWwindow * window, double dx, double dy)
+{
+	user_input * in = static_cast<user_input *>(glfwGetWindowUserPointer(window));
+	if (!in || dy == 0.0)
+		return;
+
+	in->_scroll += dy;
+	in->_pending.push_back(event{event::type::wheel, dy > 0.0 ? 1 : -1, event_handler::none, in->_cursor});
+}
+
+vec2 const & user_input::mouse_position() const
+{
+	return _mouse;
+}
+
+bool user_input::mouse(event_handler::button b) const
+{
+	int code = button_code(b);
+	return code != -1 && _mouse_button[code];
+}
+
+bool user_input::mouse_up(event_handler::button b) const
+{
+	int code = button_code(b);
+	return code != -1 && _mouse_button_up[code];
 }
 
 bool user_input::mouse_wheel(event_handler::wheel w) const
 {
-	return false;
+	return w == event_handler::wheel::up ? _wheel > 0 : _wheel < 0;
 }
 
 void user_input::mode(input_mode m)
@@ -125,6 +186,7 @@ void user_input::mode(input_mode m)
 
 		glfwSetInputMode(_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 		glfwSetCursorPos(_window, _center.x, _center.y);
+		_cursor = _center;
 	}
 	else if (_mode == input_mode::window)
 	{
@@ -139,7 +201,7 @@ user_input::input_mode const & user_input::mode() const
 
 bool user_input::key(unsigned char c) const
 {
-	return _key[c] == GLFW_PRESS;
+	return _key[c];
 }
 
 bool user_input::key_up(unsigned char c) const
@@ -163,4 +225,27 @@ bool user_input::any_of_key_up(char const * keys) const
 	return false;
 }
 
+int button_code(event_handler::button b)
+{
+	switch (b)
+	{
+		case event_handler::button::left: return GLFW_MOUSE_BUTTON_LEFT;
+		case event_handler::button::right: return GLFW_MOUSE_BUTTON_RIGHT;
+		case event_handler::button::middle: return GLFW_MOUSE_BUTTON_MIDDLE;
+		default: return -1;  // unsupported button
+	}
+}
+
+event_handler::modifier to_modifier(int mods)
+{
+	int result = event_handler::none;
+	if (mods & GLFW_MOD_SHIFT)
+		result |= event_handler::shift;
+	if (mods & GLFW_MOD_CONTROL)
+		result |= event_handler::ctrl;
+	if (mods & GLFW_MOD_ALT)
+		result |= event_handler::alt;
+	return event_handler::modifier(result);
+}
+
 }}  // ui::glfw3
@@ -1,11 +1,22 @@
 #pragma once
+#include <bitset>
+#include <vector>
 #include <glm/vec2.hpp>
 #include <GLFW/glfw3.h>
 #include "gl/window.hpp"
 
 namespace ui { namespace glfw3 {
 
-class user_input  //!< mouse, keyboard and touch user input
+/*! Mouse, keyboard and touch user input.
+
+Input is collected by GLFW key, mouse button, cursor and scroll callbacks
+(during glfwPollEvents()) into state bitsets and an event queue, input()
+then publishes them as the current frame input. A key (button) pressed
+and released between two frames is reported as pressed and released in
+the next frame, so no press is lost at low frame rates.
+\note Callbacks are installed into the window by attach() and they refer to
+the user_input object, so it can't be copied or moved. */
+class user_input
 {
 public:
 	enum class input_mode
@@ -13,8 +24,26 @@ public:
 		camera, window
 	};
 
+	struct event  //!< input event in order of arrival
+	{
+		enum class type
+		{
+			key_down, key_up,
+			button_down, button_up,
+			wheel
+		};
+
+		type kind;
+		int code;  //!< GLFW key or mouse button code, wheel direction (1 up, -1 down)
+		event_handler::modifier mods;
+		glm::vec2 position;  //!< cursor position
+	};
+
 	user_input();
 	user_input(GLFWwindow * window, input_mode mode = input_mode::window);
+	~user_input();
+	void attach(GLFWwindow * window, input_mode mode = input_mode::window);  //!< installs window input callbacks
+	void detach();
 
 	// mouse
 	glm::vec2 const & mouse_position() const;
@@ -32,14 +61,35 @@ public:
 
 	// touch ...
 
-	void input(double dt);
+	std::vector<event> const & events() const;  //!< current frame events
+	void input(double dt);  //!< publishes input collected since the last call as the current frame input
+
+	user_input(user_input const &) = delete;
+	void operator=(user_input const &) = delete;
 
 private:
+	using key_set = std::bitset<GLFW_KEY_LAST+1>;
+	using button_set = std::bitset<GLFW_MOUSE_BUTTON_LAST+1>;
+
+	static void key_callback(GLFWwindow * window, int key, int scancode, int action, int mods);
+	static void mouse_button_callback(GLFWwindow * window, int button, int action, int mods);
+	static void cursor_position_callback(GLFWwindow * window, double x, double y);
+	static void scroll_callback(GLFWwindow * window, double dx, double dy);
+
+	// current frame input
 	glm::vec2 _mouse;
-	int _mouse_button[GLFW_MOUSE_BUTTON_LAST+1];  // GLFW_MOUSE_BUTTON_LEFT|RIGHT|MIDDLE
-	bool _mouse_button_up[GLFW_MOUSE_BUTTON_LAST+1];
-	int _key[GLFW_KEY_LAST];  // GLFW_PRESS|GLFW_RELEASE
-	bool _key_up[GLFW_KEY_LAST];
+	button_set _mouse_button, _mouse_button_up;
+	key_set _key, _key_up;
+	int _wheel;  //!< 1 up, -1 down, 0 not scrolled
+	std::vector<event> _events;
+
+	// collected by callbacks
+	glm::vec2 _cursor;
+	button_set _buttons_down, _buttons_pressed, _buttons_released;  //!< state and changes since the last frame
+	key_set _keys_down, _keys_pressed, _keys_released;
+	double _scroll;
+	std::vector<event> _pending;
+
 	GLFWwindow * _window;
 	input_mode _mode;
 	glm::vec2 _center;
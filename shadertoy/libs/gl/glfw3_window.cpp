@@ -39,11 +39,12 @@ glfw3_layer::glfw3_layer(parameters const & params)
 	glfwMakeContextCurrent(window);
 	glfw_detail::__glfw_window = window;
 
-	_in = user_input{window};
+	_in.attach(window);
 }
 
 glfw3_layer::~glfw3_layer()
 {
+	_in.detach();  // before window is destroyed
 	glfwTerminate();
 	glfw_detail::__glfw_window = nullptr;
 }
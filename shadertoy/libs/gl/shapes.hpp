@@ -31,7 +31,7 @@ public:
 	Mesh ellipse();  // TODO: implement
 	Mesh ellipsoid();  // 3d ellipse TODO: implement
 	Mesh pyramid();  // TODO: implement
-	Mesh torus();  // (kobliha) TODO: implement
+	Mesh torus(float R = 1.0f, float r = 0.25f, size_t segments = 30, size_t sides = 16);  //!< (kobliha)
 	Mesh annulus(float r1, float r2, size_t segments = 20);
 	Mesh ring(float r1, float r2, size_t segments = 20) {return annulus(r1, r2, segments);}
 };
@@ -76,6 +76,10 @@ Mesh make_circle_xy(float r = 1.0f, size_t segments = 20);
 template <typename Mesh>
 Mesh make_annulus(float r1, float r2, size_t segments = 20);
 
+//! vytvori torus (kobliha) zo stredom v bode (0,0,0) v rovine xz, R je polomer stredovej kruznice a r polomer trubice
+template <typename Mesh>
+Mesh make_torus(float R = 1.0f, float r = 0.25f, size_t segments = 30, size_t sides = 16);
+
 template <typename Mesh>
 Mesh make_quad_xy();  //!< (-1,-1), (1,1)
 
@@ -181,6 +185,12 @@ Mesh shape_generator<Mesh>::annulus(float r1, float r2, size_t segments)
 	return make_annulus<Mesh>(r1, r2, segments);
 }
 
+template <typename Mesh>
+Mesh shape_generator<Mesh>::torus(float R, float r, size_t segments, size_t sides)
+{
+	return make_torus<Mesh>(R, r, segments, sides);
+}
+
 
 template <typename Mesh>
 Mesh make_cube()
@@ -292,6 +302,64 @@ Mesh make_sphere(float r, size_t hsegments, size_t vsegments)
 	return m;
 }
 
+template <typename Mesh>
+Mesh make_torus(float R, float r, size_t segments, size_t sides)
+{
+	float du = 2.0*M_PI / (float)segments;  // okolo osi y
+	float dv = 2.0*M_PI / (float)sides;  // okolo trubice
+
+	std::vector<float> verts;  // position:3, texcoord:2, normal:3
+	for (size_t i = 0; i <= segments; ++i)
+	{
+		float u = i*du;
+		glm::vec3 c{cos(u), 0, sin(u)};  // smer k stredu trubice
+		for (size_t j = 0; j <= sides; ++j)
+		{
+			float v = j*dv;
+			glm::vec3 n{cos(v)*c.x, sin(v), cos(v)*c.z};
+			glm::vec3 p = R*c + r*n;
+			glm::vec2 uv{i/(float)segments, j/(float)sides};
+			verts.push_back(p.x);
+			verts.push_back(p.y);
+			verts.push_back(p.z);
+			verts.push_back(uv.x);
+			verts.push_back(uv.y);
+			verts.push_back(n.x);
+			verts.push_back(n.y);
+			verts.push_back(n.z);
+		}
+	}
+
+	std::vector<unsigned> inds;
+	for (size_t i = 0; i < segments; ++i)
+	{
+		for (size_t j = 0; j < sides; ++j)
+		{
+			unsigned a = i*(sides+1) + j,  // a, b na kruznici i; c, d na kruznici i+1
+				b = a + 1,
+				c = a + sides + 1,
+				d = c + 1;
+
+			inds.push_back(a);
+			inds.push_back(b);
+			inds.push_back(c);
+
+			inds.push_back(c);
+			inds.push_back(b);
+			inds.push_back(d);
+		}
+	}
+
+	Mesh m{verts.data(), verts.size()*sizeof(float), inds.data(), inds.size()};
+	unsigned stride = (3+2+3)*sizeof(GLfloat);
+	m.attach_attributes({
+		typename Mesh::vertex_attribute_type{0, 3, GL_FLOAT, stride, 0},  // position:3
+		typename Mesh::vertex_attribute_type{1, 2, GL_FLOAT, stride, 3*sizeof(GLfloat)},  // texcoord:2
+		typename Mesh::vertex_attribute_type{2, 3, GL_FLOAT, stride, (3+2)*sizeof(GLfloat)}});  // normal:3
+
+	return m;
+}
+
 template <typename Mesh>
 Mesh make_cylinder(float r, float h, size_t segments)
 {
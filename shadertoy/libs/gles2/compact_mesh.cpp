@@ -0,0 +1,646 @@
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cmath>
+#include <cassert>
+#include <glm/geometric.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "gl/opengl.hpp"
+#include "compact_mesh.hpp"
+
+#ifndef GL_HALF_FLOAT_OES
+	#define GL_HALF_FLOAT_OES 0x8D61
+#endif
+
+namespace gles2 {
+
+using std::vector;
+using std::min;
+using std::max;
+using std::initializer_list;
+using glm::vec2;
+using glm::vec3;
+using glm::mat4;
+
+static unsigned attribute_size(position_encoding e);
+static unsigned attribute_size(direction_encoding e);
+static unsigned attribute_size(uv_encoding e);
+static uint16_t float_to_half(float f);
+static int16_t float_to_snorm16(float f);
+static int8_t float_to_snorm8(float f);
+static uint16_t float_to_unorm16(float f);
+static vec2 octahedral_encode(vec3 const & n);
+static void put(uint8_t *& dst, void const * src, size_t size);
+static void pad(uint8_t *& dst, size_t size);
+static void encode_direction(uint8_t *& dst, vec3 const & d, direction_encoding e);
+
+char const * octahedral_decode_glsl = R"(
+	vec3 octahedral_decode(vec2 e)
+	{
+		vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+		if (n.z < 0.0)
+			n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		return normalize(n);
+	}
+)";
+
+unsigned vertex_layout::stride() const
+{
+	return attribute_size(position) + attribute_size(uv) + attribute_size(normal) + attribute_size(tangent);
+}
+
+size_t compact_mesh_data::index_count() const
+{
+	return short_indices.empty() ? indices.size() : short_indices.size();
+}
+
+size_t compact_mesh_data::index_bytes() const
+{
+	return short_indices.size()*sizeof(uint16_t) + indices.size()*sizeof(unsigned);
+}
+
+mat4 compact_mesh_data::position_transform() const
+{
+	return glm::scale(glm::translate(mat4{1}, position_offset), position_scale);
+}
+
+host_mesh::host_mesh(void const * vbuf, size_t vbuf_size, unsigned const * ibuf, size_t ibuf_size, buffer_usage)
+	: _vbuf{(uint8_t const *)vbuf, (uint8_t const *)vbuf + vbuf_size}
+	, _indices{ibuf, ibuf + ibuf_size}
+{}
+
+void host_mesh::attach_attributes(initializer_list<attribute> attribs)
+{
+	_attribs.assign(attribs);
+}
+
+void host_mesh::append_attribute(attribute const & a)
+{
+	_attribs.push_back(a);
+}
+
+void host_mesh::draw_mode(render_primitive_type mode)
+{
+	_draw_mode = mode;
+}
+
+vector<vertex> host_mesh::vertices() const
+{
+	if (_attribs.empty() || _attribs[0].stride == 0)
+		return {};
+
+	size_t count = _vbuf.size() / _attribs[0].stride;
+	vector<vertex> result(count, vertex{vec3{0}});
+
+	for (attribute const & a : _attribs)
+	{
+		if (a.type != GL_FLOAT || a.index > 3)
+			continue;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			float v[4] = {0, 0, 0, 0};
+			size_t offset = i*a.stride + a.start_idx;
+			assert(offset + a.size*sizeof(float) <= _vbuf.size() && "out of vertex buffer");
+			memcpy(v, _vbuf.data() + offset, min(a.size, 4)*sizeof(float));
+
+			vertex & vert = result[i];
+			switch (a.index)
+			{
+				case 0: vert.position = vec3{v[0], v[1], v[2]}; break;
+				case 1: vert.uv = vec2{v[0], v[1]}; break;
+				case 2: vert.normal = vec3{v[0], v[1], v[2]}; break;
+				case 3: vert.tangent = vec3{v[0], v[1], v[2]}; break;
+			}
+		}
+	}
+
+	return result;
+}
+
+vertex_layout select_vertex_layout(vector<vertex> const & verts, bool half_float)
+{
+	vertex_layout result;
+
+	bool uv_used = false, uv_unit = true,
+		normal_used = false, tangent_used = false;
+
+	for (vertex const & v : verts)
+	{
+		if (v.uv != vec2{0, 0})
+			uv_used = true;
+		if (v.uv.x < 0.0f || v.uv.x > 1.0f || v.uv.y < 0.0f || v.uv.y > 1.0f)
+			uv_unit = false;
+		if (v.normal != vec3{0, 0, 0})
+			normal_used = true;
+		if (v.tangent != vec3{0, 0, 0})
+			tangent_used = true;
+	}
+
+	result.position = position_encoding::snorm16x3;
+
+	if (!uv_used)
+		result.uv = uv_encoding::none;
+	else if (uv_unit)
+		result.uv = uv_encoding::unorm16x2;
+	else
+		result.uv = half_float ? uv_encoding::half2 : uv_encoding::float2;
+
+	result.normal = normal_used ? direction_encoding::octahedral16 : direction_encoding::none;
+	result.tangent = tangent_used ? direction_encoding::octahedral16 : direction_encoding::none;
+
+	return result;
+}
+
+void optimize_vertex_cache(vector<unsigned> & indices, size_t vertex_count, unsigned cache_size)
+{
+	// scoring constants from Tom Forsyth's article
+	float const cache_decay_power = 1.5f,
+		last_triangle_score = 0.75f,
+		valence_boost_scale = 2.0f,
+		valence_boost_power = 0.5f;
+
+	size_t const triangle_count = indices.size() / 3;
+	if (triangle_count < 2 || cache_size < 4)
+		return;
+
+	auto vertex_score = [&](int cache_pos, unsigned live_triangles) -> float {
+		if (live_triangles == 0)
+			return -1.0f;  // no triangles left
+
+		float score = 0.0f;
+		if (cache_pos >= 0)
+		{
+			if (cache_pos < 3)  // used by the last triangle
+				score = last_triangle_score;
+			else
+			{
+				float s = 1.0f - float(cache_pos - 3) / float(cache_size - 3);
+				score = pow(s, cache_decay_power);
+			}
+		}
+
+		return score + valence_boost_scale * pow(float(live_triangles), -valence_boost_power);
+	};
+
+	// vertex -> triangles adjacency
+	vector<unsigned> live(vertex_count, 0);
+	for (unsigned i : indices)
+		++live[i];
+
+	vector<unsigned> offsets(vertex_count + 1, 0);
+	for (size_t v = 0; v < vertex_count; ++v)
+		offsets[v+1] = offsets[v] + live[v];
+
+	vector<unsigned> adjacency(indices.size());
+	{
+		vector<unsigned> fill{offsets.begin(), offsets.end() - 1};
+		for (size_t i = 0; i < indices.size(); ++i)
+			adjacency[fill[indices[i]]++] = unsigned(i / 3);
+	}
+
+	vector<int> cache_pos(vertex_count, -1);
+	vector<float> vscore(vertex_count);
+	for (size_t v = 0; v < vertex_count; ++v)
+		vscore[v] = vertex_score(-1, live[v]);
+
+	vector<float> tscore(triangle_count);
+	for (size_t t = 0; t < triangle_count; ++t)
+		tscore[t] = vscore[indices[3*t]] + vscore[indices[3*t+1]] + vscore[indices[3*t+2]];
+
+	vector<bool> emitted(triangle_count, false);
+	vector<unsigned> result;
+	result.reserve(indices.size());
+
+	vector<unsigned> cache, new_cache;
+	cache.reserve(cache_size + 3);
+	new_cache.reserve(cache_size + 3);
+
+	size_t next_unemitted = 0;  // fallback scan position
+	int best = 0;
+	float best_score = tscore[0];
+	for (size_t t = 1; t < triangle_count; ++t)
+	{
+		if (tscore[t] > best_score)
+		{
+			best_score = tscore[t];
+			best = int(t);
+		}
+	}
+
+	while (best >= 0)
+	{
+		unsigned const * tri = &indices[3*best];
+		emitted[best] = true;
+		result.insert(result.end(), tri, tri + 3);
+
+		// remove triangle from adjacency of its vertices
+		for (int k = 0; k < 3; ++k)
+		{
+			unsigned v = tri[k];
+			unsigned * begin = &adjacency[offsets[v]];
+			unsigned * end = begin + live[v];
+			unsigned * it = std::find(begin, end, unsigned(best));
+			assert(it != end && "triangle not found in adjacency");
+			*it = *(end - 1);
+			--live[v];
+		}
+
+		// triangle vertices first, then the rest of the cache (LRU)
+		new_cache.assign(tri, tri + 3);
+		for (unsigned v : cache)
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				new_cache.push_back(v);
+
+		for (size_t i = 0; i < new_cache.size(); ++i)
+		{
+			unsigned v = new_cache[i];
+			cache_pos[v] = i < cache_size ? int(i) : -1;  // evicted vertices are updated as well
+			vscore[v] = vertex_score(cache_pos[v], live[v]);
+		}
+
+		if (new_cache.size() > cache_size)
+			new_cache.resize(cache_size);
+		std::swap(cache, new_cache);
+
+		// rescore triangles touched by cache vertices and find the best one
+		best = -1;
+		best_score = -1.0f;
+		for (unsigned v : cache)
+		{
+			for (unsigned j = offsets[v], e = offsets[v] + live[v]; j < e; ++j)
+			{
+				unsigned t = adjacency[j];
+				tscore[t] = vscore[indices[3*t]] + vscore[indices[3*t+1]] + vscore[indices[3*t+2]];
+				if (tscore[t] > best_score)
+				{
+					best_score = tscore[t];
+					best = int(t);
+				}
+			}
+		}
+
+		if (best < 0)  // nothing adjacent to the cache, take next not emitted triangle
+		{
+			while (next_unemitted < triangle_count && emitted[next_unemitted])
+				++next_unemitted;
+			best = next_unemitted < triangle_count ? int(next_unemitted) : -1;
+		}
+	}
+
+	assert(result.size() == triangle_count*3 && "not all triangles emitted");
+	std::copy(result.begin(), result.end(), indices.begin());  // trailing incomplete triangle (if any) is kept
+}
+
+void optimize_vertex_fetch(vector<vertex> & verts, vector<unsigned> & indices)
+{
+	unsigned const unused = std::numeric_limits<unsigned>::max();
+	vector<unsigned> remap(verts.size(), unused);
+	vector<vertex> result;
+	result.reserve(verts.size());
+
+	for (unsigned & i : indices)
+	{
+		if (remap[i] == unused)
+		{
+			remap[i] = unsigned(result.size());
+			result.push_back(verts[i]);
+		}
+		i = remap[i];
+	}
+
+	std::swap(verts, result);
+}
+
+double acmr(vector<unsigned> const & indices, unsigned cache_size)
+{
+	size_t const triangle_count = indices.size() / 3;
+	if (triangle_count == 0)
+		return 0.0;
+
+	vector<unsigned> fifo(cache_size, std::numeric_limits<unsigned>::max());
+	size_t head = 0, misses = 0;
+
+	for (size_t i = 0; i < triangle_count*3; ++i)
+	{
+		unsigned v = indices[i];
+		if (std::find(fifo.begin(), fifo.end(), v) == fifo.end())
+		{
+			fifo[head] = v;
+			head = (head + 1) % cache_size;
+			++misses;
+		}
+	}
+
+	return double(misses) / triangle_count;
+}
+
+compact_mesh_data compact_vertices(vector<vertex> verts, vector<unsigned> indices,
+	vertex_layout const & layout, bool optimize)
+{
+	if (optimize)
+	{
+		optimize_vertex_cache(indices, verts.size());
+		optimize_vertex_fetch(verts, indices);
+	}
+
+	compact_mesh_data result;
+	result.layout = layout;
+	result.vertex_count = verts.size();
+
+	// position bounds (uniform scale so normals are not skewed by the dequantization transform)
+	if (layout.position == position_encoding::snorm16x3 && !verts.empty())
+	{
+		vec3 lo = verts[0].position, hi = verts[0].position;
+		for (vertex const & v : verts)
+		{
+			lo = glm::min(lo, v.position);
+			hi = glm::max(hi, v.position);
+		}
+
+		vec3 half_extents = (hi - lo) * 0.5f;
+		float extent = max(max(half_extents.x, half_extents.y), half_extents.z);
+		result.position_offset = (lo + hi) * 0.5f;
+		result.position_scale = vec3{extent > 0.0f ? extent : 1.0f};
+	}
+
+	unsigned const stride = layout.stride();
+	result.vertices.resize(verts.size() * stride);
+	uint8_t * dst = result.vertices.data();
+
+	for (vertex const & v : verts)
+	{
+		switch (layout.position)
+		{
+			case position_encoding::float3:
+				put(dst, &v.position, 3*sizeof(float));
+				break;
+
+			case position_encoding::half3:
+			{
+				uint16_t h[3] = {float_to_half(v.position.x), float_to_half(v.position.y), float_to_half(v.position.z)};
+				put(dst, h, sizeof(h));
+				pad(dst, 2);
+				break;
+			}
+
+			case position_encoding::snorm16x3:
+			{
+				vec3 p = (v.position - result.position_offset) / result.position_scale;
+				int16_t q[3] = {float_to_snorm16(p.x), float_to_snorm16(p.y), float_to_snorm16(p.z)};
+				put(dst, q, sizeof(q));
+				pad(dst, 2);
+				break;
+			}
+		}
+
+		switch (layout.uv)
+		{
+			case uv_encoding::none:
+				break;
+
+			case uv_encoding::float2:
+				put(dst, &v.uv, 2*sizeof(float));
+				break;
+
+			case uv_encoding::half2:
+			{
+				uint16_t h[2] = {float_to_half(v.uv.x), float_to_half(v.uv.y)};
+				put(dst, h, sizeof(h));
+				break;
+			}
+
+			case uv_encoding::unorm16x2:
+			{
+				uint16_t q[2] = {float_to_unorm16(v.uv.x), float_to_unorm16(v.uv.y)};
+				put(dst, q, sizeof(q));
+				break;
+			}
+		}
+
+		encode_direction(dst, v.normal, layout.normal);
+		encode_direction(dst, v.tangent, layout.tangent);
+	}
+
+	assert(dst == result.vertices.data() + result.vertices.size() && "vertex layout size mismatch");
+
+	if (verts.size() <= 0x10000)  // 16-bit indices
+		result.short_indices.assign(indices.begin(), indices.end());
+	else
+		result.indices = std::move(indices);
+
+	// attributes
+	unsigned offset = 0;
+
+	switch (layout.position)
+	{
+		case position_encoding::float3:
+			result.attributes.emplace_back(0, 3, GL_FLOAT, stride, offset);
+			break;
+		case position_encoding::half3:
+			result.attributes.emplace_back(0, 3, GL_HALF_FLOAT_OES, stride, offset);
+			break;
+		case position_encoding::snorm16x3:
+			result.attributes.emplace_back(0, 3, GL_SHORT, stride, offset, GL_TRUE);
+			break;
+	}
+	offset += attribute_size(layout.position);
+
+	switch (layout.uv)
+	{
+		case uv_encoding::none:
+			break;
+		case uv_encoding::float2:
+			result.attributes.emplace_back(1, 2, GL_FLOAT, stride, offset);
+			break;
+		case uv_encoding::half2:
+			result.attributes.emplace_back(1, 2, GL_HALF_FLOAT_OES, stride, offset);
+			break;
+		case uv_encoding::unorm16x2:
+			result.attributes.emplace_back(1, 2, GL_UNSIGNED_SHORT, stride, offset, GL_TRUE);
+			break;
+	}
+	offset += attribute_size(layout.uv);
+
+	unsigned loc = 2;  // normal, tangent
+	for (direction_encoding e : {layout.normal, layout.tangent})
+	{
+		switch (e)
+		{
+			case direction_encoding::none:
+				break;
+			case direction_encoding::float3:
+				result.attributes.emplace_back(loc, 3, GL_FLOAT, stride, offset);
+				break;
+			case direction_encoding::snorm8x3:
+				result.attributes.emplace_back(loc, 3, GL_BYTE, stride, offset, GL_TRUE);
+				break;
+			case direction_encoding::octahedral16:
+				result.attributes.emplace_back(loc, 2, GL_SHORT, stride, offset, GL_TRUE);
+				break;
+		}
+		offset += attribute_size(e);
+		++loc;
+	}
+
+	return result;
+}
+
+mesh mesh_from_compact(compact_mesh_data const & data, buffer_usage usage)
+{
+	mesh m = data.short_indices.empty() ?
+		mesh{data.vertices.data(), data.vertices.size(), data.indices.data(), data.indices.size(), usage} :
+		mesh{data.vertices.data(), data.vertices.size(), data.short_indices.data(), data.short_indices.size(), usage};
+
+	for (attribute const & a : data.attributes)
+		m.append_attribute(a);
+
+	return m;
+}
+
+unsigned attribute_size(position_encoding e)
+{
+	switch (e)
+	{
+		case position_encoding::float3: return 12;
+		case position_encoding::half3:
+		case position_encoding::snorm16x3: return 8;  // padded to 4 bytes
+		default: return 0;
+	}
+}
+
+unsigned attribute_size(direction_encoding e)
+{
+	switch (e)
+	{
+		case direction_encoding::float3: return 12;
+		case direction_encoding::snorm8x3:
+		case direction_encoding::octahedral16: return 4;
+		default: return 0;
+	}
+}
+
+unsigned attribute_size(uv_encoding e)
+{
+	switch (e)
+	{
+		case uv_encoding::float2: return 8;
+		case uv_encoding::half2:
+		case uv_encoding::unorm16x2: return 4;
+		default: return 0;
+	}
+}
+
+void encode_direction(uint8_t *& dst, vec3 const & d, direction_encoding e)
+{
+	switch (e)
+	{
+		case direction_encoding::none:
+			break;
+
+		case direction_encoding::float3:
+			put(dst, &d, 3*sizeof(float));
+			break;
+
+		case direction_encoding::snorm8x3:
+		{
+			vec3 n = glm::length(d) > 0.0f ? glm::normalize(d) : d;
+			int8_t q[3] = {float_to_snorm8(n.x), float_to_snorm8(n.y), float_to_snorm8(n.z)};
+			put(dst, q, sizeof(q));
+			pad(dst, 1);
+			break;
+		}
+
+		case direction_encoding::octahedral16:
+		{
+			vec2 o = octahedral_encode(d);
+			int16_t q[2] = {float_to_snorm16(o.x), float_to_snorm16(o.y)};
+			put(dst, q, sizeof(q));
+			break;
+		}
+	}
+}
+
+vec2 octahedral_encode(vec3 const & n)
+{
+	float l1 = fabs(n.x) + fabs(n.y) + fabs(n.z);
+	if (l1 == 0.0f)
+		return vec2{0, 0};
+
+	vec3 p = n / l1;
+	if (p.z < 0.0f)
+	{
+		return vec2{
+			(1.0f - fabs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - fabs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f)};
+	}
+
+	return vec2{p.x, p.y};
+}
+
+// GLES2 maps signed normalized value c to (2c + 1)/(2^b - 1)
+int16_t float_to_snorm16(float f)
+{
+	float c = round((glm::clamp(f, -1.0f, 1.0f) * 65535.0f - 1.0f) * 0.5f);
+	return int16_t(glm::clamp(c, -32768.0f, 32767.0f));
+}
+
+int8_t float_to_snorm8(float f)
+{
+	float c = round((glm::clamp(f, -1.0f, 1.0f) * 255.0f - 1.0f) * 0.5f);
+	return int8_t(glm::clamp(c, -128.0f, 127.0f));
+}
+
+uint16_t float_to_unorm16(float f)
+{
+	return uint16_t(round(glm::clamp(f, 0.0f, 1.0f) * 65535.0f));
+}
+
+uint16_t float_to_half(float f)
+{
+	uint32_t x;
+	memcpy(&x, &f, sizeof(x));
+
+	uint16_t sign = (x >> 16) & 0x8000;
+	int exponent = int((x >> 23) & 0xff);
+	uint32_t mantissa = x & 0x7fffff;
+
+	if (exponent == 0xff)  // inf, nan
+		return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+
+	exponent = exponent - 127 + 15;
+	if (exponent >= 31)  // overflow
+		return sign | 0x7c00;
+
+	if (exponent <= 0)  // denormal
+	{
+		if (exponent < -10)
+			return sign;
+
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		uint32_t h = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)  // round
+			++h;
+		return sign | uint16_t(h);
+	}
+
+	uint32_t h = (uint32_t(exponent) << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000)  // round, carry can propagate into exponent
+		++h;
+	return sign | uint16_t(h);
+}
+
+void put(uint8_t *& dst, void const * src, size_t size)
+{
+	memcpy(dst, src, size);
+	dst += size;
+}
+
+void pad(uint8_t *& dst, size_t size)
+{
+	memset(dst, 0, size);
+	dst += size;
+}
+
+}  // gles2
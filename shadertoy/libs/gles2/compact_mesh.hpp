@@ -0,0 +1,118 @@
+// compact (quantized and cache optimized) mesh pipeline
+#pragma once
+#include <vector>
+#include <initializer_list>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include "gles2/mesh_gles2.hpp"
+
+namespace gles2 {
+
+enum class position_encoding {
+	float3,  //!< 12 bytes
+	half3,  //!< 8 bytes (padded), needs OES_vertex_half_float extension
+	snorm16x3  //!< 8 bytes (padded), normalized to mesh bounds \sa compact_mesh_data::position_transform()
+};
+
+enum class direction_encoding {  //!< normal and tangent encoding
+	none,  //!< not stored
+	float3,  //!< 12 bytes
+	snorm8x3,  //!< 4 bytes (padded)
+	octahedral16  //!< 4 bytes, decoded by octahedral_decode_glsl in a vertex shader
+};
+
+enum class uv_encoding {
+	none,  //!< not stored
+	float2,  //!< 8 bytes
+	half2,  //!< 4 bytes, needs OES_vertex_half_float extension
+	unorm16x2  //!< 4 bytes, uv coordinates need to be in [0,1] range
+};
+
+//! per attribute vertex encoding, attribute locations match mesh_from_vertices() (position:0, uv:1, normal:2, tangent:3)
+struct vertex_layout
+{
+	position_encoding position = position_encoding::snorm16x3;
+	uv_encoding uv = uv_encoding::unorm16x2;
+	direction_encoding normal = direction_encoding::octahedral16;
+	direction_encoding tangent = direction_encoding::none;
+
+	unsigned stride() const;  //!< vertex size in bytes
+};
+
+//! packed vertex and index buffers \sa compact_vertices()
+struct compact_mesh_data
+{
+	vertex_layout layout;
+	std::vector<uint8_t> vertices;
+	std::vector<uint16_t> short_indices;  //!< used if all vertices are addressable by 16-bit index
+	std::vector<unsigned> indices;  //!< otherwise
+	std::vector<attribute> attributes;
+	size_t vertex_count = 0;
+	glm::vec3 position_offset = glm::vec3{0},  //!< position = decoded*position_scale + position_offset
+		position_scale = glm::vec3{1};
+
+	size_t index_count() const;
+	size_t vertex_bytes() const {return vertices.size();}
+	size_t index_bytes() const;
+	glm::mat4 position_transform() const;  //!< dequantization transform, multiply model matrix with it
+};
+
+/*! CPU side mesh with the same construction interface as mesh, it captures
+float vertex data of generated shapes (so they can be compacted).
+\code
+auto sphere = gl::make_sphere<gles2::host_mesh>(1.0f, 64, 48);
+gles2::mesh m = gles2::mesh_from_compact(
+	gles2::compact_vertices(sphere.vertices(), sphere.indices(), gles2::vertex_layout{}));
+\endcode */
+class host_mesh
+{
+public:
+	using vertex_attribute_type = attribute;
+	using render_primitive_type = render_primitive;
+
+	host_mesh() {}
+	host_mesh(void const * vbuf, size_t vbuf_size, unsigned const * ibuf, size_t ibuf_size, buffer_usage usage = buffer_usage::static_draw);
+	void attach_attributes(std::initializer_list<attribute> attribs);
+	void append_attribute(attribute const & a);
+	void draw_mode(render_primitive_type mode);
+	render_primitive_type draw_mode() const {return _draw_mode;}
+	std::vector<vertex> vertices() const;  //!< decodes GL_FLOAT attributes with mesh_from_vertices() locations
+	std::vector<unsigned> const & indices() const {return _indices;}
+	std::vector<attribute> const & attributes() const {return _attribs;}
+	void const * vertex_data() const {return _vbuf.data();}
+	size_t vertex_bytes() const {return _vbuf.size();}
+	size_t index_bytes() const {return _indices.size()*sizeof(unsigned);}
+
+private:
+	std::vector<uint8_t> _vbuf;
+	std::vector<unsigned> _indices;
+	std::vector<attribute> _attribs;
+	render_primitive_type _draw_mode = render_primitive::triangles;
+};
+
+//! selects the most compact layout for verts which can represent them (uv range, used attributes)
+vertex_layout select_vertex_layout(std::vector<vertex> const & verts, bool half_float = false);
+
+/*! reorders triangles for post-transform vertex cache locality (Tom Forsyth's
+linear-speed vertex cache optimisation), cache_size is modelled LRU cache size */
+void optimize_vertex_cache(std::vector<unsigned> & indices, size_t vertex_count, unsigned cache_size = 32);
+
+/*! reorders vertices in the order of first use by indices (to improve vertex
+fetch locality), unreferenced vertices are removed */
+void optimize_vertex_fetch(std::vector<vertex> & verts, std::vector<unsigned> & indices);
+
+//! average cache miss ratio (transformed vertices per triangle) for FIFO vertex cache of cache_size
+double acmr(std::vector<unsigned> const & indices, unsigned cache_size = 16);
+
+/*! packs triangle list verts and indices into layout, with optimize enabled
+triangles and vertices are reordered first \sa optimize_vertex_cache(), optimize_vertex_fetch() */
+compact_mesh_data compact_vertices(std::vector<vertex> verts, std::vector<unsigned> indices,
+	vertex_layout const & layout, bool optimize = true);
+
+mesh mesh_from_compact(compact_mesh_data const & data, buffer_usage usage = buffer_usage::static_draw);
+
+//! GLSL `vec3 octahedral_decode(vec2 e)` function for direction_encoding::octahedral16 attributes
+extern char const * octahedral_decode_glsl;
+
+}  // gles2
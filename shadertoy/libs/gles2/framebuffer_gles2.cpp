@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+#include "gl/opengl.hpp"
+#include "framebuffer_gles2.hpp"
+#include "gpu_memory.hpp"
+
+namespace gles2 {
+
+using std::swap;
+
+framebuffer::framebuffer(unsigned width, unsigned height, bool depth)
+	: _fid{0}
+	, _depth_rid{0}
+	, _color{width, height, pixel_format::rgba, pixel_type::ub8}
+{
+	glGenFramebuffers(1, &_fid);
+	glBindFramebuffer(GL_FRAMEBUFFER, _fid);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _color.id(), 0);
+
+	if (depth)
+	{
+		glGenRenderbuffers(1, &_depth_rid);
+		glBindRenderbuffer(GL_RENDERBUFFER, _depth_rid);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depth_rid);
+		gpu_memory::instance().allocate(gpu_memory_category::renderbuffer, _depth_rid, size_t(width) * height * 2);  // 16bit depth
+	}
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		gpu_memory::instance().free(gpu_memory_category::renderbuffer, _depth_rid);
+		glDeleteRenderbuffers(1, &_depth_rid);
+		glDeleteFramebuffers(1, &_fid);
+		throw std::runtime_error{"incomplete framebuffer"};
+	}
+}
+
+framebuffer::framebuffer(framebuffer && lhs)
+	: _fid{lhs._fid}
+	, _depth_rid{lhs._depth_rid}
+	, _color{std::move(lhs._color)}
+{
+	lhs._fid = lhs._depth_rid = 0;
+}
+
+framebuffer::~framebuffer()
+{
+	gpu_memory::instance().free(gpu_memory_category::renderbuffer, _depth_rid);
+	glDeleteRenderbuffers(1, &_depth_rid);
+	glDeleteFramebuffers(1, &_fid);
+}
+
+void framebuffer::bind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, _fid);
+	glViewport(0, 0, width(), height());
+}
+
+void framebuffer::unbind()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void framebuffer::read_pixels(unsigned x, unsigned y, unsigned w, unsigned h, void * pixels) const
+{
+	assert(x + w <= width() && y + h <= height() && "out of framebuffer");
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	assert(glGetError() == GL_NO_ERROR && "opengl error");
+}
+
+void framebuffer::operator=(framebuffer && lhs)
+{
+	swap(_fid, lhs._fid);
+	swap(_depth_rid, lhs._depth_rid);
+	_color = std::move(lhs._color);
+}
+
+}  // gles2
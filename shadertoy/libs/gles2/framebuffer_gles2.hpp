@@ -0,0 +1,40 @@
+#pragma once
+#include "texture_gles2.hpp"
+
+namespace gles2 {
+
+/*! Off-screen render target with RGBA color texture and optional depth buffer.
+\code
+framebuffer fb{512, 512};
+fb.bind();
+// render ...
+fb.read_pixels(0, 0, 512, 512, pixels);
+fb.unbind();
+\endcode */
+class framebuffer
+{
+public:
+	framebuffer(unsigned width, unsigned height, bool depth = false);
+	framebuffer(framebuffer && lhs);
+	~framebuffer();
+	void bind();  //!< renders into framebuffer, sets full framebuffer viewport
+	void unbind();  //!< renders into window
+	unsigned width() const {return _color.width();}
+	unsigned height() const {return _color.height();}
+	texture2d & color() {return _color;}
+
+	//! reads RGBA pixels from (x,y) (bottom-left) area into pixels (w*h*4 bytes), framebuffer needs to be bound
+	void read_pixels(unsigned x, unsigned y, unsigned w, unsigned h, void * pixels) const;
+
+	void operator=(framebuffer && lhs);
+
+	framebuffer(framebuffer const &) = delete;
+	void operator=(framebuffer const &) = delete;
+
+private:
+	unsigned _fid;  //!< \sa glGenFramebuffers()
+	unsigned _depth_rid;  //!< depth renderbuffer, 0 if not used
+	texture2d _color;
+};
+
+}  // gles2
@@ -0,0 +1,210 @@
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include "gpu_memory.hpp"
+
+namespace gles2 {
+
+using std::string;
+using std::ostream;
+using std::ostringstream;
+using std::lock_guard;
+using std::mutex;
+using std::max;
+
+static string format_bytes(size_t bytes);
+static string json_quote(string const & s);
+
+char const * to_string(gpu_memory_category c)
+{
+	switch (c)
+	{
+		case gpu_memory_category::texture: return "texture";
+		case gpu_memory_category::buffer: return "buffer";
+		case gpu_memory_category::renderbuffer: return "renderbuffer";
+		default: return "unknown";
+	}
+}
+
+gpu_memory & gpu_memory::instance()
+{
+	static gpu_memory * result = new gpu_memory;  // never destroyed, objects can be freed from static destructors
+	return *result;
+}
+
+void gpu_memory::allocate(gpu_memory_category c, unsigned id, size_t bytes)
+{
+	if (id == 0)
+		return;
+
+	lock_guard<mutex> lock{_lock};
+
+	gpu_memory_stats & s = _stats[size_t(c)];
+	auto it = _allocations.find({c, id});
+	if (it != _allocations.end())  // resize
+	{
+		s.bytes -= it->second.bytes;
+		_total -= it->second.bytes;
+		it->second.bytes = bytes;
+	}
+	else
+	{
+		_allocations.emplace(std::make_pair(c, id), allocation{bytes, string{}});
+		++s.count;
+	}
+
+	s.bytes += bytes;
+	s.peak = max(s.peak, s.bytes);
+	_total += bytes;
+	_peak = max(_peak, _total);
+}
+
+void gpu_memory::free(gpu_memory_category c, unsigned id)
+{
+	if (id == 0)
+		return;
+
+	lock_guard<mutex> lock{_lock};
+
+	auto it = _allocations.find({c, id});
+	if (it == _allocations.end())
+		return;
+
+	gpu_memory_stats & s = _stats[size_t(c)];
+	s.bytes -= it->second.bytes;
+	--s.count;
+	_total -= it->second.bytes;
+	_allocations.erase(it);
+}
+
+void gpu_memory::label(gpu_memory_category c, unsigned id, string const & name)
+{
+	lock_guard<mutex> lock{_lock};
+	auto it = _allocations.find({c, id});
+	if (it != _allocations.end())
+		it->second.label = name;
+}
+
+gpu_memory_stats gpu_memory::stats(gpu_memory_category c) const
+{
+	lock_guard<mutex> lock{_lock};
+	return _stats[size_t(c)];
+}
+
+size_t gpu_memory::total() const
+{
+	lock_guard<mutex> lock{_lock};
+	return _total;
+}
+
+size_t gpu_memory::peak() const
+{
+	lock_guard<mutex> lock{_lock};
+	return _peak;
+}
+
+string gpu_memory::summary() const
+{
+	lock_guard<mutex> lock{_lock};
+
+	ostringstream out;
+	for (size_t i = 0; i < size_t(gpu_memory_category::count); ++i)
+	{
+		gpu_memory_stats const & s = _stats[i];
+		out << to_string(gpu_memory_category(i)) << " " << format_bytes(s.bytes) << " (" << s.count << "), ";
+	}
+	out << "peak " << format_bytes(_peak);
+
+	return out.str();
+}
+
+void gpu_memory::write_json(ostream & out) const
+{
+	lock_guard<mutex> lock{_lock};
+
+	out << "{\n"
+		<< "  \"total\": " << _total << ",\n"
+		<< "  \"peak\": " << _peak << ",\n"
+		<< "  \"categories\": {";
+
+	for (size_t i = 0; i < size_t(gpu_memory_category::count); ++i)
+	{
+		gpu_memory_stats const & s = _stats[i];
+		out << (i > 0 ? "," : "") << "\n    " << json_quote(to_string(gpu_memory_category(i)))
+			<< ": {\"bytes\": " << s.bytes << ", \"peak\": " << s.peak << ", \"count\": " << s.count << "}";
+	}
+
+	out << "\n  },\n"
+		<< "  \"allocations\": [";
+
+	bool first = true;
+	for (auto const & kv : _allocations)
+	{
+		out << (first ? "" : ",") << "\n    {\"category\": " << json_quote(to_string(kv.first.first))
+			<< ", \"id\": " << kv.first.second
+			<< ", \"bytes\": " << kv.second.bytes
+			<< ", \"label\": " << json_quote(kv.second.label) << "}";
+		first = false;
+	}
+
+	out << "\n  ]\n}" << std::endl;
+}
+
+size_t gpu_memory::report_leaks(ostream & out) const
+{
+	lock_guard<mutex> lock{_lock};
+
+	for (auto const & kv : _allocations)
+	{
+		out << "leak: " << to_string(kv.first.first) << " " << kv.first.second << ", "
+			<< format_bytes(kv.second.bytes);
+		if (!kv.second.label.empty())
+			out << " '" << kv.second.label << "'";
+		out << "\n";
+	}
+
+	if (!_allocations.empty())
+		out << _allocations.size() << " GPU object(s) never freed, " << format_bytes(_total) << std::endl;
+
+	return _allocations.size();
+}
+
+string format_bytes(size_t bytes)
+{
+	ostringstream out;
+	if (bytes >= (size_t{1} << 20))
+		out << std::fixed << std::setprecision(1) << bytes / double(1 << 20) << " MiB";
+	else if (bytes >= 1024)
+		out << std::fixed << std::setprecision(1) << bytes / 1024.0 << " KiB";
+	else
+		out << bytes << " B";
+	return out.str();
+}
+
+string json_quote(string const & s)
+{
+	string result = "\"";
+	for (char c : s)
+	{
+		switch (c)
+		{
+			case '"': result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			case '\n': result += "\\n"; break;
+			case '\t': result += "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20)
+				{
+					char buf[8];
+					snprintf(buf, sizeof(buf), "\\u%04x", c);
+					result += buf;
+				}
+				else
+					result += c;
+		}
+	}
+	return result + "\"";
+}
+
+}  // gles2
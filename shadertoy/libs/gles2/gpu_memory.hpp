@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <cstddef>
+
+namespace gles2 {
+
+enum class gpu_memory_category
+{
+	texture,
+	buffer,
+	renderbuffer,
+	count
+};
+
+char const * to_string(gpu_memory_category c);
+
+struct gpu_memory_stats
+{
+	size_t bytes = 0;  //!< currently allocated
+	size_t peak = 0;
+	size_t count = 0;  //!< number of live allocations
+};
+
+/*! Global (thread-safe) accountant of GPU memory allocated by texture2d,
+gpu_buffer and framebuffer objects.
+
+Allocations are tracked by (category, OpenGL object id) with estimated size
+(e.g. width*height*pixel size for textures, driver padding and mipmaps are
+not included).
+\note Objects of unshared contexts can share ids, which is not handled.
+\code
+gles2::gpu_memory & mem = gles2::gpu_memory::instance();
+cout << mem.summary() << "\n";
+// at exit, after GL objects are destroyed
+mem.report_leaks(cerr);
+\endcode */
+class gpu_memory
+{
+public:
+	static gpu_memory & instance();
+
+	void allocate(gpu_memory_category c, unsigned id, size_t bytes);  //!< registers (or resizes) id allocation
+	void free(gpu_memory_category c, unsigned id);
+	void label(gpu_memory_category c, unsigned id, std::string const & name);  //!< names allocation for reports
+
+	gpu_memory_stats stats(gpu_memory_category c) const;
+	size_t total() const;  //!< currently allocated bytes in all categories
+	size_t peak() const;  //!< maximal total
+
+	std::string summary() const;  //!< one line human readable summary, e.g. `texture 12.5 MiB (8), buffer 64 KiB (2), peak 20 MiB`
+	void write_json(std::ostream & out) const;  //!< totals, peaks and live allocations as JSON object
+	size_t report_leaks(std::ostream & out) const;  //!< lists live allocations, returns their number
+
+private:
+	struct allocation
+	{
+		size_t bytes;
+		std::string label;
+	};
+
+	gpu_memory() {}
+
+	std::map<std::pair<gpu_memory_category, unsigned>, allocation> _allocations;
+	gpu_memory_stats _stats[size_t(gpu_memory_category::count)];
+	size_t _total = 0, _peak = 0;
+	mutable std::mutex _lock;
+};
+
+}  // gles2
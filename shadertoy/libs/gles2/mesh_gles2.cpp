@@ -5,6 +5,7 @@
 #include <cassert>
 #include "gl/opengl.hpp"
 #include "mesh_gles2.hpp"
+#include "gpu_memory.hpp"
 
 using std::swap;
 using std::move;
@@ -18,6 +19,7 @@ namespace gles2 {
 GLenum opengl_cast(buffer_usage u);
 GLenum opengl_cast(buffer_target t);
 GLenum opengl_cast(render_primitive p);
+static bool fits_short_indices(unsigned const * ibuf, size_t size);
 
 gpu_buffer::gpu_buffer(buffer_target target, size_t size, buffer_usage usage)
 {
@@ -26,6 +28,7 @@ gpu_buffer::gpu_buffer(buffer_target target, size_t size, buffer_usage usage)
 	glBindBuffer(t, _id);
 	glBufferData(t, size, nullptr, opengl_cast(usage));
 	glBindBuffer(t, 0);  // unbind
+	gpu_memory::instance().allocate(gpu_memory_category::buffer, _id, size);
 	assert(glGetError() == GL_NO_ERROR && "opengl error");
 }
 
@@ -36,6 +39,7 @@ gpu_buffer::gpu_buffer(buffer_target target, void const * buf, size_t size, buff
 	glBindBuffer(t, _id);
 	glBufferData(t, size, buf, opengl_cast(usage));
 	glBindBuffer(t, 0);  // unbind
+	gpu_memory::instance().allocate(gpu_memory_category::buffer, _id, size);
 	assert(glGetError() == GL_NO_ERROR && "opengl error");
 }
 
@@ -53,7 +57,10 @@ void gpu_buffer::operator=(gpu_buffer && other)
 gpu_buffer::~gpu_buffer()
 {
 	if (_id)
+	{
+		gpu_memory::instance().free(gpu_memory_category::buffer, _id);
 		glDeleteBuffers(1, &_id);
+	}
 	assert(glGetError() == GL_NO_ERROR && "opengl error");
 }
 
@@ -67,6 +74,17 @@ void gpu_buffer::data(buffer_target target, void const * buf, size_t size, unsig
 	assert(glGetError() == GL_NO_ERROR && "opengl error");
 }
 
+void gpu_buffer::orphan(buffer_target target, size_t size, buffer_usage usage)
+{
+	assert(_id && "uninitialized buffer");
+	GLenum t = opengl_cast(target);
+	glBindBuffer(t, _id);
+	glBufferData(t, size, nullptr, opengl_cast(usage));
+	glBindBuffer(t, 0);
+	gpu_memory::instance().allocate(gpu_memory_category::buffer, _id, size);  // resize
+	assert(glGetError() == GL_NO_ERROR && "opengl error");
+}
+
 unsigned gpu_buffer::id() const
 {
 	return _id;
@@ -79,22 +97,36 @@ void gpu_buffer::bind(buffer_target target) const
 	assert(glGetError() == GL_NO_ERROR && "opengl error");
 }
 
+void gpu_buffer::label(std::string const & name)
+{
+	gpu_memory::instance().label(gpu_memory_category::buffer, _id, name);
+}
+
 attribute::attribute(unsigned index, int size, int type, unsigned stride, int start_idx, int normalized)
 	: index{index}, size{size}, type{type}, normalized{normalized}, stride{stride}, start_idx{start_idx}
 {}
 
+mesh::mesh()
+	: _nindices{0}, _index_type{GL_UNSIGNED_SHORT}, _draw_mode{GL_TRIANGLES}
+{}
+
 mesh::mesh(size_t vbuf_size_in_bytes, size_t index_count, buffer_usage usage)
-	: _vbuf{buffer_target::array, vbuf_size_in_bytes, usage}, _ibuf(buffer_target::element_array, index_count*sizeof(unsigned), usage), _nindices{index_count}, _draw_mode{GL_TRIANGLES}
+	: _vbuf{buffer_target::array, vbuf_size_in_bytes, usage}, _ibuf(buffer_target::element_array, index_count*sizeof(unsigned), usage), _nindices{index_count}, _index_type{GL_UNSIGNED_INT}, _draw_mode{GL_TRIANGLES}
 {}
 
 mesh::mesh(void const * vbuf, size_t vbuf_size, unsigned const * ibuf, size_t ibuf_size, buffer_usage usage)
-	: _vbuf{buffer_target::array, vbuf, vbuf_size, usage}, _ibuf(buffer_target::element_array, ibuf, ibuf_size*sizeof(unsigned), usage), _nindices{ibuf_size}, _draw_mode{GL_TRIANGLES}
+	: _vbuf{buffer_target::array, vbuf, vbuf_size, usage}, _ibuf(buffer_target::element_array, ibuf, ibuf_size*sizeof(unsigned), usage), _nindices{ibuf_size}, _index_type{GL_UNSIGNED_INT}, _draw_mode{GL_TRIANGLES}
+{}
+
+mesh::mesh(void const * vbuf, size_t vbuf_size, uint16_t const * ibuf, size_t ibuf_size, buffer_usage usage)
+	: _vbuf{buffer_target::array, vbuf, vbuf_size, usage}, _ibuf(buffer_target::element_array, ibuf, ibuf_size*sizeof(uint16_t), usage), _nindices{ibuf_size}, _index_type{GL_UNSIGNED_SHORT}, _draw_mode{GL_TRIANGLES}
 {}
 
 mesh::mesh(mesh && other)
 	: _vbuf{move(other._vbuf)}
 	, _ibuf{move(other._ibuf)}
 	, _nindices{other._nindices}
+	, _index_type{other._index_type}
 	, _draw_mode{other._draw_mode}
 {
 	swap(_attribs, other._attribs);
@@ -103,6 +135,7 @@ mesh::mesh(mesh && other)
 void mesh::operator=(mesh && other)
 {
 	swap(_nindices, other._nindices);
+	swap(_index_type, other._index_type);
 	swap(_attribs, other._attribs);
 	_vbuf = move(other._vbuf);
 	_ibuf = move(other._ibuf);
@@ -111,30 +144,7 @@ void mesh::operator=(mesh && other)
 
 void mesh::render() const
 {
-	_vbuf.bind(buffer_target::array);
-
-	for (attribute const & a : _attribs)
-	{
-		if (a.index == -1)  // invalid attribute (missing in shader program)
-			continue;
-
-		glEnableVertexAttribArray(a.index);
-		glVertexAttribPointer(a.index, a.size, a.type, a.normalized, a.stride, (GLvoid *)(intptr_t)a.start_idx);
-
-		assert(glGetError() == GL_NO_ERROR && "opengl error");
-	}
-
-	_ibuf.bind(buffer_target::element_array);
-
-	glDrawElements(_draw_mode, _nindices, GL_UNSIGNED_INT, 0);
-
-	for (attribute const & a : _attribs)
-	{
-		if (a.index != -1)  // only valid attributes
-			glDisableVertexAttribArray(a.index);
-	}
-
-	assert(glGetError() == GL_NO_ERROR && "opengl error");
+	detail::draw_elements(_vbuf, 0, _attribs, _ibuf, 0, _nindices, _index_type, _draw_mode);
 }
 
 void mesh::attach_attributes(std::initializer_list<attribute> attribs)
@@ -165,7 +175,15 @@ void mesh::data(void const * vbuf, unsigned vbuf_size, unsigned const * ibuf, un
 void mesh::data(void const * vsubbuf, unsigned vsubbuf_size, unsigned vsubbuf_offset, unsigned const * isubbuf, unsigned isubbuf_size, unsigned isubbuf_offset)
 {
 	_vbuf.data(buffer_target::array, vsubbuf, vsubbuf_size, vsubbuf_offset);
-	_ibuf.data(buffer_target::element_array, isubbuf, isubbuf_size*sizeof(unsigned), isubbuf_offset);
+
+	if (_index_type == GL_UNSIGNED_SHORT)
+	{
+		assert(fits_short_indices(isubbuf, isubbuf_size) && "index out of 16-bit range");
+		vector<uint16_t> indices{isubbuf, isubbuf + isubbuf_size};
+		_ibuf.data(buffer_target::element_array, indices.data(), isubbuf_size*sizeof(uint16_t), isubbuf_offset/2);  // offset in bytes of 32-bit indices
+	}
+	else
+		_ibuf.data(buffer_target::element_array, isubbuf, isubbuf_size*sizeof(unsigned), isubbuf_offset);
 }
 
 void mesh::attribute_location(unsigned attr_idx, int loc_value)
@@ -182,6 +200,16 @@ void mesh::attribute_location(initializer_list<int> locations)
 		_attribs[idx].index = *it;
 }
 
+bool mesh::short_indices() const
+{
+	return _index_type == GL_UNSIGNED_SHORT;
+}
+
+size_t mesh::index_count() const
+{
+	return _nindices;
+}
+
 
 mesh mesh_from_vertices(std::vector<vertex> const & verts, std::vector<unsigned> const & indices)
 {
@@ -204,7 +232,15 @@ mesh mesh_from_vertices(std::vector<vertex> const & verts, std::vector<unsigned>
 		*fptr++ = v.tangent.z;
 	}
 
-	mesh m(vbuf.data(), vbuf.size()*sizeof(float), indices.data(), indices.size());
+	mesh m;
+	if (verts.size() <= 0x10000)  // 16-bit indices
+	{
+		vector<uint16_t> short_indices{indices.begin(), indices.end()};
+		m = mesh(vbuf.data(), vbuf.size()*sizeof(float), short_indices.data(), short_indices.size());
+	}
+	else
+		m = mesh(vbuf.data(), vbuf.size()*sizeof(float), indices.data(), indices.size());
+
 	// TODO: vertex by mal poskytnut attributy
 	unsigned stride = (3+2+3+3)*sizeof(GLfloat);
 	m.append_attribute(attribute{0, 3, GL_FLOAT, stride});  // position
@@ -215,6 +251,43 @@ mesh mesh_from_vertices(std::vector<vertex> const & verts, std::vector<unsigned>
 	return m;
 }
 
+namespace detail {
+
+void draw_elements(gpu_buffer const & vbuf, size_t voffset, vector<attribute> const & attribs,
+	gpu_buffer const & ibuf, size_t ioffset, size_t count, int index_type, int draw_mode)
+{
+	vbuf.bind(buffer_target::array);
+
+	for (attribute const & a : attribs)
+	{
+		if (a.index == -1)  // invalid attribute (missing in shader program)
+			continue;
+
+		glEnableVertexAttribArray(a.index);
+		glVertexAttribPointer(a.index, a.size, a.type, a.normalized, a.stride, (GLvoid *)(intptr_t)(voffset + a.start_idx));
+
+		assert(glGetError() == GL_NO_ERROR && "opengl error");
+	}
+
+	ibuf.bind(buffer_target::element_array);
+
+	glDrawElements(draw_mode, count, index_type, (GLvoid *)(intptr_t)ioffset);
+
+	for (attribute const & a : attribs)
+	{
+		if (a.index != -1)  // only valid attributes
+			glDisableVertexAttribArray(a.index);
+	}
+
+	assert(glGetError() == GL_NO_ERROR && "opengl error");
+}
+
+}  // detail
+
+bool fits_short_indices(unsigned const * ibuf, size_t size)
+{
+	return std::all_of(ibuf, ibuf + size, [](unsigned i){return i <= 0xffff;});
+}
 
 GLenum opengl_cast(buffer_usage u)
 {
@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <cstdint>
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
 
@@ -56,8 +57,13 @@ public:
 	gpu_buffer(gpu_buffer && other);
 	~gpu_buffer();
 	void data(buffer_target target, void const * buf, size_t size, unsigned offset = 0);
+
+	/*! reallocates buffer storage (content is undefined after), draws in flight
+	keep using the previous storage so the call does not wait for them */
+	void orphan(buffer_target target, size_t size, buffer_usage usage);
 	unsigned id() const;
 	void bind(buffer_target target) const;  // TODO: bind() with native parameter
+	void label(std::string const & name);  //!< names buffer in GPU memory reports \sa gpu_memory
 	void operator=(gpu_buffer && other);
 
 	gpu_buffer(gpu_buffer const &) = delete;
@@ -85,9 +91,13 @@ public:
 	using vertex_attribute_type = attribute;
 	using render_primitive_type = render_primitive;
 
-	mesh() {}
+	mesh();
 	mesh(size_t vbuf_size_in_bytes, size_t index_count, buffer_usage usage = buffer_usage::static_draw);
+
+	/*! creates mesh from vertex and index buffers (ibuf_size is number of indices),
+	GLES2 supports 32-bit indices only with OES_element_index_uint extension */
 	mesh(void const * vbuf, size_t vbuf_size, unsigned const * ibuf, size_t ibuf_size, buffer_usage usage = buffer_usage::static_draw);
+	mesh(void const * vbuf, size_t vbuf_size, uint16_t const * ibuf, size_t ibuf_size, buffer_usage usage = buffer_usage::static_draw);
 	mesh(mesh && other);
 	virtual ~mesh() {}
 	void render() const;
@@ -100,6 +110,8 @@ public:
 	void operator=(mesh && other);
 	void attribute_location(unsigned attr_idx, int loc_value);  //!< sets attribute location
 	void attribute_location(std::initializer_list<int> locations);
+	bool short_indices() const;  //!< true for 16-bit indices
+	size_t index_count() const;
 
 	mesh(mesh const &) = delete;
 	void operator=(mesh const &) = delete;
@@ -107,6 +119,7 @@ public:
 private:
 	gpu_buffer _vbuf, _ibuf;  //!< vertex and index buffers
 	size_t _nindices;
+	int _index_type;  //!< GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
 	std::vector<attribute> _attribs;
 	int _draw_mode;  //!< GL_POINTS, GL_LINES, GL_TRIANGLES, ... \sa glDrawElements()
 };
@@ -126,6 +139,15 @@ struct vertex
 	vertex(glm::vec3 const & position, glm::vec2 const & uv, glm::vec3 const & normal, glm::vec3 const & tangent) : position(position), uv(uv), normal(normal), tangent(tangent) {}
 };
 
+namespace detail {
+
+//! draws indexed primitives with vertices starting at voffset and indices at ioffset (in bytes) of given buffers
+void draw_elements(gpu_buffer const & vbuf, size_t voffset, std::vector<attribute> const & attribs,
+	gpu_buffer const & ibuf, size_t ioffset, size_t count, int index_type, int draw_mode);
+
+}  // detail
+
+//! creates mesh with float attributes (position:0, uv:1, normal:2, tangent:3), 16-bit indices are used if they fit \sa compact_vertices()
 mesh mesh_from_vertices(std::vector<vertex> const & verts, std::vector<unsigned> const & indices);
 
 }  // gles2
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include "model_gles2.hpp"
+#include "render_queue.hpp"
 
 namespace gles2 {
 
@@ -50,15 +51,33 @@ void model::append_global(property * prop)
 
 void model::render(program & p) const
 {
-	for (size_t i = 0; i < _meshes.size(); ++i)
-	{
-		for (property * prop : _glob_props)
-			prop->bind(p);
+	render_queue q{false};
+	enqueue(q, p);
+	q.flush();
+	_stats = q.stats();
+}
 
-		for (property * prop : _props[i])
-			prop->bind(p);
+void model::render_sorted(program & p) const
+{
+	render_queue q;
+	enqueue(q, p);
+	q.flush();
+	_stats = q.stats();
+}
 
-		_meshes[i]->render();
+render_queue::statistics const & model::render_stats() const
+{
+	return _stats;
+}
+
+void model::enqueue(render_queue & q, program & p) const
+{
+	propvect props;
+	for (size_t i = 0; i < _meshes.size(); ++i)
+	{
+		props = _glob_props;
+		props.insert(props.end(), _props[i].begin(), _props[i].end());
+		q.push(*_meshes[i], p, props);
 	}
 }
 
@@ -5,6 +5,7 @@
 #include "gles2/mesh_gles2.hpp"
 #include "gles2/program_gles2.hpp"
 #include "gles2/property.hpp"
+#include "gles2/render_queue.hpp"
 
 namespace gles2 {
 
@@ -17,7 +18,10 @@ public:
 	void append_mesh(std::shared_ptr<mesh> m);
 	void append_mesh(std::shared_ptr<mesh> m, std::vector<property *> const & mesh_props);
 	void append_global(property * prop);
-	virtual void render(shader::program & p) const;
+	virtual void render(shader::program & p) const;  //!< renders meshes in append order (redundant binds are skipped)
+	void render_sorted(shader::program & p) const;  //!< renders meshes sorted by state (opaque geometry) \sa render_queue
+	void enqueue(render_queue & q, shader::program & p) const;  //!< queues mesh draws (with global and mesh properties)
+	render_queue::statistics const & render_stats() const;  //!< draws, program switches and (saved) binds of the last render() or render_sorted()
 	void operator=(model && other);
 	void attribute_location(std::initializer_list<int> locations);
 
@@ -30,6 +34,7 @@ private:
 	std::vector<std::shared_ptr<mesh>> _meshes;
 	std::vector<propvect> _props;  //!< vlastnosti pre kazdu mriezku
 	propvect _glob_props;  //!< spolocne vlastnosti pre vsetky mriezky
+	mutable render_queue::statistics _stats;  //!< statistiky posledneho renderovania
 };
 
 }  // gles2
@@ -1,16 +1,12 @@
 #include <iostream>
 #include <memory>
 #include <string>
-#include <sstream>
-#include <fstream>
-#include <boost/format.hpp>
 #include <glm/fwd.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "file_view/file_view.hpp"
 #include "program_gles2.hpp"
 
 using std::string;
-using std::ifstream;
-using std::stringstream;
 using std::shared_ptr;
 using std::make_shared;
 
@@ -22,7 +18,7 @@ char const * LOG_TAG = "gles2::program";
 static string get_compile_log(GLuint shader);
 static string get_link_log(GLuint program);
 
-program * program::_CURRENT = nullptr;
+thread_local program * program::_CURRENT = nullptr;
 
 program::program() : _pid(0)
 {}
@@ -335,14 +331,8 @@ string get_link_log(GLuint program)
 
 string read_file(string const & fname)
 {
-	ifstream in(fname);
-	if (!in.is_open())
-		throw std::runtime_error(boost::str(boost::format("can't open '%1%' file") % fname));
-
-	stringstream ss;
-	ss << in.rdbuf();
-	in.close();
-	return ss.str();
+	io::file_view f{fname};
+	return string{f.view()};
 }
 
 string to_string(module::shader_type type)
@@ -429,6 +419,12 @@ void set_uniform<float>(int location, float const * a, int n)
 	glUniform1fv(location, n, a);
 }
 
+template <>  // pre pole vec3 vektorov
+void set_uniform<glm::vec3>(int location, glm::vec3 const * a, int n)
+{
+	glUniform3fv(location, n, glm::value_ptr(*a));
+}
+
 template <>  // pre pole vec4 vektorov
 void set_uniform<glm::vec4>(int location, glm::vec4 const * a, int n)
 {
@@ -149,7 +149,7 @@ private:
 	std::vector<std::shared_ptr<module>> _modules;
 	std::map<std::string, std::shared_ptr<uniform>> _uniforms;
 
-	static program * _CURRENT;
+	static thread_local program * _CURRENT;  //!< program in use for the (thread) current context
 };
 
 template <typename T>
@@ -1,8 +1,11 @@
+#include <functional>
 #include "property.hpp"
 
 namespace gles2 {
 
 using std::string;
+using std::vector;
+using std::to_string;
 using std::shared_ptr;
 using glm::vec3;
 using shader::program;
@@ -17,6 +20,22 @@ void texture_property::bind(program & p)
 	p.uniform_variable(_uname, (int)_bind_unit);
 }
 
+uint64_t texture_property::state_key() const
+{
+	return (uint64_t{_tex->id()} << 8) | (_bind_unit & 0xff);
+}
+
+bool texture_property::same_state(property const & other) const
+{
+	auto o = dynamic_cast<texture_property const *>(&other);
+	return o && o->_tex->id() == _tex->id() && o->_bind_unit == _bind_unit && o->_uname == _uname;
+}
+
+vector<string> texture_property::state_slots() const
+{
+	return {"texture unit " + to_string(_bind_unit), _uname};
+}
+
 material_property::material_property(vec3 const & ambient, float intensity, float shininess)
 	: ambient{ambient}, intensity{intensity}, shininess{shininess}
 {}
@@ -28,4 +47,24 @@ void material_property::bind(program & p)
 	p.uniform_variable("material_shininess", shininess);
 }
 
+uint64_t material_property::state_key() const
+{
+	std::hash<float> h;
+	size_t key = h(ambient.x);
+	for (float v : {ambient.y, ambient.z, intensity, shininess})
+		key = key*31 + h(v);
+	return key;
+}
+
+bool material_property::same_state(property const & other) const
+{
+	auto o = dynamic_cast<material_property const *>(&other);
+	return o && o->ambient == ambient && o->intensity == intensity && o->shininess == shininess;
+}
+
+vector<string> material_property::state_slots() const
+{
+	return {"material_ambient", "material_intensity", "material_shininess"};
+}
+
 }  // gles2
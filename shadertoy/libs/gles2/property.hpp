@@ -1,4 +1,7 @@
 #pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
 #include <glm/vec3.hpp>
 #include "gles2/program_gles2.hpp"
 #include "gles2/texture_gles2.hpp"
@@ -9,12 +12,26 @@ struct property
 {
 	virtual ~property() {}
 	virtual void bind(shader::program & p) = 0;
+
+	/*! sort key of bound state (e.g. texture id), properties with close keys
+	should be cheap to switch between \sa render_queue */
+	virtual uint64_t state_key() const {return 0;}
+
+	//! true if the property binds the same state as other (so binding it again after other is redundant)
+	virtual bool same_state(property const & other) const {return false;}
+
+	/*! state written by bind() (uniform names, texture units), property with
+	unknown state (empty list) is always bound \sa render_queue */
+	virtual std::vector<std::string> state_slots() const {return {};}
 };
 
 struct texture_property : public property
 {
 	texture_property(std::shared_ptr<texture2d> tex, std::string const & uname, unsigned bind_unit = 0);
 	void bind(shader::program & p) override;
+	uint64_t state_key() const override;
+	bool same_state(property const & other) const override;
+	std::vector<std::string> state_slots() const override;
 
 	std::shared_ptr<texture2d> _tex;
 	std::string _uname;
@@ -26,6 +43,9 @@ struct material_property : public property
 {
 	material_property(glm::vec3 const & ambient = glm::vec3{.2}, float intensity = 1.0f, float shininess = 64.0f);
 	void bind(shader::program & p) override;
+	uint64_t state_key() const override;
+	bool same_state(property const & other) const override;
+	std::vector<std::string> state_slots() const override;
 
 	glm::vec3 ambient;
 	float intensity;
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <map>
+#include "render_queue.hpp"
+
+namespace gles2 {
+
+using std::vector;
+using std::string;
+using std::map;
+using shader::program;
+
+render_queue::render_queue(bool sort)
+	: _sort{sort}
+{}
+
+void render_queue::push(mesh const & m, program & p, vector<property *> const & props)
+{
+	draw d{&m, &p, props, {}, {}, _draws.size()};
+	d.key.reserve(props.size());
+	d.slots.reserve(props.size());
+	for (property const * prop : props)
+	{
+		d.key.push_back(prop->state_key());
+		d.slots.push_back(prop->state_slots());
+	}
+
+	_draws.push_back(std::move(d));
+}
+
+void render_queue::flush()
+{
+	if (_sort)
+	{
+		std::sort(_draws.begin(), _draws.end(), [](draw const & a, draw const & b) {
+			if (a.prog->id() != b.prog->id())
+				return a.prog->id() < b.prog->id();
+			if (a.key != b.key)
+				return a.key < b.key;
+			return a.order < b.order;
+		});
+	}
+
+	_stats = statistics{};
+
+	program * current = nullptr;
+	map<string, property const *> writer;  //!< property which wrote the state slot last (for the current program)
+
+	for (draw const & d : _draws)
+	{
+		if (d.prog != current)  // uniforms are program state, rebind all
+		{
+			d.prog->use();
+			current = d.prog;
+			writer.clear();
+			++_stats.program_switches;
+		}
+
+		for (size_t i = 0; i < d.props.size(); ++i)
+		{
+			property * prop = d.props[i];
+			vector<string> const & slots = d.slots[i];
+
+			bool redundant = !slots.empty() && std::all_of(slots.begin(), slots.end(),
+				[prop, &writer](string const & slot) {
+					auto it = writer.find(slot);
+					return it != writer.end() && (it->second == prop || prop->same_state(*it->second));
+				});
+
+			if (redundant)
+				++_stats.binds_saved;
+			else
+			{
+				prop->bind(*current);
+				++_stats.binds;
+			}
+
+			if (slots.empty())  // unknown state written, nothing can be skipped after
+				writer.clear();
+			else
+			{
+				for (string const & slot : slots)
+					writer[slot] = prop;
+			}
+		}
+
+		d.m->render();
+		++_stats.draws;
+	}
+
+	_draws.clear();
+}
+
+void render_queue::clear()
+{
+	_draws.clear();
+}
+
+size_t render_queue::size() const
+{
+	return _draws.size();
+}
+
+render_queue::statistics const & render_queue::stats() const
+{
+	return _stats;
+}
+
+}  // gles2
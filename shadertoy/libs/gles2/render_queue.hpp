@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "gles2/mesh_gles2.hpp"
+#include "gles2/program_gles2.hpp"
+#include "gles2/property.hpp"
+
+namespace gles2 {
+
+/*! Collects draws (mesh, program and properties), sorts them by state
+(program, then property state keys) and issues program switches and
+property binds only on state change. Property bind is skipped only if the
+last property written each of its state slots (see property::state_slots())
+binds the same state, so a property overridden by a later one is bound
+again.
+
+Sorting changes draw order, so it is meant for opaque geometry; with sort
+disabled draws keep submission order and only redundant binds are skipped.
+Submitted meshes, programs and properties need to live till flush().
+\code
+render_queue q;
+for (model const & m : scene)
+	m.enqueue(q, prog);
+q.flush();
+cout << q.stats().binds_saved << " binds saved\n";
+\endcode */
+class render_queue
+{
+public:
+	struct statistics
+	{
+		unsigned draws = 0;
+		unsigned program_switches = 0;
+		unsigned binds = 0;  //!< property binds issued
+		unsigned binds_saved = 0;  //!< redundant property binds skipped
+	};
+
+	render_queue(bool sort = true);
+
+	//! props are bound in given order before the mesh is rendered
+	void push(mesh const & m, shader::program & p, std::vector<property *> const & props);
+	void flush();  //!< sorts and renders queued draws, queue is empty after
+	void clear();  //!< drops queued draws
+	size_t size() const;  //!< number of queued draws
+	statistics const & stats() const;  //!< statistics of the last flush()
+
+private:
+	struct draw
+	{
+		mesh const * m;
+		shader::program * prog;
+		std::vector<property *> props;
+		std::vector<uint64_t> key;  //!< property state keys
+		std::vector<std::vector<std::string>> slots;  //!< state slots of each property
+		size_t order;  //!< submission order
+	};
+
+	std::vector<draw> _draws;
+	statistics _stats;
+	bool _sort;
+};
+
+}  // gles2
@@ -1,122 +1,410 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <map>
+#include <list>
+#include <vector>
+#include <mutex>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <typeindex>
+#include <stdexcept>
 #include "gles2/texture_gles2.hpp"
 #include "gles2/program_gles2.hpp"
 #include "gles2/texture_loader_gles2.hpp"
 
-template <typename R>
-std::shared_ptr<R> from_file(std::string const & fname);
-
-template <typename R>
-std::shared_ptr<R> from_memory(std::string const & source);
+//! estimated memory used by a resource
+struct resource_size
+{
+	size_t gpu = 0, cpu = 0;  //!< in bytes
 
+	size_t total() const {return gpu + cpu;}
+};
 
-template <>
-inline std::shared_ptr<gles2::shader::program> from_file<gles2::shader::program>(std::string const & fname)
-{
-	return std::shared_ptr<gles2::shader::program> {
-		new gles2::shader::program{fname}
-	};
-}
+/*! Resource type description used by resource_loader, loading is split into
+decode (CPU only work, can run in any thread) and create (needs current
+OpenGL context) steps.
 
+\code
 template <>
-inline std::shared_ptr<gles2::texture2d> from_file<gles2::texture2d>(std::string const & fname)
+struct resource_traits<my_resource>
 {
-	return std::shared_ptr<gles2::texture2d>{
-		new gles2::texture2d{gles2::texture_from_file(fname)}
-	};
-}
+	using data_type = ...;
+	static data_type decode(std::string const & fname);
+	static std::shared_ptr<my_resource> create(data_type const & data);
+	static resource_size size(my_resource const & r);
+};
+\endcode */
+template <typename R>
+struct resource_traits;
 
 template <>
-inline std::shared_ptr<gles2::shader::program> from_memory(std::string const & source)
+struct resource_traits<gles2::texture2d>
 {
-	std::shared_ptr<gles2::shader::program> result{new gles2::shader::program{}};
-	result->from_memory(source);
-	return result;
-}
+	using data_type = gles2::image;
 
+	static data_type decode(std::string const & fname)
+	{
+		return gles2::image_from_file(fname);
+	}
 
-struct resource_holder
-{
-	void * ptr;
+	static std::shared_ptr<gles2::texture2d> create(data_type const & im)
+	{
+		return std::make_shared<gles2::texture2d>(gles2::texture_from_image(im));
+	}
 
-	template <typename R>
-	std::shared_ptr<R> as() {return *(std::shared_ptr<R> *)ptr;}
+	static resource_size size(gles2::texture2d const & t)
+	{
+		resource_size result;
+		result.gpu = size_t(t.width()) * t.height() * 4;  // RGBA8
+		return result;
+	}
 };
 
-
-template <typename T>
-struct resource_holder_impl : public resource_holder
+template <>
+struct resource_traits<gles2::shader::program>
 {
-	resource_holder_impl() {}
+	using data_type = std::string;  //!< shader source
+
+	static data_type decode(std::string const & fname)
+	{
+		return gles2::shader::read_file(fname);
+	}
 
-	resource_holder_impl(std::shared_ptr<T> resource)
-		: resource{resource}
+	static std::shared_ptr<gles2::shader::program> create(data_type const & source)
 	{
-		ptr = (void *)&this->resource;
+		std::shared_ptr<gles2::shader::program> result{new gles2::shader::program{}};
+		result->from_memory(source);
+		return result;
 	}
 
-	std::shared_ptr<T> resource;
+	static resource_size size(gles2::shader::program const &)
+	{
+		return resource_size{};  // driver owned, negligible
+	}
 };
 
 
+/*! Thread-safe typed resource cache.
+
+Resources are shared by id (file name for from_file()). Each entry tracks
+its estimated GPU and CPU memory. After insertion, least recently used
+resources not referenced outside the cache are evicted while the cache is
+over budget, referenced resources are never evicted (so the cache can be
+temporarily over budget). Requesting an id with a different type than it was
+loaded as throws std::logic_error.
+
+Resources are created (and evicted resources destroyed) in the calling
+thread, so it needs a current OpenGL context (of the same share group for
+all callers). from_file_async() decodes in a background thread and creates
+the resource in poll() (or get()).
+\code
+resource_loader textures{256 << 20};  // 256 MiB budget
+auto f = textures.from_file_async<texture2d>("lena.jpg");
+// ...
+textures.poll();  // each frame
+if (f.wait_for(std::chrono::seconds{0}) == std::future_status::ready)
+	shared_ptr<texture2d> t = f.get();
+\endcode */
 class resource_loader
 {
 public:
 	template <typename R>
-	std::shared_ptr<R> from_file(std::string const & fname)
+	using future = std::shared_future<std::shared_ptr<R>>;
+
+	resource_loader(size_t budget = 0);  //!< budget in bytes (GPU + CPU), 0 for unlimited
+
+	template <typename R>
+	std::shared_ptr<R> from_file(std::string const & fname);
+
+	template <typename R>
+	std::shared_ptr<R> from_memory(std::string const & id, typename resource_traits<R>::data_type const & data);
+
+	//! decodes fname in a background thread, resource is created by poll() or get()
+	template <typename R>
+	future<R> from_file_async(std::string const & fname);
+
+	//! creates resources for already decoded async loads, needs current OpenGL context
+	void poll();
+
+	//! waits for async load, pending resources are created in the calling thread (needs current OpenGL context)
+	template <typename R>
+	std::shared_ptr<R> get(future<R> const & f);
+
+	//! returns false if id is already cached
+	template <typename R>
+	bool insert(std::string const & id, std::shared_ptr<R> resource);
+
+	//! returns nullptr for not cached id
+	template <typename R>
+	std::shared_ptr<R> find(std::string const & id);
+
+	void budget(size_t bytes);
+	size_t budget() const;
+	resource_size used() const;  //!< estimated memory used by cached resources
+	size_t size() const;  //!< number of cached resources
+	void evict();  //!< evicts least recently used unreferenced resources while over budget
+	void clear();  //!< removes all unreferenced resources
+
+	resource_loader(resource_loader const &) = delete;
+	void operator=(resource_loader const &) = delete;
+
+private:
+	struct entry
 	{
-		auto it = _lookup.find(fname);
-		if (it != _lookup.end())
-			return it->second->as<R>();
+		std::shared_ptr<void> resource;
+		std::type_index type;
+		resource_size size;
+		std::list<std::string>::iterator lru;  //!< position in _lru
+	};
 
-		resource_holder_impl<R> * h = new resource_holder_impl<R>{::from_file<R>(fname)};
-		_lookup[fname] = h;
-		return h->resource;
-	}
+	struct pending_load
+	{
+		std::type_index type;
+		std::shared_ptr<void> result;  //!< future<R> returned to callers
+		std::function<bool ()> decoded;
+		std::function<void ()> finish;  //!< creates resource and fulfills result
+	};
+
+	std::shared_ptr<void> lookup(std::string const & id, std::type_index type);  //!< expects locked cache
+	std::shared_ptr<void> store(std::string const & id, std::shared_ptr<void> resource,
+		std::type_index type, resource_size const & size);  //!< returns already cached resource if any
+	void evict_locked(std::vector<std::shared_ptr<void>> & evicted);
 
 	template <typename R>
-	std::shared_ptr<R> from_memory(std::string const & id, std::string const & source)
+	std::shared_ptr<R> create(std::string const & id, typename resource_traits<R>::data_type const & data);
+
+	std::map<std::string, entry> _lookup;
+	std::list<std::string> _lru;  //!< most recently used first
+	std::map<std::string, pending_load> _pending;  //!< async loads in progress
+	size_t _budget;
+	resource_size _used;
+	mutable std::mutex _lock;
+};
+
+
+inline resource_loader::resource_loader(size_t budget)
+	: _budget{budget}
+{}
+
+template <typename R>
+std::shared_ptr<R> resource_loader::from_file(std::string const & fname)
+{
+	if (std::shared_ptr<R> r = find<R>(fname))
+		return r;
+
+	return create<R>(fname, resource_traits<R>::decode(fname));  // not locked, can take long
+}
+
+template <typename R>
+std::shared_ptr<R> resource_loader::from_memory(std::string const & id, typename resource_traits<R>::data_type const & data)
+{
+	if (std::shared_ptr<R> r = find<R>(id))
+		return r;
+
+	return create<R>(id, data);
+}
+
+template <typename R>
+resource_loader::future<R> resource_loader::from_file_async(std::string const & fname)
+{
+	using data_type = typename resource_traits<R>::data_type;
+
+	std::lock_guard<std::mutex> lock{_lock};
+
+	if (std::shared_ptr<void> r = lookup(fname, typeid(R)))
 	{
-		auto it = _lookup.find(id);
-		if (it != _lookup.end())
-			return it->second->as<R>();
+		std::promise<std::shared_ptr<R>> done;
+		done.set_value(std::static_pointer_cast<R>(r));
+		return done.get_future().share();
+	}
 
-		resource_holder_impl<R> * h = new resource_holder_impl<R>{::from_memory<R>(source)};
-		_lookup[id] = h;
-		return h->resource;
+	auto it = _pending.find(fname);
+	if (it != _pending.end())  // already loading
+	{
+		if (it->second.type != typeid(R))
+			throw std::logic_error{"'" + fname + "' resource type mismatch"};
+		return *std::static_pointer_cast<future<R>>(it->second.result);
 	}
 
-	template <typename R>
-	bool insert(std::string const & id, std::shared_ptr<R> resource)
+	auto decoding = std::make_shared<std::future<data_type>>(
+		std::async(std::launch::async, [fname]{return resource_traits<R>::decode(fname);}));
+	auto promise = std::make_shared<std::promise<std::shared_ptr<R>>>();
+	auto result = std::make_shared<future<R>>(promise->get_future().share());
+
+	pending_load p{typeid(R), result,
+		[decoding]{return decoding->wait_for(std::chrono::seconds{0}) == std::future_status::ready;},
+		[this, fname, decoding, promise]{
+			try {
+				promise->set_value(create<R>(fname, decoding->get()));
+			}
+			catch (...) {
+				promise->set_exception(std::current_exception());
+			}
+		}};
+
+	_pending.emplace(fname, p);
+	return *result;
+}
+
+inline void resource_loader::poll()
+{
+	std::vector<std::function<void ()>> finished;
+
 	{
-		auto it = _lookup.find(id);
-		if (it != _lookup.end())
-			return false;
+		std::lock_guard<std::mutex> lock{_lock};
+		for (auto it = _pending.begin(); it != _pending.end();)
+		{
+			if (it->second.decoded())
+			{
+				finished.push_back(it->second.finish);
+				it = _pending.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+
+	for (auto & finish : finished)  // not locked, creates (and stores) resources
+		finish();
+}
 
-		resource_holder_impl<R> * h = new resource_holder_impl<R>{resource};
-		_lookup[id] = h;
-		return h->resource;
+template <typename R>
+std::shared_ptr<R> resource_loader::get(future<R> const & f)
+{
+	while (f.wait_for(std::chrono::seconds{0}) != std::future_status::ready)
+	{
+		poll();
+		if (f.wait_for(std::chrono::milliseconds{1}) == std::future_status::ready)
+			break;
 	}
 
-	template <typename R>
-	std::shared_ptr<R> find(std::string const & id)
+	return f.get();
+}
+
+template <typename R>
+bool resource_loader::insert(std::string const & id, std::shared_ptr<R> resource)
+{
+	std::shared_ptr<void> stored = store(id, resource, typeid(R), resource_traits<R>::size(*resource));
+	return stored == resource;
+}
+
+template <typename R>
+std::shared_ptr<R> resource_loader::find(std::string const & id)
+{
+	std::lock_guard<std::mutex> lock{_lock};
+	return std::static_pointer_cast<R>(lookup(id, typeid(R)));
+}
+
+inline void resource_loader::budget(size_t bytes)
+{
+	{
+		std::lock_guard<std::mutex> lock{_lock};
+		_budget = bytes;
+	}
+	evict();
+}
+
+inline size_t resource_loader::budget() const
+{
+	std::lock_guard<std::mutex> lock{_lock};
+	return _budget;
+}
+
+inline resource_size resource_loader::used() const
+{
+	std::lock_guard<std::mutex> lock{_lock};
+	return _used;
+}
+
+inline size_t resource_loader::size() const
+{
+	std::lock_guard<std::mutex> lock{_lock};
+	return _lookup.size();
+}
+
+inline void resource_loader::evict()
+{
+	std::vector<std::shared_ptr<void>> evicted;
+	std::lock_guard<std::mutex> lock{_lock};
+	evict_locked(evicted);
+}  // evicted resources are destroyed there
+
+inline void resource_loader::clear()
+{
+	std::vector<std::shared_ptr<void>> evicted;
+	std::lock_guard<std::mutex> lock{_lock};
+	for (auto it = _lookup.begin(); it != _lookup.end();)
 	{
-		auto it = _lookup.find(id);
-		if (it != _lookup.end())
-			return it->second->as<R>();
+		if (it->second.resource.use_count() == 1)
+		{
+			_used.gpu -= it->second.size.gpu;
+			_used.cpu -= it->second.size.cpu;
+			_lru.erase(it->second.lru);
+			evicted.push_back(std::move(it->second.resource));
+			it = _lookup.erase(it);
+		}
 		else
-			return std::shared_ptr<R>{};
+			++it;
 	}
+}
+
+inline std::shared_ptr<void> resource_loader::lookup(std::string const & id, std::type_index type)
+{
+	auto it = _lookup.find(id);
+	if (it == _lookup.end())
+		return nullptr;
+
+	if (it->second.type != type)
+		throw std::logic_error{"'" + id + "' resource type mismatch"};
 
-	~resource_loader()
+	_lru.splice(_lru.begin(), _lru, it->second.lru);  // most recently used
+	return it->second.resource;
+}
+
+inline std::shared_ptr<void> resource_loader::store(std::string const & id, std::shared_ptr<void> resource,
+	std::type_index type, resource_size const & size)
+{
+	std::vector<std::shared_ptr<void>> evicted;
+	std::lock_guard<std::mutex> lock{_lock};
+
+	if (std::shared_ptr<void> r = lookup(id, type))  // loaded by other thread in the meantime
+		return r;
+
+	_lru.push_front(id);
+	_lookup.emplace(id, entry{resource, type, size, _lru.begin()});
+	_used.gpu += size.gpu;
+	_used.cpu += size.cpu;
+
+	evict_locked(evicted);
+	return resource;
+}
+
+inline void resource_loader::evict_locked(std::vector<std::shared_ptr<void>> & evicted)
+{
+	if (_budget == 0)
+		return;
+
+	for (auto it = _lru.end(); it != _lru.begin() && _used.total() > _budget;)
 	{
-		// free resources
-		for (auto const keyval : _lookup)
-			delete keyval.second;
+		--it;
+		auto e = _lookup.find(*it);
+		if (e->second.resource.use_count() > 1)  // referenced
+			continue;
+
+		_used.gpu -= e->second.size.gpu;
+		_used.cpu -= e->second.size.cpu;
+		evicted.push_back(std::move(e->second.resource));
+		_lookup.erase(e);
+		it = _lru.erase(it);
 	}
+}
 
-private:
-	std::map<std::string, resource_holder *> _lookup;
-};
+template <typename R>
+std::shared_ptr<R> resource_loader::create(std::string const & id, typename resource_traits<R>::data_type const & data)
+{
+	std::shared_ptr<R> r = resource_traits<R>::create(data);
+	return std::static_pointer_cast<R>(store(id, r, typeid(R), resource_traits<R>::size(*r)));
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+#include "gl/opengl.hpp"
+#include "stream_buffer.hpp"
+
+namespace gles2 {
+
+using std::max;
+using std::initializer_list;
+using std::unique_ptr;
+
+GLenum opengl_cast(render_primitive p);
+
+stream_buffer::stream_buffer(buffer_target target, size_t capacity, strategy s, unsigned buffers)
+	: _target{target}
+	, _strategy{s}
+	, _capacity{capacity}
+	, _head{0}
+	, _frame{0}
+{
+	assert(capacity > 0 && "empty stream buffer");
+
+	size_t n = s == strategy::rotate ? max(buffers, 2u) : 1;
+	for (size_t i = 0; i < n; ++i)
+	{
+		_buffers.emplace_back(new gpu_buffer{target, capacity, buffer_usage::stream_draw});
+		_buffers.back()->label("stream buffer");
+	}
+
+	_sizes.assign(n, capacity);
+}
+
+stream_allocation stream_buffer::allocate(size_t size, unsigned alignment)
+{
+	assert(alignment > 0 && "invalid alignment");
+
+	size_t offset = (_head + alignment - 1) / alignment * alignment;
+	if (offset + size > _sizes[current_index()])  // full
+	{
+		replace(max(_capacity, size));
+		offset = 0;
+	}
+
+	_head = offset + size;
+
+	_current.bytes += size;
+	++_current.allocations;
+
+	stream_allocation result;
+	result.buffer = &current();
+	result.offset = offset;
+	result.size = size;
+	return result;
+}
+
+stream_allocation stream_buffer::write(void const * data, size_t size, unsigned alignment)
+{
+	stream_allocation a = allocate(size, alignment);
+	write(a, data, size);
+	return a;
+}
+
+void stream_buffer::write(stream_allocation const & a, void const * data, size_t size, size_t offset)
+{
+	assert(valid(a) && "allocation from the previous frame");
+	assert(offset + size <= a.size && "out of allocation");
+	const_cast<gpu_buffer *>(a.buffer)->data(_target, data, size, a.offset + offset);
+}
+
+void stream_buffer::next_frame()
+{
+	_last = _current;
+	_current = frame_stats{};
+	++_frame;
+
+	_retired.clear();  // draws are issued, driver keeps the storage while they are in flight
+
+	if (_strategy == strategy::rotate)  // next buffer is free (its draws finished), orphan strategy keeps appending
+	{
+		_head = 0;
+		if (_sizes[current_index()] < _capacity)  // other buffer grown
+		{
+			current().orphan(_target, _capacity, buffer_usage::stream_draw);
+			_sizes[current_index()] = _capacity;
+		}
+	}
+}
+
+size_t stream_buffer::capacity() const
+{
+	return _capacity;
+}
+
+buffer_target stream_buffer::target() const
+{
+	return _target;
+}
+
+stream_buffer::frame_stats const & stream_buffer::current_frame() const
+{
+	return _current;
+}
+
+stream_buffer::frame_stats const & stream_buffer::last_frame() const
+{
+	return _last;
+}
+
+gpu_buffer & stream_buffer::current()
+{
+	return *_buffers[current_index()];
+}
+
+size_t stream_buffer::current_index() const
+{
+	return _frame % _buffers.size();
+}
+
+void stream_buffer::replace(size_t capacity)
+{
+	// full buffer keeps allocations of this frame not drawn yet
+	unique_ptr<gpu_buffer> & buf = _buffers[current_index()];
+	_retired.push_back(std::move(buf));
+	buf.reset(new gpu_buffer{_target, capacity, buffer_usage::stream_draw});
+	buf->label("stream buffer");
+
+	_sizes[current_index()] = capacity;
+	_capacity = max(_capacity, capacity);
+	_head = 0;
+	++_current.orphans;
+}
+
+bool stream_buffer::valid(stream_allocation const & a) const
+{
+	if (a.buffer == _buffers[current_index()].get())
+		return true;
+
+	for (unique_ptr<gpu_buffer> const & buf : _retired)
+		if (a.buffer == buf.get())
+			return true;
+
+	return false;
+}
+
+
+dynamic_mesh::dynamic_mesh(stream_buffer & vertices, stream_buffer & indices)
+	: _vstream{vertices}
+	, _istream{indices}
+	, _nindices{0}
+	, _draw_mode{GL_TRIANGLES}
+{
+	assert(vertices.target() == buffer_target::array && indices.target() == buffer_target::element_array
+		&& "unexpected stream buffer targets");
+}
+
+void dynamic_mesh::data(void const * vbuf, size_t vbuf_size, uint16_t const * ibuf, size_t ibuf_size)
+{
+	_vertices = _vstream.write(vbuf, vbuf_size, 4);
+	_indices = _istream.write(ibuf, ibuf_size*sizeof(uint16_t), sizeof(uint16_t));
+	_nindices = ibuf_size;
+}
+
+void dynamic_mesh::render() const
+{
+	if (!_vertices || !_indices || _nindices == 0)
+		return;
+
+	detail::draw_elements(*_vertices.buffer, _vertices.offset, _attribs,
+		*_indices.buffer, _indices.offset, _nindices, GL_UNSIGNED_SHORT, _draw_mode);
+}
+
+void dynamic_mesh::attach_attributes(initializer_list<attribute> attribs)
+{
+	_attribs.assign(attribs);
+}
+
+void dynamic_mesh::append_attribute(attribute const & a)
+{
+	_attribs.push_back(a);
+}
+
+void dynamic_mesh::draw_mode(render_primitive_type mode)
+{
+	_draw_mode = opengl_cast(mode);
+}
+
+void dynamic_mesh::attribute_location(initializer_list<int> locations)
+{
+	assert(_attribs.size() >= locations.size() && "not enough attributes to set");
+	int idx = 0;
+	for (auto it = locations.begin(); it != locations.end(); ++it, ++idx)
+		_attribs[idx].index = *it;
+}
+
+}  // gles2
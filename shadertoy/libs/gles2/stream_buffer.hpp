@@ -0,0 +1,119 @@
+// streaming (per frame) vertex and index data
+#pragma once
+#include <vector>
+#include <memory>
+#include <initializer_list>
+#include <cstdint>
+#include "gles2/mesh_gles2.hpp"
+
+namespace gles2 {
+
+//! stream_buffer suballocation, valid till the end of the frame (stream_buffer::next_frame())
+struct stream_allocation
+{
+	gpu_buffer const * buffer = nullptr;
+	size_t offset = 0;  //!< in bytes
+	size_t size = 0;
+
+	explicit operator bool() const {return buffer != nullptr;}
+};
+
+/*! Ring buffer allocator of per frame (vertex or index) data on top of gpu_buffer.
+
+Data are appended with glBufferSubData() into the part of the buffer not
+used by draws in flight. With orphan strategy a single buffer is filled
+across frames and it is replaced by a new buffer when full. With rotate
+strategy each frame writes into the next of N buffers, so it expects the
+driver to have at most N-1 frames in flight (GLES2 has no fences).
+Allocations larger than the buffer grow it.
+
+Full buffer is retired till the end of the frame (not orphaned), so
+allocations of the current frame stay valid till they are drawn.
+\code
+stream_buffer verts{buffer_target::array, 256*1024};
+// each frame
+stream_allocation a = verts.write(quads.data(), quads.size()*sizeof(quad_vertex));
+// ... draw using a.buffer at a.offset
+verts.next_frame();
+cout << verts.last_frame().bytes << " bytes streamed\n";
+\endcode */
+class stream_buffer
+{
+public:
+	enum class strategy
+	{
+		orphan,
+		rotate
+	};
+
+	struct frame_stats
+	{
+		size_t bytes = 0;  //!< streamed bytes
+		unsigned allocations = 0;
+		unsigned orphans = 0;  //!< buffer replacements (full buffer, growth)
+	};
+
+	stream_buffer(buffer_target target, size_t capacity, strategy s = strategy::orphan, unsigned buffers = 3);
+	stream_allocation allocate(size_t size, unsigned alignment = 4);  //!< reserves size bytes, data are written by write(allocation, ...)
+	stream_allocation write(void const * data, size_t size, unsigned alignment = 4);  //!< allocates and uploads data
+	void write(stream_allocation const & a, void const * data, size_t size, size_t offset = 0);  //!< uploads data into allocation
+	void next_frame();  //!< ends the current frame
+	size_t capacity() const;  //!< (the largest) buffer size in bytes
+	buffer_target target() const;
+	frame_stats const & current_frame() const;
+	frame_stats const & last_frame() const;  //!< statistics of the previous (finished) frame
+
+	stream_buffer(stream_buffer const &) = delete;
+	void operator=(stream_buffer const &) = delete;
+
+private:
+	gpu_buffer & current();
+	size_t current_index() const;
+	void replace(size_t capacity);  //!< retires the current buffer and replaces it with a new one
+	bool valid(stream_allocation const & a) const;  //!< allocation of the current frame
+
+	buffer_target _target;
+	strategy _strategy;
+	std::vector<std::unique_ptr<gpu_buffer>> _buffers;  //!< one buffer for orphan strategy (stable addresses for allocations)
+	std::vector<std::unique_ptr<gpu_buffer>> _retired;  //!< full buffers with allocations of the current frame
+	std::vector<size_t> _sizes;  //!< storage size of each buffer
+	size_t _capacity;  //!< the largest buffer size
+	size_t _head;  //!< first free byte in the current buffer
+	size_t _frame;
+	frame_stats _current, _last;
+};
+
+/*! Mesh with vertex and index data streamed each frame (dynamic draw path),
+attributes are specified the same way as for mesh.
+\code
+stream_buffer verts{buffer_target::array, 64*1024}, indices{buffer_target::element_array, 16*1024};
+dynamic_mesh graph{verts, indices};
+graph.attach_attributes({attribute{0, 2, GL_FLOAT, 2*sizeof(float)}});
+graph.draw_mode(render_primitive::line_strip);
+// each frame
+graph.data(points.data(), points.size()*sizeof(vec2), line_indices.data(), line_indices.size());
+graph.render();
+\endcode */
+class dynamic_mesh
+{
+public:
+	using vertex_attribute_type = attribute;
+	using render_primitive_type = render_primitive;
+
+	dynamic_mesh(stream_buffer & vertices, stream_buffer & indices);
+	void data(void const * vbuf, size_t vbuf_size, uint16_t const * ibuf, size_t ibuf_size);  //!< streams frame data (ibuf_size is number of indices)
+	void render() const;  //!< renders data streamed in the current frame
+	void attach_attributes(std::initializer_list<attribute> attribs);
+	void append_attribute(attribute const & a);
+	void draw_mode(render_primitive_type mode);
+	void attribute_location(std::initializer_list<int> locations);
+
+private:
+	stream_buffer & _vstream, & _istream;
+	stream_allocation _vertices, _indices;
+	size_t _nindices;
+	std::vector<attribute> _attribs;
+	int _draw_mode;  //!< GL_POINTS, GL_LINES, GL_TRIANGLES, ... \sa glDrawElements()
+};
+
+}  // gles2
@@ -3,6 +3,7 @@
 #include <cassert>
 #include "gl/opengl.hpp"
 #include "texture_gles2.hpp"
+#include "gpu_memory.hpp"
 
 namespace gles2 {
 
@@ -70,6 +71,7 @@ texture::texture(unsigned target, unsigned tid)
 
 texture::~texture()
 {
+	gpu_memory::instance().free(gpu_memory_category::texture, _tid);
 	glDeleteTextures(1, &_tid);
 }
 
@@ -93,6 +95,11 @@ void texture::bind(unsigned unit)
 	glBindTexture(_target, _tid);
 }
 
+void texture::label(std::string const & name)
+{
+	gpu_memory::instance().label(gpu_memory_category::texture, _tid, name);
+}
+
 void texture::init(parameters const & params)
 {
 	assert(!_tid && "texture already created");
@@ -124,6 +131,7 @@ texture2d::texture2d(unsigned tid, unsigned width, unsigned height, pixel_format
 {
 	_w = width;
 	_h = height;
+	gpu_memory::instance().allocate(gpu_memory_category::texture, tid, size_t(_w) * _h * pixel_sizeof(pfmt, type));
 }
 
 texture2d::texture2d(texture2d && lhs) : texture(std::move(lhs))
@@ -139,12 +147,22 @@ void texture2d::operator=(texture2d && lhs)
 	_h = lhs._h;
 }
 
+void texture2d::write(unsigned x, unsigned y, unsigned width, unsigned height, pixel_format pfmt, pixel_type type, void const * pixels)
+{
+	assert(x + width <= _w && y + height <= _h && "out of texture");
+	glBindTexture(GL_TEXTURE_2D, id());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, alignment_to(width, pfmt, type));
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, opengl_cast(pfmt), opengl_cast(type), pixels);
+	assert(glGetError() == GL_NO_ERROR && "opengl error");
+}
+
 void texture2d::read(unsigned width, unsigned height, pixel_format pfmt, pixel_type type, void const * pixels)
 {
 	_w = width;
 	_h = height;
 	glPixelStorei(GL_UNPACK_ALIGNMENT, alignment_to(_w, pfmt, type));
 	glTexImage2D(GL_TEXTURE_2D, 0, opengl_cast(pfmt), _w, _h, 0, opengl_cast(pfmt), opengl_cast(type), pixels);  // internal-texture-format must equal pixel-format
+	gpu_memory::instance().allocate(gpu_memory_category::texture, id(), size_t(_w) * _h * pixel_sizeof(pfmt, type));
 	// TODO: podpora mipmap ?
 	assert(glGetError() == GL_NO_ERROR && "opengl error");
 }
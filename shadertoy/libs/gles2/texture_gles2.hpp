@@ -1,4 +1,5 @@
 #pragma once
+#include <string>
 #include <stdexcept>
 
 namespace gles2 {
@@ -67,6 +68,7 @@ public:
 	unsigned id() const {return _tid;}
 	unsigned target() const {return _target;}
 	void bind(unsigned unit);
+	void label(std::string const & name);  //!< names texture in GPU memory reports \sa gpu_memory
 
 	void operator=(texture && lhs);
 
@@ -99,6 +101,9 @@ public:
 	unsigned width() const {return _w;}
 	unsigned height() const {return _h;}
 
+	//! updates (x, y, width, height) area of the texture without reallocation \sa glTexSubImage2D()
+	void write(unsigned x, unsigned y, unsigned width, unsigned height, pixel_format pfmt, pixel_type type, void const * pixels);
+
 	void operator=(texture2d && lhs);
 
 private:
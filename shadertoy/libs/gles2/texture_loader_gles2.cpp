@@ -17,8 +17,14 @@ using gles2::texture2d;
 #if defined(USE_GIL)
 static string extension(string const & path);
 
+void init_image_library(char const *)
+{}  // nothing to initialize
+
+void warm_up_image_library()
+{}
+
 // gil in ubuntu 18.04 doesn't have support for libpng16
-texture2d texture_from_file(std::string const & fname, texture::parameters const & params)
+image image_from_file(std::string const & fname)
 {
 	using namespace boost::gil;
 
@@ -37,8 +43,13 @@ texture2d texture_from_file(std::string const & fname, texture::parameters const
 	rgba8_image_t flipped_im{im.dimensions()};
 	copy_pixels(view(im), flipped_up_down_view(view(flipped_im)));
 
-	void * pixels = (void *)&(*view(flipped_im).begin());
-	return texture2d(im.width(), im.height(), gles2::pixel_format::rgba, gles2::pixel_type::ub8, pixels, params);
+	uint8_t const * pixels = (uint8_t const *)&(*view(flipped_im).begin());
+
+	image result;
+	result.width = im.width();
+	result.height = im.height();
+	result.pixels.assign(pixels, pixels + result.width * result.height * 4);
+	return result;
 }
 
 string extension(string const & path)
@@ -52,7 +63,28 @@ string extension(string const & path)
 #endif
 
 #if defined(USE_IMAGICK)
-texture2d texture_from_file(std::string const & fname, texture::parameters const & params)
+void init_image_library(char const * argv0)
+{
+	Magick::InitializeMagick(argv0);  // not safe to run concurrently with other Magick calls
+}
+
+void warm_up_image_library()
+{
+	// configuration and coder modules are loaded on first use
+	for (char const * format : {"PNG", "JPEG"})
+	{
+		try {
+			Magick::CoderInfo info{format};
+		}
+		catch (Magick::Exception &) {}  // not supported, reported by image_from_file()
+	}
+
+	Magick::Image im{Magick::Geometry{1, 1}, "black"};
+	Magick::Blob blob;
+	im.write(&blob, "GRAY");  // as label text
+}
+
+image image_from_file(std::string const & fname)
 {
 	Magick::Image im(fname);
 	im.flip();
@@ -60,8 +92,23 @@ texture2d texture_from_file(std::string const & fname, texture::parameters const
 	Magick::Blob imblob;
 	im.write(&imblob, "RGBA");
 
-	return texture2d(im.columns(), im.rows(), pixel_format::rgba, pixel_type::ub8, imblob.data(), params);
+	image result;
+	result.width = im.columns();
+	result.height = im.rows();
+	uint8_t const * pixels = (uint8_t const *)imblob.data();
+	result.pixels.assign(pixels, pixels + imblob.length());
+	return result;
 }
 #endif
 
+texture2d texture_from_image(image const & im, texture::parameters const & params)
+{
+	return texture2d(im.width, im.height, pixel_format::rgba, pixel_type::ub8, im.pixels.data(), params);
+}
+
+texture2d texture_from_file(std::string const & fname, texture::parameters const & params)
+{
+	return texture_from_image(image_from_file(fname), params);
+}
+
 }  // gles2
@@ -1,9 +1,29 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <cstdint>
 #include "gles2/texture_gles2.hpp"
 
 namespace gles2 {
 
+//! decoded RGBA image with bottom-up rows (OpenGL texture layout)
+struct image
+{
+	unsigned width = 0, height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+/*! initializes image library, needs to be called once from main() before
+any thread using image_from_file() starts (argv0 is used to locate library
+configuration) */
+void init_image_library(char const * argv0);
+
+/*! loads image library decoders ahead of the first image_from_file() call
+(after init_image_library()), can be called from a worker thread during startup */
+void warm_up_image_library();
+
+image image_from_file(std::string const & fname);  //!< decodes image file (no OpenGL calls, can be used from any thread)
+texture2d texture_from_image(image const & im, texture::parameters const & params = texture::parameters{});
 texture2d texture_from_file(std::string const & fname, texture::parameters const & params = texture::parameters{});
 
 }  // gles2
@@ -1,5 +1,8 @@
 #include <vector>
 #include <string>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <algorithm>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/transform.hpp>
@@ -13,6 +16,11 @@ namespace ui {
 
 using std::string;
 using std::vector;
+using std::map;
+using std::shared_ptr;
+using std::weak_ptr;
+using std::mutex;
+using std::lock_guard;
 using glm::mat4;
 using glm::vec2;
 using glm::vec3;
@@ -38,6 +46,31 @@ unsigned height(FT_BBox const & b);
 FT_BBox measure_glyphs(vector<FT_Glyph> const & glyphs);
 Magick::Image render_glyphs(vector<FT_Glyph> const & glyphs);
 FT_Glyph load_glyph(unsigned char_code, FT_Face face);
+shared_ptr<font_face> find_font(string const & font_file, unsigned size, unsigned dpi, bool preload_glyphs = false);
+shared_ptr<gles2::shader::program> text_program();
+
+//! font s cache glyph-ov
+struct font_face
+{
+	font_face(FT_Library lib, string const & font_file, unsigned size, unsigned dpi);
+	~font_face();
+	FT_Glyph glyph(unsigned char_code);
+
+	FT_Face face;
+	map<unsigned, FT_Glyph> glyphs;
+	mutex lock;  //!< face can be used from more threads (see preload_font())
+};
+
+//! FreeType kniznica a nahrate fonty
+struct font_cache
+{
+	font_cache();
+	~font_cache();
+
+	FT_Library lib;
+	map<string, shared_ptr<font_face>> faces;  //!< (font_file:size:dpi, font)
+	mutex lock;
+};
 
 FT_BBox measure_glyphs(vector<FT_Glyph> const & glyphs)
 {
@@ -142,6 +175,72 @@ unsigned height(FT_BBox const & b)
 	return b.yMax - b.yMin;
 }
 
+font_face::font_face(FT_Library lib, string const & font_file, unsigned size, unsigned dpi)
+{
+	FT_Error err = FT_New_Face(lib, font_file.c_str(), 0, &face);
+	assert(!err && "unable to load a font face");
+
+	unsigned font_size = size << 6;  // 26.6
+	err = FT_Set_Char_Size(face, font_size, font_size, dpi, dpi);
+	assert(!err && "freetype set font size failed");
+}
+
+font_face::~font_face()
+{
+	for (auto e : glyphs)
+		FT_Done_Glyph(e.second);
+
+	FT_Done_Face(face);
+}
+
+FT_Glyph font_face::glyph(unsigned char_code)
+{
+	lock_guard<mutex> guard{lock};
+
+	auto it = glyphs.find(char_code);
+	if (it != glyphs.end())
+		return it->second;
+
+	FT_Glyph result = load_glyph(char_code, face);
+	glyphs[char_code] = result;
+	return result;
+}
+
+font_cache::font_cache()
+{
+	FT_Error err = FT_Init_FreeType(&lib);
+	assert(!err && "unable to init a free-type library");
+}
+
+font_cache::~font_cache()
+{
+	faces.clear();
+	FT_Done_FreeType(lib);
+}
+
+shared_ptr<font_face> find_font(string const & font_file, unsigned size, unsigned dpi, bool preload_glyphs)
+{
+	static font_cache cache;
+
+	string key = font_file + ":" + std::to_string(size) + ":" + std::to_string(dpi);
+
+	shared_ptr<font_face> result;
+
+	{
+		lock_guard<mutex> lock{cache.lock};  // faces can't be created in parallel
+		shared_ptr<font_face> & face = cache.faces[key];
+		if (!face)
+			face = std::make_shared<font_face>(cache.lib, font_file, size, dpi);
+		result = face;
+	}
+
+	if (preload_glyphs)
+		for (unsigned c = 32; c < 127; ++c)
+			result->glyph(c);
+
+	return result;
+}
+
 char const * text_gles2_shader_source = R"(
 	// gles2 text rendering shader (expects quad [-1,-1,1,1])
 	#ifdef _VERTEX_
@@ -163,42 +262,49 @@ char const * text_gles2_shader_source = R"(
 	#endif  // _FRAGMENT_
 )";
 
+shared_ptr<gles2::shader::program> text_program()
+{
+	static weak_ptr<gles2::shader::program> shared;  // freed with the last label (while context is alive)
+
+	shared_ptr<gles2::shader::program> result = shared.lock();
+	if (!result)
+	{
+		result = std::make_shared<gles2::shader::program>();
+		result->from_memory(text_gles2_shader_source);
+		shared = result;
+	}
+
+	return result;
+}
+
 	}  // detail
 
 
+void preload_font(string const & font_file, unsigned font_size, unsigned dpi)
+{
+	detail::find_font(font_file, font_size, dpi, true);
+}
+
 label::label(unsigned dpi)
-	: _lib{nullptr}, _face{nullptr}, _dpi{dpi}
+	: _dpi{dpi}
 {}
 
 label::~label()
-{
-	for (auto e : _cache)
-		FT_Done_Glyph(e.second);
-
-	FT_Done_Face(_face);
-	FT_Done_FreeType(_lib);
-}
+{}
 
 void label::init(std::string const & font_file, unsigned font_size,
 	glm::vec2 screen_size, glm::vec2 const & pos)
 {
-	assert(!_lib && !_face && "already initialized");
+	assert(!_face && "already initialized");
 	_screen = screen_size;
 	_pos = pos;
-	_text_prog.from_memory(detail::text_gles2_shader_source);  // TODO: toto je super neefektivne (zdielaj pomedzi vsetky ortho_label)
-	FT_Error err = FT_Init_FreeType(&_lib);
-	assert(!err && "unable to init a free-type library");
+	_text_prog = detail::text_program();
 	font(font_file, font_size);
 }
 
 void label::font(string const & font_file, unsigned size)
 {
-	FT_Error err = FT_New_Face(_lib, font_file.c_str(), 0, &_face);
-	assert(!err && "unable to load a font face");
-
-	unsigned font_size = size << 6;  // 26.6
-	err = FT_Set_Char_Size(_face, font_size, font_size, _dpi, _dpi);
-	assert(!err && "freetype set font size failed");
+	_face = detail::find_font(font_file, size, _dpi);
 
 	if (!_text.empty())
 		build_text_texture();
@@ -220,10 +326,10 @@ void label::render()
 	if (_text.empty())
 		return;
 
-	_text_prog.use();
+	_text_prog->use();
 
 	// text texture
-	_text_prog.uniform_variable("s", 0);
+	_text_prog->uniform_variable("s", 0);
 	_text_tex.bind(0);
 
 	// position and scale
@@ -231,7 +337,7 @@ void label::render()
 	vec2 offset{-1 + width()/win_w + 2*(_pos.x/win_w), 1 - height()/win_h - 2*(_pos.y/win_h)};
 	vec2 scale{_text_tex.width()/win_w, _text_tex.height()/win_h};
 
-	_text_prog.uniform_variable("os", vec4{offset.x, offset.y, scale.x, scale.y});
+	_text_prog->uniform_variable("os", vec4{offset.x, offset.y, scale.x, scale.y});
 
 	static mesh m = gl::make_quad_xy<mesh>();  // TODO: zdielaj pomedzi vsetky ortho_label
 	m.render();
@@ -275,17 +381,7 @@ vector<FT_Glyph> label::load_glyphs(string const & s)
 	result.reserve(s.size());
 
 	for (auto char_code : s)
-	{
-		auto glyph_it = _cache.find(char_code);
-		if (glyph_it != _cache.end())
-			result.push_back(glyph_it->second);
-		else
-		{
-			FT_Glyph glyph = detail::load_glyph(char_code, _face);
-			_cache[char_code] = glyph;
-			result.push_back(glyph);
-		}
-	}
+		result.push_back(_face->glyph(char_code));
 
 	return result;
 }
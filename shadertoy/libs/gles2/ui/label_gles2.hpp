@@ -1,7 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
-#include <map>
+#include <memory>
 #include <glm/matrix.hpp>
 #include <ft2build.h>
 #include FT_GLYPH_H
@@ -12,8 +12,20 @@
 
 namespace ui {
 
+	namespace detail {
+struct font_face;
+	}  // detail
+
+/*! nahra font do cache zdielanej vsetkymi label-mi (aj s glyph-mi ASCII znakov),
+neobsahuje OpenGL volania, takze sa da volat z lubovolneho vlakna (napr. pocas
+startu aplikacie) */
+void preload_font(std::string const & font_file, unsigned font_size, unsigned dpi = 96);
+
 /*! Renderovanie text-u.
 
+FreeType kniznica, font (aj s cache glyph-ov) a shader program su zdielane
+vsetkymi label-mi.
+
 Trieda ortho_label adresuje text takymto sposobom
 
 	(0,0)
@@ -53,11 +65,9 @@ private:
 	std::string _text;
 	glm::vec2 _pos;
 	gles2::texture2d _text_tex;
-	gles2::shader::program _text_prog;  // TODO: share program
+	std::shared_ptr<gles2::shader::program> _text_prog;
 	glm::vec2 _screen;
-	FT_Library _lib;
-	FT_Face _face;
-	std::map<unsigned, FT_Glyph> _cache;  // TODO: cache should be shared
+	std::shared_ptr<detail::font_face> _face;
 	unsigned const _dpi;
 };
 
@@ -0,0 +1,244 @@
+// compact mesh pipeline benchmark, compares generated shapes before and after compaction
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <boost/program_options.hpp>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "gl/shapes.hpp"
+#include "gles2/compact_mesh.hpp"
+#include "gles2/framebuffer_gles2.hpp"
+#include "gles2/program_gles2.hpp"
+#include "headless_context.hpp"
+
+using std::cout;
+using std::cerr;
+using std::string;
+using std::vector;
+using std::setw;
+using glm::vec3;
+using glm::mat4;
+using gles2::host_mesh;
+using gles2::compact_mesh_data;
+namespace po = boost::program_options;
+
+using hires_clock = std::chrono::steady_clock;
+using ms = std::chrono::duration<double, std::milli>;
+
+struct shape
+{
+	string name;
+	host_mesh data;
+};
+
+static void print_stats(shape const & s, compact_mesh_data const & c, double build_time);
+static void draw_bench(vector<shape> const & shapes, vector<compact_mesh_data> const & compacted, unsigned draws);
+static double draw_time(gles2::mesh const & m, gles2::shader::program & prog, mat4 const & model, unsigned draws);
+static void bind_attributes(gles2::mesh & m, vector<gles2::attribute> const & attribs, gles2::shader::program const & prog);
+
+// float positions and normals (shape layout)
+char const * float_shader = R"(
+	uniform mat4 local_to_screen;
+	varying vec3 n;
+	#ifdef _VERTEX_
+	attribute vec3 position;
+	attribute vec3 normal;
+	void main() {
+		n = normal;
+		gl_Position = local_to_screen * vec4(position, 1.0);
+	}
+	#endif
+	#ifdef _FRAGMENT_
+	precision mediump float;
+	void main() {
+		gl_FragColor = vec4(normalize(n)*0.5 + 0.5, 1.0);
+	}
+	#endif
+)";
+
+// normalized positions (dequantized by local_to_screen) and octahedral normals
+string const compact_shader = string{R"(
+	uniform mat4 local_to_screen;
+	varying vec3 n;
+	#ifdef _VERTEX_
+	attribute vec3 position;
+	attribute vec2 normal;
+)"} + gles2::octahedral_decode_glsl + R"(
+	void main() {
+		n = octahedral_decode(normal);
+		gl_Position = local_to_screen * vec4(position, 1.0);
+	}
+	#endif
+	#ifdef _FRAGMENT_
+	precision mediump float;
+	void main() {
+		gl_FragColor = vec4(normalize(n)*0.5 + 0.5, 1.0);
+	}
+	#endif
+)";
+
+int main(int argc, char * argv[])
+{
+	po::options_description desc{"mesh_bench options"};
+	desc.add_options()
+		("help", "produce help messages")
+		("segments", po::value<unsigned>()->default_value(64), "shape tessellation (sphere, cylinder and torus segments)")
+		("draw", po::value<unsigned>()->default_value(0), "measure GPU time of N draws for each mesh (needs OpenGL ES 2 context)");
+
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	po::notify(vm);
+
+	if (vm.count("help"))
+	{
+		cout << desc << std::endl;
+		return 1;
+	}
+
+	unsigned const n = vm["segments"].as<unsigned>();
+
+	vector<shape> shapes;
+	shapes.push_back(shape{"sphere", gl::make_sphere<host_mesh>(1.0f, n, 3*n/4)});
+	shapes.push_back(shape{"cylinder", gl::make_cylinder<host_mesh>(1.0f, 2.0f, n)});
+	shapes.push_back(shape{"torus", gl::make_torus<host_mesh>(1.0f, 0.3f, n, n/2)});
+	shapes.push_back(shape{"plane", gl::make_plane_xz<host_mesh>(vec3{0,0,0}, 1.0f, 2*n+1, 2*n+1)});
+
+	cout << std::left << setw(10) << "shape" << std::right
+		<< setw(8) << "verts" << setw(8) << "tris"
+		<< setw(10) << "stride" << setw(18) << "vertex bytes" << setw(18) << "index bytes"
+		<< setw(16) << "ACMR(16)" << setw(16) << "ACMR(32)" << setw(12) << "build ms" << "\n";
+
+	vector<compact_mesh_data> compacted;
+	for (shape const & s : shapes)
+	{
+		hires_clock::time_point t0 = hires_clock::now();
+		vector<gles2::vertex> verts = s.data.vertices();
+		gles2::vertex_layout layout = gles2::select_vertex_layout(verts);
+		compacted.push_back(gles2::compact_vertices(verts, s.data.indices(), layout));
+		double build_time = ms{hires_clock::now() - t0}.count();
+
+		print_stats(s, compacted.back(), build_time);
+	}
+
+	if (unsigned draws = vm["draw"].as<unsigned>())
+	{
+		try {
+			draw_bench(shapes, compacted, draws);
+		}
+		catch (std::exception & e) {
+			cerr << "error: " << e.what() << std::endl;
+			return 2;
+		}
+	}
+
+	return 0;
+}
+
+void print_stats(shape const & s, compact_mesh_data const & c, double build_time)
+{
+	vector<unsigned> indices{c.short_indices.begin(), c.short_indices.end()};
+	if (indices.empty())
+		indices = c.indices;
+
+	auto before_after = [](auto before, auto after) {
+		return std::to_string(before) + "->" + std::to_string(after);
+	};
+
+	auto ratio = [](double before, double after) {
+		std::ostringstream out;
+		out << std::fixed << std::setprecision(3) << before << "->" << after;
+		return out.str();
+	};
+
+	cout << std::left << setw(10) << s.name << std::right
+		<< setw(8) << c.vertex_count << setw(8) << s.data.indices().size()/3
+		<< setw(10) << before_after(s.data.attributes().front().stride, c.layout.stride())
+		<< setw(18) << before_after(s.data.vertex_bytes(), c.vertex_bytes())
+		<< setw(18) << before_after(s.data.index_bytes(), c.index_bytes())
+		<< setw(16) << ratio(gles2::acmr(s.data.indices(), 16), gles2::acmr(indices, 16))
+		<< setw(16) << ratio(gles2::acmr(s.data.indices(), 32), gles2::acmr(indices, 32))
+		<< setw(12) << std::fixed << std::setprecision(2) << build_time << "\n";
+}
+
+void draw_bench(vector<shape> const & shapes, vector<compact_mesh_data> const & compacted, unsigned draws)
+{
+	if (!glfwInit())
+		throw std::runtime_error{"GLFW initialization failed"};
+
+	{
+		headless_context ctx;
+		ctx.make_current();
+
+		gles2::framebuffer fbo{512, 512, true};
+		fbo.bind();
+		glEnable(GL_DEPTH_TEST);
+
+		gles2::shader::program float_prog, compact_prog;
+		float_prog.from_memory(float_shader);
+		compact_prog.from_memory(compact_shader);
+
+		mat4 view_proj = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f)
+			* glm::lookAt(vec3{0, 2, 3.5}, vec3{0, 0, 0}, vec3{0, 1, 0});
+
+		cout << "\n" << std::left << setw(10) << "shape" << std::right
+			<< setw(16) << "float ms/draw" << setw(18) << "compact ms/draw" << "\n";
+
+		for (size_t i = 0; i < shapes.size(); ++i)
+		{
+			host_mesh const & h = shapes[i].data;
+			gles2::mesh before{h.vertex_data(), h.vertex_bytes(), h.indices().data(), h.indices().size()};  // 32-bit indices
+			for (gles2::attribute const & a : h.attributes())
+				before.append_attribute(a);
+			bind_attributes(before, h.attributes(), float_prog);
+
+			gles2::mesh after = gles2::mesh_from_compact(compacted[i]);
+			bind_attributes(after, compacted[i].attributes, compact_prog);
+
+			double t_before = draw_time(before, float_prog, view_proj, draws),
+				t_after = draw_time(after, compact_prog, view_proj * compacted[i].position_transform(), draws);
+
+			cout << std::left << setw(10) << shapes[i].name << std::right << std::fixed << std::setprecision(4)
+				<< setw(16) << t_before << setw(18) << t_after << "\n";
+		}
+
+		fbo.unbind();
+		ctx.release();
+	}
+
+	glfwTerminate();
+}
+
+double draw_time(gles2::mesh const & m, gles2::shader::program & prog, mat4 const & local_to_screen, unsigned draws)
+{
+	prog.use();
+	prog.uniform_variable("local_to_screen", local_to_screen);
+
+	glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+	m.render();  // warm up
+	glFinish();
+
+	hires_clock::time_point t0 = hires_clock::now();
+	for (unsigned i = 0; i < draws; ++i)
+		m.render();
+	glFinish();
+
+	return ms{hires_clock::now() - t0}.count() / draws;
+}
+
+void bind_attributes(gles2::mesh & m, vector<gles2::attribute> const & attribs, gles2::shader::program const & prog)
+{
+	// mesh attribute indices are position:0, uv:1, normal:2, tangent:3
+	for (size_t i = 0; i < attribs.size(); ++i)
+	{
+		switch (attribs[i].index)
+		{
+			case 0: m.attribute_location(i, prog.attribute_location("position")); break;
+			case 2: m.attribute_location(i, prog.attribute_location("normal")); break;
+			default: m.attribute_location(i, -1);  // not used
+		}
+	}
+}
@@ -0,0 +1,446 @@
+#include <iostream>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <Magick++.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include "mjpeg_server.hpp"
+
+using std::string;
+using std::to_string;
+using std::make_shared;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::cerr;
+using std::cout;
+using clock_type = std::chrono::steady_clock;
+
+static string const boundary = "shadertoyframe";
+
+static string encode_jpeg(video_frame const & frame, unsigned quality);
+static string http_response(string const & status, string const & type, string const & body);
+static std::runtime_error system_error(string const & what);
+
+mjpeg_server::mjpeg_server(uint16_t port, float max_fps, unsigned quality)
+	: _listen_fd{-1}
+	, _epoll_fd{-1}
+	, _event_fd{-1}
+	, _min_period{std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>{1.0 / max_fps})}
+	, _quality{quality}
+	, _has_pending{false}
+	, _quit{false}
+	, _generation{0}
+{
+	_listen_fd = socket(AF_INET, SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC, 0);
+	if (_listen_fd < 0)
+		throw system_error("unable to create socket");
+
+	int on = 1;
+	setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+
+	if (bind(_listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || listen(_listen_fd, 16) < 0)
+	{
+		std::runtime_error e = system_error("unable to listen on port " + to_string(port));  // before close() changes errno
+		close(_listen_fd);
+		throw e;
+	}
+
+	_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (_epoll_fd < 0)
+	{
+		std::runtime_error e = system_error("unable to create epoll instance");
+		close(_listen_fd);
+		throw e;
+	}
+
+	_event_fd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+	if (_event_fd < 0)
+	{
+		std::runtime_error e = system_error("unable to create wake up event");
+		close(_epoll_fd);
+		close(_listen_fd);
+		throw e;
+	}
+
+	epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.fd = _listen_fd;
+	int listen_added = epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _listen_fd, &ev);
+	ev.data.fd = _event_fd;
+	if (listen_added < 0 || epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &ev) < 0)
+	{
+		std::runtime_error e = system_error("unable to watch server sockets");
+		close(_event_fd);
+		close(_epoll_fd);
+		close(_listen_fd);
+		throw e;
+	}
+
+	_last_submit = clock_type::now() - _min_period;
+
+	_encoder = std::thread{&mjpeg_server::encode_loop, this};
+	_server = std::thread{&mjpeg_server::serve_loop, this};
+
+	cout << "live preview at http://localhost:" << port << "/" << std::endl;
+}
+
+mjpeg_server::~mjpeg_server()
+{
+	{
+		lock_guard<mutex> lock{_lock};
+		_quit = true;
+	}
+	_frame_ready.notify_one();
+
+	uint64_t one = 1;
+	if (write(_event_fd, &one, sizeof(one)) < 0)
+		cerr << "warning: unable to wake up preview server" << std::endl;
+
+	_encoder.join();
+	_server.join();
+
+	for (auto & c : _clients)
+		close(c.first);
+
+	close(_event_fd);
+	close(_epoll_fd);
+	close(_listen_fd);
+}
+
+bool mjpeg_server::wants_frame() const
+{
+	lock_guard<mutex> lock{_lock};
+	return clock_type::now() - _last_submit >= _min_period;
+}
+
+void mjpeg_server::submit(video_frame && frame)
+{
+	{
+		lock_guard<mutex> lock{_lock};
+		_pending = std::move(frame);
+		_has_pending = true;
+		_last_submit = clock_type::now();
+	}
+	_frame_ready.notify_one();
+}
+
+void mjpeg_server::encode_loop()
+{
+	while (true)
+	{
+		video_frame frame;
+
+		{
+			unique_lock<mutex> lock{_lock};
+			_frame_ready.wait(lock, [this]{return _has_pending || _quit;});
+			if (_quit)
+				break;
+
+			frame = std::move(_pending);
+			_has_pending = false;
+		}
+
+		jpeg_ptr jpeg;
+		try {
+			jpeg = make_shared<string const>(encode_jpeg(frame, _quality));
+		}
+		catch (std::exception & e) {
+			cerr << "error: unable to encode preview frame, what: " << e.what() << std::endl;
+			continue;
+		}
+
+		{
+			lock_guard<mutex> lock{_lock};
+			_jpeg = jpeg;
+			++_generation;
+		}
+
+		uint64_t one = 1;
+		if (write(_event_fd, &one, sizeof(one)) < 0)
+			cerr << "warning: unable to notify preview server" << std::endl;
+	}
+}
+
+void mjpeg_server::serve_loop()
+{
+	epoll_event events[32];
+
+	while (true)
+	{
+		int n = epoll_wait(_epoll_fd, events, 32, -1);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			cerr << "error: preview server failed, what: " << strerror(errno) << std::endl;
+			break;
+		}
+
+		for (int i = 0; i < n; ++i)
+		{
+			int fd = events[i].data.fd;
+
+			if (fd == _listen_fd)
+				accept_clients();
+			else if (fd == _event_fd)
+			{
+				uint64_t count;
+				if (read(_event_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+					cerr << "warning: unable to read preview server event" << std::endl;
+
+				{
+					lock_guard<mutex> lock{_lock};
+					if (_quit)
+						return;
+				}
+
+				for (auto & kv : _clients)
+					if (kv.second.streaming && kv.second.chunks.empty())  // busy clients skip the frame
+						send_frame(kv.first, kv.second);
+
+				// failed clients are closed after iteration
+				for (auto it = _clients.begin(); it != _clients.end();)
+				{
+					int cfd = it->first;
+					bool failed = it->second.close_after_send && it->second.chunks.empty();
+					++it;
+					if (failed)
+						close_client(cfd);
+				}
+			}
+			else
+			{
+				auto it = _clients.find(fd);
+				if (it == _clients.end())
+					continue;
+
+				client & c = it->second;
+
+				if (events[i].events & (EPOLLERR|EPOLLHUP))
+				{
+					close_client(fd);
+					continue;
+				}
+
+				if (events[i].events & EPOLLIN)
+					read_request(fd, c);
+				else if (events[i].events & EPOLLOUT)
+				{
+					if (!flush(fd, c))
+						close_client(fd);
+					else if (c.chunks.empty())
+					{
+						if (c.close_after_send)
+							close_client(fd);
+						else if (c.streaming)
+							send_frame(fd, c);  // newer frame could be encoded while sending
+					}
+				}
+			}
+		}
+	}
+}
+
+void mjpeg_server::accept_clients()
+{
+	while (true)
+	{
+		int fd = accept4(_listen_fd, nullptr, nullptr, SOCK_NONBLOCK|SOCK_CLOEXEC);
+		if (fd < 0)
+			return;  // EAGAIN
+
+		int on = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+		epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.fd = fd;
+		epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+
+		_clients[fd] = client{};
+	}
+}
+
+void mjpeg_server::read_request(int fd, client & c)
+{
+	char buf[1024];
+	ssize_t n = recv(fd, buf, sizeof(buf), 0);
+	if (n <= 0)
+	{
+		if (n == 0 || errno != EAGAIN)
+			close_client(fd);
+		return;
+	}
+
+	if (c.streaming || c.close_after_send)  // request already handled, ignore
+		return;
+
+	c.request.append(buf, n);
+	if (c.request.find("\r\n\r\n") == string::npos)
+	{
+		if (c.request.size() > 8192)
+			close_client(fd);
+		return;
+	}
+
+	// request line 'GET PATH HTTP/1.1'
+	string line = c.request.substr(0, c.request.find("\r\n"));
+	size_t path_begin = line.find(' '),
+		path_end = line.find(' ', path_begin + 1);
+	string path = path_begin != string::npos && path_end != string::npos ?
+		line.substr(path_begin + 1, path_end - path_begin - 1) : string{};
+
+	if (line.compare(0, 4, "GET ") != 0)
+	{
+		c.chunks.push_back(make_shared<string const>(http_response("405 Method Not Allowed", "text/plain", "method not allowed\n")));
+		c.close_after_send = true;
+	}
+	else if (path == "/")
+	{
+		string page = "<html><head><title>shadertoy</title></head>"
+			"<body style=\"margin:0;background:#000\"><img src=\"/stream\" style=\"width:100%\"></body></html>\n";
+		c.chunks.push_back(make_shared<string const>(http_response("200 OK", "text/html", page)));
+		c.close_after_send = true;
+	}
+	else if (path == "/frame.jpg")
+	{
+		jpeg_ptr jpeg;
+		{
+			lock_guard<mutex> lock{_lock};
+			jpeg = _jpeg;
+		}
+
+		if (jpeg)
+		{
+			c.chunks.push_back(make_shared<string const>("HTTP/1.1 200 OK\r\nContent-Type: image/jpeg\r\n"
+				"Content-Length: " + to_string(jpeg->size()) + "\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\n"));
+			c.chunks.push_back(jpeg);
+		}
+		else
+			c.chunks.push_back(make_shared<string const>(http_response("503 Service Unavailable", "text/plain", "no frame yet\n")));
+
+		c.close_after_send = true;
+	}
+	else if (path == "/stream")
+	{
+		c.chunks.push_back(make_shared<string const>("HTTP/1.1 200 OK\r\n"
+			"Content-Type: multipart/x-mixed-replace; boundary=" + boundary + "\r\n"
+			"Cache-Control: no-cache\r\nConnection: close\r\n\r\n"));
+		c.streaming = true;
+	}
+	else
+	{
+		c.chunks.push_back(make_shared<string const>(http_response("404 Not Found", "text/plain", "not found\n")));
+		c.close_after_send = true;
+	}
+
+	if (c.streaming)
+		send_frame(fd, c);  // the latest frame, if any
+	else if (!flush(fd, c) || (c.chunks.empty() && c.close_after_send))
+		close_client(fd);
+}
+
+//! queues the latest frame if not sent yet
+void mjpeg_server::send_frame(int fd, client & c)
+{
+	jpeg_ptr jpeg;
+	uint64_t generation;
+	{
+		lock_guard<mutex> lock{_lock};
+		jpeg = _jpeg;
+		generation = _generation;
+	}
+
+	if (jpeg && generation != c.generation)
+	{
+		c.chunks.push_back(make_shared<string const>("--" + boundary + "\r\nContent-Type: image/jpeg\r\n"
+			"Content-Length: " + to_string(jpeg->size()) + "\r\n\r\n"));
+		c.chunks.push_back(jpeg);  // shared, not copied
+		c.chunks.push_back(make_shared<string const>("\r\n"));
+		c.generation = generation;
+	}
+
+	if (!flush(fd, c))  // closed later by the caller
+	{
+		c.chunks.clear();
+		c.close_after_send = true;
+	}
+}
+
+bool mjpeg_server::flush(int fd, client & c)
+{
+	while (!c.chunks.empty())
+	{
+		string const & data = *c.chunks.front();
+		ssize_t n = send(fd, data.data() + c.offset, data.size() - c.offset, MSG_NOSIGNAL);
+		if (n < 0)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				watch_output(fd, true);  // continue on EPOLLOUT
+				return true;
+			}
+			return false;
+		}
+
+		c.offset += n;
+		if (c.offset == data.size())
+		{
+			c.chunks.erase(c.chunks.begin());
+			c.offset = 0;
+		}
+	}
+
+	watch_output(fd, false);
+	return true;
+}
+
+void mjpeg_server::watch_output(int fd, bool enable)
+{
+	epoll_event ev;
+	ev.events = EPOLLIN | (enable ? EPOLLOUT : 0);
+	ev.data.fd = fd;
+	epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void mjpeg_server::close_client(int fd)
+{
+	epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+	close(fd);
+	_clients.erase(fd);
+}
+
+string encode_jpeg(video_frame const & frame, unsigned quality)
+{
+	Magick::Image im{frame.width, frame.height, "RGBA", Magick::CharPixel, frame.pixels.data()};
+	im.flip();  // frame rows are bottom-up
+	im.quality(quality);
+	im.magick("JPEG");
+
+	Magick::Blob blob;
+	im.write(&blob);
+	return string{static_cast<char const *>(blob.data()), blob.length()};
+}
+
+string http_response(string const & status, string const & type, string const & body)
+{
+	return "HTTP/1.1 " + status + "\r\nContent-Type: " + type + "\r\nContent-Length: " + to_string(body.size())
+		+ "\r\nConnection: close\r\n\r\n" + body;
+}
+
+std::runtime_error system_error(string const & what)
+{
+	return std::runtime_error{what + ", what: " + strerror(errno)};
+}
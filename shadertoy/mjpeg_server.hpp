@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include "frame_sink.hpp"
+
+/*! Live preview HTTP server streaming rendered frames as MJPEG.
+
+Served resources:
+- `/` HTML page showing the stream,
+- `/stream` multipart/x-mixed-replace JPEG stream,
+- `/frame.jpg` the latest frame.
+
+Frames are encoded in a worker thread at a capped rate (submit() never
+blocks), connections are handled by a single epoll thread. Clients still
+sending the previous frame skip newer frames (they always get the latest
+one) so a slow client never queues frames.
+\code
+mjpeg_server http{8080};
+if (http.wants_frame())  // rate cap, skips glReadPixels() for frames which would be dropped anyway
+	http.submit(read_frame(w, h));
+\endcode
+test with `curl -o frame.jpg http://localhost:8080/frame.jpg` */
+class mjpeg_server
+{
+public:
+	mjpeg_server(uint16_t port, float max_fps = 10.0f, unsigned quality = 80);
+	~mjpeg_server();
+	bool wants_frame() const;  //!< true if frame submitted now would be encoded
+	void submit(video_frame && frame);  //!< replaces frame waiting for encoding
+
+	mjpeg_server(mjpeg_server const &) = delete;
+	void operator=(mjpeg_server const &) = delete;
+
+private:
+	using jpeg_ptr = std::shared_ptr<std::string const>;
+
+	struct client
+	{
+		std::string request;
+		bool streaming = false;
+		bool close_after_send = false;
+		uint64_t generation = 0;  //!< last frame sent
+		std::vector<jpeg_ptr> chunks;  //!< data to send
+		size_t offset = 0;  //!< in the first chunk
+	};
+
+	void encode_loop();
+	void serve_loop();
+	void accept_clients();
+	void read_request(int fd, client & c);
+	void send_frame(int fd, client & c);
+	bool flush(int fd, client & c);  //!< returns false on error
+	void watch_output(int fd, bool enable);
+	void close_client(int fd);
+
+	int _listen_fd, _epoll_fd, _event_fd;  //!< event fd wakes server after new frame is encoded or on quit
+	std::chrono::steady_clock::duration _min_period;
+	unsigned _quality;
+	std::map<int, client> _clients;
+
+	// shared between threads
+	mutable std::mutex _lock;
+	std::condition_variable _frame_ready;
+	video_frame _pending;
+	bool _has_pending, _quit;
+	std::chrono::steady_clock::time_point _last_submit;
+	jpeg_ptr _jpeg;  //!< latest encoded frame
+	uint64_t _generation;
+
+	std::thread _encoder, _server;
+};
@@ -0,0 +1,100 @@
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+#include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include "playlist.hpp"
+
+using std::string;
+using std::vector;
+using std::ifstream;
+using boost::algorithm::ends_with;
+using boost::algorithm::starts_with;
+using boost::algorithm::trim;
+namespace fs = boost::filesystem;
+
+static vector<string> directory_files(fs::path const & dir);
+static vector<string> list_files(fs::path const & fname);
+
+playlist::playlist()
+	: _idx{0}
+{}
+
+bool playlist::load(string const & path)
+{
+	if (fs::is_directory(path))
+		_files = directory_files(path);
+	else
+		_files = list_files(path);
+
+	_idx = 0;
+	return !_files.empty();
+}
+
+string const & playlist::current() const
+{
+	assert(!_files.empty());
+	return _files[_idx];
+}
+
+string const & playlist::peek() const
+{
+	assert(!_files.empty());
+	return _files[(_idx + 1) % _files.size()];
+}
+
+void playlist::next()
+{
+	if (!_files.empty())
+		_idx = (_idx + 1) % _files.size();
+}
+
+size_t playlist::size() const
+{
+	return _files.size();
+}
+
+bool playlist::empty() const
+{
+	return _files.empty();
+}
+
+vector<string> directory_files(fs::path const & dir)
+{
+	vector<string> result;
+	for (fs::directory_iterator it{dir}; it != fs::directory_iterator{}; ++it)
+	{
+		string fname = it->path().string();
+		if (fs::is_regular_file(it->path()) && (ends_with(fname, ".glsl") || ends_with(fname, ".stoy") || ends_with(fname, ".stoyb")))
+			result.push_back(fname);
+	}
+
+	sort(result.begin(), result.end());
+	return result;
+}
+
+vector<string> list_files(fs::path const & fname)
+{
+	ifstream fin{fname.string()};
+	if (!fin.is_open())
+		throw std::runtime_error{"unable to open '" + fname.string() + "' playlist"};
+
+	vector<string> result;
+	string line;
+	while (getline(fin, line))
+	{
+		trim(line);
+		if (line.empty() || starts_with(line, "#"))
+			continue;
+
+		fs::path p{line};
+		if (p.is_relative())
+			p = fname.parent_path() / p;
+
+		result.push_back(p.string());
+	}
+
+	return result;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/*! List of shader (or project) files to show in a loop.
+
+Playlist is loaded from a directory (all `*.glsl` and `*.stoy` files in
+alphabetical order) or from a list file with one file per line (empty
+lines and lines starting with `#` are ignored, relative paths are relative
+to the list file).
+\code
+playlist pl;
+pl.load("signage.lst");
+load_program(pl.current());
+// ...
+pl.next();
+\endcode */
+class playlist
+{
+public:
+	playlist();
+	bool load(std::string const & path);  //!< returns false for empty playlist
+	std::string const & current() const;
+	std::string const & peek() const;  //!< file following the current one
+	void next();
+	size_t size() const;
+	bool empty() const;
+
+private:
+	std::vector<std::string> _files;
+	size_t _idx;
+};
@@ -0,0 +1,209 @@
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+#include <boost/algorithm/string/predicate.hpp>
+#include "project_file.hpp"
+#include "project_bundle.hpp"
+#include "utility.hpp"
+#include "program_preloader.hpp"
+
+using std::string;
+using std::unique_ptr;
+using std::shared_ptr;
+using std::make_shared;
+using std::vector;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::cerr;
+using boost::algorithm::ends_with;
+using gles2::texture2d;
+
+static bool prepare_bundle(string const & fname, shadertoy_program::specialization const & spec,
+	prepared_program & result);
+
+bool prepare_program(string const & fname, shadertoy_program::specialization const & spec,
+	prepared_program & result)
+{
+	result.fname = fname;
+	result.ok = false;
+
+	string shader = fname;
+	shadertoy_program::specialization prog_spec = spec;
+
+	if (ends_with(fname, ".stoy"))  // project file
+	{
+		io::project_file prj;
+		if (!prj.load(fname))
+			return false;
+
+		shader = resolve_project_path(fname, prj.shader_program());
+		result.defines = prj.defines();
+		prog_spec.defines = result.defines;
+
+		// textures first, channel sizes can be part of the program
+		resource_loader & cache = channel_texture_cache();
+		vector<string> const & resources = prj.program_textures();
+		vector<shared_ptr<channel_source>> channels(resources.size());
+		vector<resource_loader::future<texture2d>> images(resources.size());  // decoded in parallel
+
+		for (size_t i = 0; i < resources.size(); ++i)
+		{
+			string path = resolve_project_path(fname, resources[i]);
+			channels[i] = make_channel_source(path);
+			if (!channels[i])
+				images[i] = cache.from_file_async<texture2d>(path);
+		}
+
+		result.prog.free_textures();
+		for (size_t i = 0; i < resources.size(); ++i)
+		{
+			if (channels[i])
+			{
+				result.channels.push_back(channels[i]);
+				result.textures.push_back(channels[i]->texture());
+			}
+			else
+				result.textures.push_back(cache.get(images[i]));
+
+			result.textures.back()->label(resources[i]);
+			result.prog.attach(result.textures.back());
+		}
+	}
+	else if (ends_with(fname, ".stoyb"))  // packed project
+		return prepare_bundle(fname, spec, result);
+
+	result.ok = result.prog.load(shader, prog_spec);
+	return result.ok;
+}
+
+bool prepare_bundle(string const & fname, shadertoy_program::specialization const & spec,
+	prepared_program & result)
+{
+	io::project_bundle bundle{fname};  // one mapping, nothing is decoded
+
+	shadertoy_program::specialization prog_spec = spec;
+	result.defines = bundle.defines();
+	prog_spec.defines = result.defines;
+
+	result.prog.free_textures();
+	for (io::project_bundle::channel const & ch : bundle.channels())
+	{
+		if (ch.dynamic)
+		{
+			shared_ptr<channel_source> source = make_channel_source(ch.name);
+			if (!source)
+				throw std::runtime_error{"unknown '" + ch.name + "' channel resource"};
+
+			result.channels.push_back(source);
+			result.textures.push_back(source->texture());
+		}
+		else
+		{
+			io::project_bundle::texture_data const & tex = ch.texture;
+			result.textures.push_back(make_shared<texture2d>(tex.width, tex.height, tex.format, tex.type,
+				tex.pixels, tex.params));
+		}
+
+		result.textures.back()->label(ch.name);
+		result.prog.attach(result.textures.back());
+	}
+
+	shader_source src;
+	src.code = string{bundle.source()};
+	src.dependencies.push_back(bundle.shader_program());
+	src.hash = std::hash<string>{}(src.code);
+
+	result.ok = result.prog.load_source(bundle.shader_program(), src, prog_spec);
+	return result.ok;
+}
+
+resource_loader & channel_texture_cache()
+{
+	static resource_loader result{size_t{256} << 20};
+	return result;
+}
+
+program_preloader::program_preloader(GLFWwindow * share, bool optimize)
+	: _ctx{64, 64, share}
+	, _optimize{optimize}
+	, _requested{false}
+	, _quit{false}
+{
+	_worker = std::thread{&program_preloader::loop, this};
+}
+
+program_preloader::~program_preloader()
+{
+	{
+		lock_guard<mutex> lock{_lock};
+		_quit = true;
+	}
+	_cond.notify_one();
+	_worker.join();
+}
+
+void program_preloader::prepare(string const & fname, shadertoy_program::specialization const & spec)
+{
+	{
+		lock_guard<mutex> lock{_lock};
+		_fname = fname;
+		_spec = spec;
+		_requested = true;
+		_result.reset();
+	}
+	_cond.notify_one();
+}
+
+bool program_preloader::ready() const
+{
+	lock_guard<mutex> lock{_lock};
+	return _result != nullptr;
+}
+
+unique_ptr<prepared_program> program_preloader::take()
+{
+	lock_guard<mutex> lock{_lock};
+	return std::move(_result);
+}
+
+void program_preloader::loop()
+{
+	_ctx.make_current();
+
+	while (true)
+	{
+		string fname;
+		shadertoy_program::specialization spec;
+
+		{
+			unique_lock<mutex> lock{_lock};
+			_cond.wait(lock, [this]{return _requested || _quit;});
+			if (_quit)
+				break;
+
+			fname = _fname;
+			spec = _spec;
+			_requested = false;
+		}
+
+		unique_ptr<prepared_program> result{new prepared_program};
+		result->prog.optimize(_optimize);
+
+		try {
+			prepare_program(fname, spec, *result);
+		}
+		catch (std::exception & e) {
+			cerr << "error: unable to prepare '" << fname << "' program, what: " << e.what() << std::endl;
+			result->ok = false;
+		}
+
+		glFinish();  // objects needs to be complete before the main context uses them
+
+		lock_guard<mutex> lock{_lock};
+		if (!_requested)  // not replaced by a newer request in the meantime
+			_result = std::move(result);
+	}
+
+	_ctx.release();
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "gles2/texture_gles2.hpp"
+#include "gles2/resource_loader.hpp"
+#include "headless_context.hpp"
+#include "shadertoy_program.hpp"
+#include "channel_source.hpp"
+
+//! shader program with its channel textures ready to render
+struct prepared_program
+{
+	std::string fname;  //!< shader or project file
+	bool ok = false;
+	shadertoy_program prog;
+	std::vector<std::shared_ptr<gles2::texture2d>> textures;
+	std::vector<std::shared_ptr<channel_source>> channels;  //!< dynamic channels (textures are part of textures)
+	std::map<std::string, std::string> defines;  //!< project defines
+};
+
+/*! loads shader, project or project bundle file fname (channel textures
+included) into result, spec defines are replaced by project defines, channel
+images are decoded in parallel and shared through channel_texture_cache(),
+bundle textures are uploaded from the mapped bundle \sa io::project_bundle */
+bool prepare_program(std::string const & fname, shadertoy_program::specialization const & spec,
+	prepared_program & result);
+
+/*! channel textures shared by loaded programs, unused textures are evicted
+over budget (256 MiB by default), thread-safe */
+resource_loader & channel_texture_cache();
+
+/*! Prepares (compiles program, decodes and uploads channel textures) next
+shader program in a worker thread with a context shared with the main
+window, so switching to the prepared program does not stall rendering.
+\note Needs to be created and destroyed in the main thread.
+\code
+program_preloader preloader{native_window()};
+preloader.prepare("explosion.glsl", spec);
+// ...
+if (preloader.ready())
+	unique_ptr<prepared_program> p = preloader.take();
+\endcode */
+class program_preloader
+{
+public:
+	program_preloader(GLFWwindow * share, bool optimize = false);
+	~program_preloader();
+	void prepare(std::string const & fname, shadertoy_program::specialization const & spec);  //!< replaces not yet started request
+	bool ready() const;
+	std::unique_ptr<prepared_program> take();  //!< returns prepared program or nullptr if not ready yet
+
+	program_preloader(program_preloader const &) = delete;
+	void operator=(program_preloader const &) = delete;
+
+private:
+	void loop();
+
+	headless_context _ctx;
+	bool _optimize;
+	std::string _fname;  //!< requested file
+	shadertoy_program::specialization _spec;
+	bool _requested, _quit;
+	std::unique_ptr<prepared_program> _result;
+	mutable std::mutex _lock;
+	std::condition_variable _cond;
+	std::thread _worker;
+};
@@ -0,0 +1,326 @@
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <stdexcept>
+#include <boost/algorithm/string/predicate.hpp>
+#include "gles2/texture_loader_gles2.hpp"
+#include "shader_preprocessor.hpp"
+#include "channel_source.hpp"
+#include "project_file.hpp"
+#include "utility.hpp"
+#include "project_bundle.hpp"
+
+namespace io {
+
+using std::string;
+using std::string_view;
+using std::vector;
+using std::map;
+using std::ofstream;
+using boost::algorithm::ends_with;
+using gles2::texture_filter;
+using gles2::texture_wrap;
+
+namespace {
+
+char const magic[4] = {'S', 'T', 'Y', 'B'};
+uint32_t const version = 1;
+size_t const alignment = 16;
+
+struct file_header
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t section_count;
+	uint32_t reserved;
+};
+
+struct section_entry
+{
+	uint32_t kind;  //!< project_bundle::section_kind
+	uint32_t name_size;
+	uint64_t offset;  //!< from the beginning of the file
+	uint64_t size;  //!< name and payload size (with padding)
+};
+
+struct texture_header
+{
+	uint32_t width, height;
+	uint32_t format;  //!< gles2::pixel_format
+	uint32_t type;  //!< gles2::pixel_type
+	uint32_t min, mag;  //!< gles2::texture_filter
+	uint32_t wrap_s, wrap_t;  //!< gles2::texture_wrap
+};
+
+static_assert(sizeof(file_header) == 16 && sizeof(section_entry) == 24 && sizeof(texture_header) == 32,
+	"unexpected bundle structure layout");
+
+struct section
+{
+	project_bundle::section_kind kind;
+	string name;
+	string payload;
+};
+
+size_t aligned(size_t n)
+{
+	return (n + alignment - 1) / alignment * alignment;
+}
+
+size_t pixel_size(gles2::pixel_format fmt, gles2::pixel_type type)
+{
+	if (type != gles2::pixel_type::ub8)  // packed 16 bit types
+		return 2;
+
+	switch (fmt)
+	{
+		case gles2::pixel_format::alpha:
+		case gles2::pixel_format::luminance: return 1;
+		case gles2::pixel_format::luminance_alpha: return 2;
+		case gles2::pixel_format::rgb: return 3;
+		default: return 4;
+	}
+}
+
+template <typename T>
+void append_value(string & out, T const & v)
+{
+	out.append(reinterpret_cast<char const *>(&v), sizeof(T));
+}
+
+}  // namespace
+
+project_bundle::project_bundle()
+{}
+
+project_bundle::project_bundle(string const & fname)
+{
+	open(fname);
+}
+
+void project_bundle::open(string const & fname)
+{
+	_file.open(fname);
+	_prog.clear();
+	_source = string_view{};
+	_defs.clear();
+	_channels.clear();
+
+	auto corrupted = [&fname](char const * what) {
+		return std::runtime_error{"corrupted '" + fname + "' bundle (" + what + ")"};
+	};
+
+	char const * data = _file.data();
+	size_t const size = _file.size();
+
+	file_header header;
+	if (size < sizeof(header))
+		throw std::runtime_error{"'" + fname + "' is not a shadertoy bundle"};
+
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, magic, sizeof(magic)) != 0)
+		throw std::runtime_error{"'" + fname + "' is not a shadertoy bundle"};
+
+	if (header.version != version)
+		throw std::runtime_error{"unsupported '" + fname + "' bundle version " + std::to_string(header.version)};
+
+	if (header.section_count > (size - sizeof(header)) / sizeof(section_entry))
+		throw corrupted("section table");
+
+	for (uint32_t i = 0; i < header.section_count; ++i)
+	{
+		section_entry e;
+		memcpy(&e, data + sizeof(header) + i*sizeof(e), sizeof(e));
+
+		if (e.offset > size || e.size > size - e.offset || e.name_size > e.size)
+			throw corrupted("section out of file");
+
+		string name{data + e.offset, e.name_size};
+		size_t payload_offset = aligned(e.name_size);
+		string_view payload = payload_offset < e.size
+			? string_view{data + e.offset + payload_offset, size_t(e.size - payload_offset)} : string_view{};
+
+		switch (section_kind(e.kind))
+		{
+			case section_kind::program:
+				_prog = name;
+				_source = payload;
+				break;
+
+			case section_kind::defines:
+			{
+				std::istringstream in{string{payload}};
+				for (string line; getline(in, line);)
+				{
+					size_t sep = line.find(' ');
+					_defs[line.substr(0, sep)] = sep != string::npos ? line.substr(sep + 1) : string{};
+				}
+				break;
+			}
+
+			case section_kind::texture:
+			{
+				texture_header th;
+				if (payload.size() < sizeof(th))
+					throw corrupted("texture header");
+
+				memcpy(&th, payload.data(), sizeof(th));
+
+				channel ch;
+				ch.name = name;
+				texture_data & tex = ch.texture;
+				tex.width = th.width;
+				tex.height = th.height;
+				tex.format = gles2::pixel_format(th.format);
+				tex.type = gles2::pixel_type(th.type);
+				tex.params.filter(texture_filter(th.min), texture_filter(th.mag))
+					.wrap_s(texture_wrap(th.wrap_s)).wrap_t(texture_wrap(th.wrap_t));
+				tex.pixels = payload.data() + sizeof(th);
+
+				size_t row = (size_t(th.width) * pixel_size(tex.format, tex.type) + 3) / 4 * 4;  // GL_UNPACK_ALIGNMENT
+				if (th.width == 0 || th.height == 0 || row * th.height > payload.size() - sizeof(th))
+					throw corrupted("texture data");
+
+				_channels.push_back(ch);
+				break;
+			}
+
+			case section_kind::channel:
+			{
+				channel ch;
+				ch.name = resolve_project_path(fname, name);
+				ch.dynamic = true;
+				_channels.push_back(ch);
+				break;
+			}
+
+			default:  // unknown sections are skipped
+				break;
+		}
+	}
+
+	if (_prog.empty())
+		throw corrupted("program section missing");
+}
+
+string const & project_bundle::shader_program() const
+{
+	return _prog;
+}
+
+string_view project_bundle::source() const
+{
+	return _source;
+}
+
+map<string, string> const & project_bundle::defines() const
+{
+	return _defs;
+}
+
+vector<project_bundle::channel> const & project_bundle::channels() const
+{
+	return _channels;
+}
+
+size_t pack_project(string const & fname, string const & bundle)
+{
+	using kind = project_bundle::section_kind;
+
+	string shader = fname;
+	vector<section> sections;
+	vector<section> channels;
+
+	if (ends_with(fname, ".stoy"))
+	{
+		project_file prj;
+		if (!prj.load(fname))
+			throw std::runtime_error{"'" + fname + "' project without shader program"};
+
+		shader = resolve_project_path(fname, prj.shader_program());
+
+		string defines;
+		for (auto const & def : prj.defines())
+			defines += def.first + " " + def.second + "\n";
+
+		if (!defines.empty())
+			sections.push_back(section{kind::defines, string{}, defines});
+
+		for (string const & res : prj.program_textures())
+		{
+			if (is_channel_source(res))  // kept as file
+			{
+				channels.push_back(section{kind::channel, res, string{}});
+				continue;
+			}
+
+			gles2::image im = gles2::image_from_file(resolve_project_path(fname, res));  // flipped RGBA
+			gles2::texture::parameters params;  // channel texture defaults
+
+			texture_header th;
+			th.width = im.width;
+			th.height = im.height;
+			th.format = uint32_t(gles2::pixel_format::rgba);
+			th.type = uint32_t(gles2::pixel_type::ub8);
+			th.min = uint32_t(params.min());
+			th.mag = uint32_t(params.mag());
+			th.wrap_s = uint32_t(params.wrap_s());
+			th.wrap_t = uint32_t(params.wrap_t());
+
+			string payload;
+			payload.reserve(sizeof(th) + im.pixels.size());
+			append_value(payload, th);
+			payload.append(reinterpret_cast<char const *>(im.pixels.data()), im.pixels.size());
+
+			channels.push_back(section{kind::texture, res, std::move(payload)});
+		}
+	}
+
+	shader_source src = default_shader_preprocessor().expand(shader);
+	sections.insert(sections.begin(), section{kind::program, shader, src.code});
+	sections.insert(sections.end(), channels.begin(), channels.end());
+
+	// layout
+	vector<section_entry> table;
+	size_t offset = aligned(sizeof(file_header) + sections.size() * sizeof(section_entry));
+	for (section const & s : sections)
+	{
+		section_entry e;
+		e.kind = uint32_t(s.kind);
+		e.name_size = s.name.size();
+		e.offset = offset;
+		e.size = aligned(s.name.size()) + s.payload.size();
+		table.push_back(e);
+		offset = aligned(offset + e.size);
+	}
+
+	ofstream fout{bundle, std::ios::binary};
+	if (!fout.is_open())
+		throw std::runtime_error{"can't create '" + bundle + "' file"};
+
+	file_header header;
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.section_count = sections.size();
+	header.reserved = 0;
+	fout.write(reinterpret_cast<char const *>(&header), sizeof(header));
+	fout.write(reinterpret_cast<char const *>(table.data()), table.size() * sizeof(section_entry));
+
+	char const zeros[alignment] = {};
+	size_t pos = sizeof(header) + table.size() * sizeof(section_entry);
+	for (size_t i = 0; i < sections.size(); ++i)
+	{
+		fout.write(zeros, table[i].offset - pos);
+		fout.write(sections[i].name.data(), sections[i].name.size());
+		fout.write(zeros, aligned(sections[i].name.size()) - sections[i].name.size());
+		fout.write(sections[i].payload.data(), sections[i].payload.size());
+		pos = table[i].offset + table[i].size;
+	}
+
+	if (!fout)
+		throw std::runtime_error{"unable to write '" + bundle + "' bundle"};
+
+	return pos;
+}
+
+}  // io
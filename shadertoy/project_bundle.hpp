@@ -0,0 +1,88 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include "gles2/texture_gles2.hpp"
+#include "file_view/file_view.hpp"
+
+namespace io {
+
+/*! Packed shadertoy project (`.stoyb` bundle) loaded with a single mmap,
+textures are uploaded straight from the mapped file without decoding.
+
+Bundle starts with `STYB` magic, version and section count followed by
+the section table (kind, name size, offset and size of each section).
+Sections are 16 byte aligned, each starts with its name and its payload
+follows at the next 16 byte boundary. Values are stored in native (little
+endian) byte order.
+
+- program: shader file name, preprocessed source (includes expanded)
+- defines: `NAME VALUE` lines
+- texture: resource path, texture header (size, pixel format and type,
+  sampler settings) followed by pixels with bottom-up rows
+- channel: dynamic (audio, video) resource path, the resource is kept
+  as a file and it is searched relative to the bundle
+
+Texture and channel sections keep project channel order.
+\code
+io::project_bundle b{"explosion.stoyb"};
+for (auto const & ch : b.channels())
+	if (!ch.dynamic)
+		textures.push_back(make_shared<texture2d>(ch.texture.width, ch.texture.height,
+			ch.texture.format, ch.texture.type, ch.texture.pixels, ch.texture.params));
+shader_source src;
+src.code = string{b.source()};
+src.hash = std::hash<string>{}(src.code);
+prog.load_source(b.shader_program(), src, spec);
+\endcode \sa pack_project(), prepare_program() */
+class project_bundle
+{
+public:
+	enum class section_kind : uint32_t
+	{
+		program = 1,
+		defines = 2,
+		texture = 3,
+		channel = 4
+	};
+
+	struct texture_data
+	{
+		unsigned width = 0, height = 0;
+		gles2::pixel_format format = gles2::pixel_format::rgba;
+		gles2::pixel_type type = gles2::pixel_type::ub8;
+		gles2::texture::parameters params;
+		void const * pixels = nullptr;  //!< points into mapped bundle
+	};
+
+	struct channel
+	{
+		std::string name;  //!< resource path
+		bool dynamic = false;  //!< audio or video resource loaded from file, texture otherwise
+		texture_data texture;
+	};
+
+	project_bundle();
+	project_bundle(std::string const & fname);  //!< throws std::runtime_error for unsupported or corrupted file
+	void open(std::string const & fname);  //!< throws std::runtime_error for unsupported or corrupted file
+	std::string const & shader_program() const;
+	std::string_view source() const;  //!< preprocessed shader source, valid while bundle is open
+	std::map<std::string, std::string> const & defines() const;
+	std::vector<channel> const & channels() const;
+
+private:
+	file_view _file;
+	std::string _prog;
+	std::string_view _source;
+	std::map<std::string, std::string> _defs;
+	std::vector<channel> _channels;
+};
+
+/*! packs shader program or `.stoy` project into bundle file (preprocesses
+shader source and decodes channel images), returns bundle size in bytes,
+throws std::runtime_error on failure */
+size_t pack_project(std::string const & fname, std::string const & bundle);
+
+}  // io
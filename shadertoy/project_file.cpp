@@ -1,39 +1,53 @@
-#include <fstream>
-#include <boost/algorithm/string/predicate.hpp>
-#include <boost/algorithm/string/trim.hpp>
-#include "file_view/read_lines.hpp"
+#include <regex>
+#include <string_view>
+#include "file_view/file_view.hpp"
 #include "project_file.hpp"
 
 namespace io {
 
 using std::string;
 using std::vector;
-using std::ifstream;
-using boost::algorithm::starts_with;
-using boost::algorithm::trim;
-using boost::algorithm::trim_left_copy;
-using boost::algorithm::trim_right;
+using std::map;
+using std::string_view;
+using std::regex;
+using std::regex_match;
+using svmatch = std::match_results<string_view::const_iterator>;
+
+static string_view trim_left(string_view s);
+static string_view trim_right(string_view s);
 
 project_file::project_file()
 {}
 
 bool project_file::load(std::string const & fname)
 {
-	for (string const & line : io::read_lines(fname))
+	// #define NAME VALUE
+	static regex const define_pat{R"(#\s*define\s+(\w+)\s*(.*))"};
+
+	file_view file{fname};
+	for (string_view line : file.lines())
 	{
 		if (line.empty())
 			continue;
 
-		string resource = trim_left_copy(line);
-		if (resource.empty() || starts_with(resource, "#"))  // ignore line
+		string_view resource = trim_left(line);
+
+		svmatch what;
+		if (regex_match(resource.begin(), resource.end(), what, define_pat))
+		{
+			_defs[what[1].str()] = string{trim_right(resource.substr(what.position(2), what.length(2)))};
 			continue;
+		}
 
-		trim_right(resource);
+		if (resource.empty() || resource.front() == '#')  // ignore line
+			continue;
+
+		resource = trim_right(resource);
 
 		if (_prog.empty())
-			_prog = line;
+			_prog = string{line};
 		else
-			_texs.push_back(resource);
+			_texs.emplace_back(resource);
 	}
 
 	return !_prog.empty();
@@ -49,4 +63,21 @@ vector<string> const & project_file::program_textures() const
 	return _texs;
 }
 
+map<string, string> const & project_file::defines() const
+{
+	return _defs;
+}
+
+string_view trim_left(string_view s)
+{
+	size_t first = s.find_first_not_of(" \t\r\f\v");
+	return first == string_view::npos ? string_view{} : s.substr(first);
+}
+
+string_view trim_right(string_view s)
+{
+	size_t last = s.find_last_not_of(" \t\r\f\v");
+	return last == string_view::npos ? string_view{} : s.substr(0, last + 1);
+}
+
 }  // io
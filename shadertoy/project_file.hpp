@@ -1,10 +1,19 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <map>
 
 namespace io {
 
-//! shadertoy project file
+/*! shadertoy project file
+\code
+# shadertoy project file
+view.glsl
+lena.jpg
+#define ZOOM 2.0
+\endcode
+first resource is a shader program followed by channel textures (or `.wav` music, `.y4m` video and `img_%03d.png@FPS` image sequence channels), `#define NAME VALUE`
+lines are injected into the shader program, other lines starting with '#' are comments */
 class project_file
 {
 public:
@@ -12,10 +21,12 @@ public:
 	bool load(std::string const & fname);
 	std::string const & shader_program() const;
 	std::vector<std::string> const & program_textures() const;
+	std::map<std::string, std::string> const & defines() const;
 
 private:
 	std::string _prog;
 	std::vector<std::string> _texs;
+	std::map<std::string, std::string> _defs;
 };
 
 }  // io
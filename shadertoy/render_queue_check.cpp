@@ -0,0 +1,157 @@
+// render queue redundant bind check, a mesh property overriding a global one needs the global property bound again for the next mesh
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include "gl/shapes.hpp"
+#include "gles2/framebuffer_gles2.hpp"
+#include "gles2/model_gles2.hpp"
+#include "gles2/program_gles2.hpp"
+#include "gles2/property.hpp"
+#include "gles2/texture_gles2.hpp"
+#include "headless_context.hpp"
+
+using std::cout;
+using std::cerr;
+using std::string;
+using std::shared_ptr;
+using std::make_shared;
+using glm::vec2;
+using glm::vec3;
+
+unsigned const size = 64;
+
+char const * check_shader = R"(
+	varying vec2 uv;
+	#ifdef _VERTEX_
+	attribute vec3 position;
+	attribute vec2 texcoord;
+	void main() {
+		uv = texcoord;
+		gl_Position = vec4(position, 1.0);
+	}
+	#endif
+	#ifdef _FRAGMENT_
+	precision mediump float;
+	uniform vec3 material_ambient;
+	uniform float material_intensity;
+	uniform float material_shininess;
+	uniform sampler2D tex;
+	void main() {
+		float dummy = material_shininess * 0.0;  // keep the uniform active
+		gl_FragColor = vec4(material_ambient * material_intensity * texture2D(tex, uv).rgb + dummy, 1.0);
+	}
+	#endif
+)";
+
+static shared_ptr<gles2::texture2d> solid_texture(uint8_t value);
+static vec3 read_color(gles2::framebuffer const & fbo, unsigned x, unsigned y);
+static bool expect(string const & name, vec3 const & color, vec3 const & expected);
+
+int main()
+{
+	if (!glfwInit())
+	{
+		cerr << "error: GLFW initialization failed" << std::endl;
+		return 2;
+	}
+
+	bool ok = true;
+
+	try {
+		headless_context ctx;
+		ctx.make_current();
+
+		gles2::framebuffer fbo{size, size};
+		fbo.bind();
+		glViewport(0, 0, size, size);
+
+		gles2::shader::program prog;
+		prog.from_memory(check_shader);
+
+		shared_ptr<gles2::texture2d> white = solid_texture(255),
+			black = solid_texture(0);
+
+		auto bind_attributes = [&prog](gles2::model & m) {
+			m.attribute_location({prog.attribute_location("position"), prog.attribute_location("texcoord")});
+		};
+
+		{  // material: global green, first mesh red, second mesh needs green again
+			gles2::model m;
+			m.append_global(new gles2::material_property{vec3{0,1,0}});
+			m.append_global(new gles2::texture_property{white, "tex"});
+			m.append_mesh(make_shared<gles2::mesh>(gl::make_quad_xy<gles2::mesh>(vec2{-1,-1}, 1)),
+				{new gles2::material_property{vec3{1,0,0}}});
+			m.append_mesh(make_shared<gles2::mesh>(gl::make_quad_xy<gles2::mesh>(vec2{0,-1}, 1)));
+			bind_attributes(m);
+
+			glClear(GL_COLOR_BUFFER_BIT);
+			m.render(prog);
+
+			ok &= expect("material override, first mesh", read_color(fbo, size/4, size/4), vec3{1,0,0});
+			ok &= expect("material override, second mesh", read_color(fbo, 3*size/4, size/4), vec3{0,1,0});
+
+			gles2::render_queue::statistics const & stats = m.render_stats();
+			cout << "material override: " << stats.binds << " binds, " << stats.binds_saved << " saved\n";
+			if (stats.binds != 4 || stats.binds_saved != 1)
+			{
+				cerr << "material override: expected 4 binds and 1 saved" << std::endl;
+				ok = false;
+			}
+		}
+
+		{  // texture: global white, first mesh black (same unit and sampler), second mesh needs white again
+			gles2::model m;
+			m.append_global(new gles2::material_property{vec3{1,1,1}});
+			m.append_global(new gles2::texture_property{white, "tex"});
+			m.append_mesh(make_shared<gles2::mesh>(gl::make_quad_xy<gles2::mesh>(vec2{-1,-1}, 1)),
+				{new gles2::texture_property{black, "tex"}});
+			m.append_mesh(make_shared<gles2::mesh>(gl::make_quad_xy<gles2::mesh>(vec2{0,-1}, 1)));
+			bind_attributes(m);
+
+			glClear(GL_COLOR_BUFFER_BIT);
+			m.render(prog);
+
+			ok &= expect("texture override, first mesh", read_color(fbo, size/4, size/4), vec3{0,0,0});
+			ok &= expect("texture override, second mesh", read_color(fbo, 3*size/4, size/4), vec3{1,1,1});
+		}
+	}
+	catch (std::exception & e) {
+		cerr << "error: " << e.what() << std::endl;
+		glfwTerminate();
+		return 2;
+	}
+
+	glfwTerminate();
+
+	cout << (ok ? "passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
+
+shared_ptr<gles2::texture2d> solid_texture(uint8_t value)
+{
+	uint8_t pixels[4] = {value, value, value, 255};
+	return make_shared<gles2::texture2d>(1, 1, gles2::pixel_format::rgba, gles2::pixel_type::ub8, pixels);
+}
+
+vec3 read_color(gles2::framebuffer const & fbo, unsigned x, unsigned y)
+{
+	uint8_t pixel[4];
+	fbo.read_pixels(x, y, 1, 1, pixel);
+	return vec3{pixel[0], pixel[1], pixel[2]} / 255.0f;
+}
+
+bool expect(string const & name, vec3 const & color, vec3 const & expected)
+{
+	vec3 d = color - expected;
+	if (std::abs(d.x) < 0.05f && std::abs(d.y) < 0.05f && std::abs(d.z) < 0.05f)
+		return true;
+
+	cerr << name << ": expected (" << expected.x << ", " << expected.y << ", " << expected.z
+		<< "), got (" << color.x << ", " << color.y << ", " << color.z << ")" << std::endl;
+	return false;
+}
@@ -0,0 +1,208 @@
+#include <regex>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <boost/filesystem/operations.hpp>
+#include "file_view/read_file.hpp"
+#include "shader_params.hpp"
+
+using std::string;
+using std::vector;
+using std::map;
+using std::regex;
+using std::smatch;
+using std::regex_match;
+using std::istringstream;
+using std::ostringstream;
+using std::ifstream;
+using std::ofstream;
+using std::cerr;
+namespace fs = boost::filesystem;
+
+static string format_value(float v);
+
+vector<shader_param> promote_params(string & code, shader_source const & src)
+{
+	// const float NAME = VALUE;  // @param [MIN MAX [STEP]]
+	static regex const pat{R"(\s*const\s+float\s+(\w+)\s*=\s*([^;]+?)\s*;\s*//\s*@param\b(.*))"};
+
+	vector<shader_param> result;
+	string promoted;
+
+	istringstream in{code};
+	string line;
+	for (unsigned lineno = 1; getline(in, line); ++lineno)
+	{
+		smatch what;
+		if (regex_match(line, what, pat))
+		{
+			shader_param p;
+			p.name = what[1];
+			if (lineno <= src.lines.size())
+			{
+				p.file = src.dependencies[src.lines[lineno-1].first];
+				p.line = src.lines[lineno-1].second;
+			}
+			else
+				p.line = 0;
+
+			try {
+				p.value = p.initial = std::stof(what[2]);
+			}
+			catch (std::logic_error &) {
+				cerr << "warning: '" << p.name << "' parameter initializer is not a number, ignored" << std::endl;
+				promoted += line + "\n";
+				continue;
+			}
+
+			p.min = -INFINITY;
+			p.max = INFINITY;
+			p.step = 0.0f;
+			istringstream range{what[3]};
+			range >> p.min >> p.max >> p.step;
+
+			if (p.step <= 0.0f)
+			{
+				p.step = std::isfinite(p.max - p.min) ? (p.max - p.min) / 100.0f
+					: std::max(std::abs(p.initial) / 10.0f, 0.01f);
+			}
+
+			result.push_back(p);
+			promoted += "uniform float " + p.name + ";  // @param\n";
+		}
+		else
+			promoted += line + "\n";
+	}
+
+	if (!result.empty())
+		code = promoted;
+
+	return result;
+}
+
+bool write_params_back(vector<shader_param> const & params)
+{
+	map<string, vector<shader_param const *>> by_file;
+	for (shader_param const & p : params)
+		if (!p.file.empty())
+			by_file[p.file].push_back(&p);
+
+	for (auto const & kv : by_file)
+	{
+		string code = io::read_file(kv.first);
+
+		vector<string> lines;
+		istringstream in{code};
+		for (string line; getline(in, line);)
+			lines.push_back(line);
+
+		for (shader_param const * p : kv.second)
+		{
+			if (p->line == 0 || p->line > lines.size())
+				return false;
+
+			// keeps formatting and annotation, only initializer is replaced
+			regex const init{R"((\bconst\s+float\s+)" + p->name + R"(\s*=\s*)[^;]+)"};
+			string & line = lines[p->line - 1];
+			string replaced = std::regex_replace(line, init, "$01" + format_value(p->value), std::regex_constants::format_first_only);
+			if (replaced == line && format_value(p->value) != format_value(p->initial))
+			{
+				cerr << "error: '" << p->name << "' definition not found at " << kv.first << ":" << p->line << std::endl;
+				return false;
+			}
+
+			line = replaced;
+		}
+
+		ofstream fout{kv.first};
+		for (string const & line : lines)
+			fout << line << "\n";
+
+		if (!fout)
+			return false;
+	}
+
+	return true;
+}
+
+param_file::param_file(string const & fname)
+	: _fname{fname}
+	, _mtime{0}
+{}
+
+string const & param_file::filename() const
+{
+	return _fname;
+}
+
+bool param_file::changed() const
+{
+	boost::system::error_code ec;
+	std::time_t mtime = fs::last_write_time(_fname, ec);
+	return !ec && mtime != _mtime;
+}
+
+bool param_file::load(vector<shader_param> & params)
+{
+	ifstream fin{_fname};
+	if (!fin.is_open())
+		return false;
+
+	boost::system::error_code ec;
+	_mtime = fs::last_write_time(_fname, ec);
+
+	string line;
+	while (getline(fin, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		istringstream in{line};
+		string name;
+		float value;
+		if (!(in >> name >> value))
+			continue;
+
+		for (shader_param & p : params)
+			if (p.name == name)
+				p.value = std::min(std::max(value, p.min), p.max);
+	}
+
+	return true;
+}
+
+bool param_file::save(vector<shader_param> const & params)
+{
+	{
+		ofstream fout{_fname};
+		fout << "# " << fs::path{_fname}.stem().string() << " shader parameters (NAME VALUE)\n";
+		for (shader_param const & p : params)
+			fout << p.name << " " << format_value(p.value) << "\n";
+
+		if (!fout)
+			return false;
+	}
+
+	boost::system::error_code ec;
+	_mtime = fs::last_write_time(_fname, ec);
+	return true;
+}
+
+string param_file_for(string const & shader_fname)
+{
+	return fs::path{shader_fname}.replace_extension(".params").string();
+}
+
+string format_value(float v)
+{
+	ostringstream out;
+	out << std::setprecision(6) << v;
+	string s = out.str();
+	if (s.find_first_of(".eE") == string::npos && std::isfinite(v))  // GLSL float literal
+		s += ".0";
+	return s;
+}
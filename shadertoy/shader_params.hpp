@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ctime>
+#include "shader_preprocessor.hpp"
+
+//! shader constant promoted to an uniform variable so it can be changed without recompilation
+struct shader_param
+{
+	std::string name;
+	float value,
+		initial,  //!< value from the shader source
+		min, max, step;
+	std::string file;  //!< file and line the constant is defined on
+	unsigned line;
+};
+
+/*! Finds annotated global float constants
+
+\code
+const float explosion_velocity = 0.7;  // @param 0.0 2.0 0.05
+\endcode
+
+in code (`// @param [MIN MAX [STEP]]`) and rewrites them to `uniform float NAME;`
+declarations, line structure is kept. Promoted constants can't be used in
+constant expressions (e.g. other constant initializers). src is used to map
+code lines back to source files. */
+std::vector<shader_param> promote_params(std::string & code, shader_source const & src);
+
+//! writes current parameter values back into shader source files as constant initializers
+bool write_params_back(std::vector<shader_param> const & params);
+
+/*! Text parameter control file with `NAME VALUE` lines, other processes can
+change values by writing the file.
+\code
+# explosion.glsl parameters
+explosion_velocity 0.7
+\endcode */
+class param_file
+{
+public:
+	param_file(std::string const & fname = std::string{});
+	std::string const & filename() const;
+	bool changed() const;  //!< true if file was modified since last load() or save()
+	bool load(std::vector<shader_param> & params);  //!< sets values of known parameters
+	bool save(std::vector<shader_param> const & params);
+
+private:
+	std::string _fname;
+	std::time_t _mtime;
+};
+
+std::string param_file_for(std::string const & shader_fname);  //!< returns `shader.params` file name for `shader.glsl`
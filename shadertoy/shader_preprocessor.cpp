@@ -0,0 +1,140 @@
+#include <regex>
+#include <string_view>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <boost/filesystem/operations.hpp>
+#include "file_view/file_view.hpp"
+#include "shader_preprocessor.hpp"
+
+using std::string;
+using std::vector;
+using std::find;
+using std::regex;
+using std::regex_match;
+using std::string_view;
+using svmatch = std::match_results<string_view::const_iterator>;
+using std::to_string;
+using std::make_pair;
+using std::lock_guard;
+using std::mutex;
+namespace fs = boost::filesystem;
+
+static string normalized_path(string const & fname);
+
+string shader_source::location(unsigned line) const
+{
+	if (line == 0 || line > lines.size())
+		return string{};
+
+	auto const & loc = lines[line-1];
+	return fs::path{dependencies[loc.first]}.filename().string() + ":" + to_string(loc.second);
+}
+
+shader_source shader_preprocessor::expand(string const & fname)
+{
+	string path = normalized_path(fname);
+
+	lock_guard<mutex> lock{_lock};
+
+	auto it = _cache.find(path);
+	if (it != _cache.end() && up_to_date(it->second))
+		return it->second.source;
+
+	entry e;
+	expand_file(path, e.source, e.stamps);
+	e.source.hash = std::hash<string>{}(e.source.code);
+
+	_cache[path] = e;
+	return e.source;
+}
+
+bool shader_preprocessor::modified(string const & fname)
+{
+	lock_guard<mutex> lock{_lock};
+	auto it = _cache.find(normalized_path(fname));
+	if (it == _cache.end())
+		return false;
+
+	return !up_to_date(it->second);
+}
+
+void shader_preprocessor::clear()
+{
+	lock_guard<mutex> lock{_lock};
+	_cache.clear();
+}
+
+void shader_preprocessor::expand_file(string const & path, shader_source & result, vector<file_stamp> & stamps)
+{
+	// #include "file"
+	static regex const pat{R"(\s*#\s*include\s*\"([^\"]+)\".*)"};
+
+	io::file_view file{path};
+
+	unsigned file_idx = result.dependencies.size();
+	result.dependencies.push_back(path);
+	stamps.push_back(file_stamp{fs::last_write_time(path), std::hash<string_view>{}(file.view())});
+
+	result.code.reserve(result.code.size() + file.size() + 1);
+
+	unsigned lineno = 0;
+	for (string_view line : file.lines())
+	{
+		++lineno;
+
+		svmatch what;
+		if (regex_match(line.begin(), line.end(), what, pat))
+		{
+			fs::path inc = fs::path{path}.parent_path() / what[1].str();
+			if (!fs::exists(inc))
+				throw std::runtime_error{"can't open '" + what[1].str() + "' file included from "
+					+ fs::path{path}.filename().string() + ":" + to_string(lineno)};
+
+			string inc_path = normalized_path(inc.string());
+
+			vector<string> const & deps = result.dependencies;
+			if (find(deps.begin(), deps.end(), inc_path) == deps.end())  // include only once
+				expand_file(inc_path, result, stamps);
+
+			continue;
+		}
+
+		result.code += line;
+		result.code += '\n';
+		result.lines.push_back(make_pair(file_idx, lineno));
+	}
+}
+
+bool shader_preprocessor::up_to_date(entry & e) const
+{
+	vector<string> const & deps = e.source.dependencies;
+	for (size_t i = 0; i < deps.size(); ++i)
+	{
+		if (!fs::exists(deps[i]))
+			return false;
+
+		std::time_t mtime = fs::last_write_time(deps[i]);
+		if (mtime == e.stamps[i].mtime)
+			continue;
+
+		if (std::hash<string_view>{}(io::file_view{deps[i]}.view()) != e.stamps[i].hash)
+			return false;
+
+		e.stamps[i].mtime = mtime;  // touched, but not changed, don't rehash on the next check
+	}
+
+	return true;
+}
+
+string normalized_path(string const & fname)
+{
+	fs::path p{fname};
+	return fs::exists(p) ? fs::canonical(p).string() : fs::absolute(p).string();
+}
+
+shader_preprocessor & default_shader_preprocessor()
+{
+	static shader_preprocessor result;
+	return result;
+}
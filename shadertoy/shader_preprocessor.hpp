@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <ctime>
+#include <mutex>
+#include <utility>
+
+//! shader source with expanded includes
+struct shader_source
+{
+	std::string code;  //!< expanded source code
+	std::vector<std::string> dependencies;  //!< files the code was built from, the first one is the shader itself
+	std::vector<std::pair<unsigned, unsigned>> lines;  //!< (dependency index, line number) for each line of code
+	size_t hash = 0;  //!< hash of the expanded code
+
+	//! maps code line (counting from 1) back to the 'file:line' location, returns empty string for unknown line
+	std::string location(unsigned line) const;
+};
+
+/*! GLSL preprocessing stage handling `#include "file"` directives.
+
+Included files are searched relative to the including file and each file
+is included only once. Expanded sources are cached and the cache entry is
+valid until one of its dependencies changes (checked by modification time
+and content hash). Preprocessor can be shared between threads.
+
+\code
+shader_preprocessor pp;
+shader_source src = pp.expand("explosion.glsl");
+// ...
+if (pp.modified("explosion.glsl"))
+	src = pp.expand("explosion.glsl");
+\endcode */
+class shader_preprocessor
+{
+public:
+	shader_source expand(std::string const & fname);
+	bool modified(std::string const & fname);  //!< true if any dependency of already expanded fname shader changed, false for unknown shader
+	void clear();
+
+private:
+	struct file_stamp
+	{
+		std::time_t mtime;
+		size_t hash;
+	};
+
+	struct entry
+	{
+		shader_source source;
+		std::vector<file_stamp> stamps;  //!< stamp for each dependency
+	};
+
+	void expand_file(std::string const & path, shader_source & result, std::vector<file_stamp> & stamps);
+	bool up_to_date(entry & e) const;  //!< refreshes modification time of touched, but not changed dependencies
+
+	std::map<std::string, entry> _cache;  //!< (shader path, expanded source)
+	mutable std::mutex _lock;
+};
+
+//! preprocessor shared by all shader programs
+shader_preprocessor & default_shader_preprocessor();
@@ -1,11 +1,24 @@
 #include <iostream>
+#include <thread>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
 #include <boost/program_options.hpp>
 #include <glm/vec2.hpp>
 #include "utility.hpp"
 #include "app.hpp"
 #include "help.hpp"
+#include "batch_compile.hpp"
+#include "thumbnails.hpp"
+#include "golden.hpp"
+#include "program_preloader.hpp"
+#include "project_bundle.hpp"
+#include "gles2/gpu_memory.hpp"
+#include "gles2/texture_loader_gles2.hpp"
+#include "startup_trace.hpp"
 
 using std::cout;
+using std::cerr;
 using std::string;
 using glm::ivec2;
 namespace po = boost::program_options;
@@ -15,12 +28,50 @@ string const default_shader_program = "hello.glsl";
 
 int main(int argc, char * argv[])
 {
+	startup_trace & trace = startup_trace::instance();  // startup time is measured from there
+
+	gles2::init_image_library(argv[0]);  // before any thread (decoders, warm-up, batch workers) uses it
+	trace.phase("image library initialized");
+
 	po::options_description desc{"shadertoy options"};
 		desc.add_options()
 			("help", "produce help messages")
 			("size", po::value<string>(), "set window size")
 			("shader", po::value<string>(), "load program shader")
-			("compile", "compile program shader only");
+			("compile", "compile program shader only")
+			("pack", po::value<string>(), "pack shader program or project (preprocessed source and decoded channel images) into a .stoyb bundle file and quit")
+			("optimize", "optimize shader source before compilation (with --compile, unoptimized and optimized compile times are reported)")
+			("specialize", "bake resolution and channel sizes into the program as compile time constants")
+			("bench", po::value<unsigned>(), "render N frames with generic and specialized program and report frame times")
+			("compile-dir", po::value<string>(), "compile all shader programs and projects in a directory, JSON report is written to standard output")
+			("jobs,j", po::value<unsigned>()->default_value(std::max(1u, std::thread::hardware_concurrency())), "number of --compile-dir, --thumbnails and --golden worker threads")
+			("thumbnails", po::value<string>(), "render thumbnails and a contact sheet for all shader programs and projects in a directory (or playlist file)")
+			("thumbnail-size", po::value<string>()->default_value("160x90"), "thumbnail size")
+			("thumbnail-time", po::value<float>()->default_value(1.0f), "iTime value thumbnails are rendered for")
+			("thumbnail-dir", po::value<string>(), "thumbnails output directory (DIR/thumbnails by default)")
+			("golden", po::value<string>(), "render all shader programs and projects in a directory at fixed times and compare them with reference images, JSON report is written to standard output")
+			("golden-ref", po::value<string>(), "golden reference images directory (DIR/golden by default)")
+			("golden-times", po::value<string>()->default_value("0.5,2"), "comma separated iTime values golden images are rendered for")
+			("golden-update", "write rendered golden images as new references")
+			("output,o", po::value<string>(), "stream rendered frames as YUV4MPEG2 video into a file or named pipe ('-' for standard output)")
+			("fps", po::value<unsigned>()->default_value(30), "video output frame rate")
+			("frames", po::value<unsigned>()->default_value(0), "number of video frames to render before quit (0 for unlimited)")
+			("shm", po::value<string>(), "publish rendered frames into a POSIX shared memory ring (e.g. /shadertoy), see shm_reader")
+			("shm-slots", po::value<unsigned>()->default_value(3), "number of shared memory ring slots")
+			("http", po::value<unsigned>(), "serve MJPEG live preview on a port (http://HOST:PORT/)")
+			("http-fps", po::value<float>()->default_value(10.0f), "live preview frame rate cap")
+			("texture-budget", po::value<unsigned>()->default_value(256), "channel texture cache budget in MiB, unused textures are evicted over budget")
+			("gpu-report", po::value<string>(), "write GPU memory statistics (per category totals, peaks and not freed allocations) as JSON into a file at exit")
+			("record", po::value<string>(), "record per frame input (iTime, iFrame, iMouse and keys) into a binary trace file")
+			("replay", po::value<string>(), "replay recorded input trace offscreen and unthrottled and report frame times")
+			("startup-trace", "print startup phase log (time to the first frame, background initialization) to standard error")
+			("time-offset", po::value<double>()->default_value(0.0), "iTime offset in seconds")
+			("time-wrap", po::value<double>()->default_value(0.0), "wrap iTime to [0, PERIOD) seconds to keep it precise on long running displays (0 to disable)")
+			("sound", po::value<string>(), "render shader mainSound() into a WAV file before the program starts")
+			("sound-duration", po::value<double>()->default_value(60.0), "rendered sound duration in seconds")
+			("playlist", po::value<string>(), "show shader programs and projects from a playlist file or directory in a loop")
+			("dwell", po::value<float>()->default_value(10.0f), "time to show a playlist program in seconds")
+			("fade", po::value<float>()->default_value(1.0f), "crossfade time between playlist programs in seconds");
 
 	po::positional_options_description pos_desc;
 	pos_desc.add("shader", 1);
@@ -29,6 +80,90 @@ int main(int argc, char * argv[])
 	po::store(po::command_line_parser(argc, argv).options(desc).positional(pos_desc).run(), vm);
 	po::notify(vm);
 
+	trace.phase("options parsed");
+
+	channel_texture_cache().budget(size_t{vm["texture-budget"].as<unsigned>()} << 20);
+
+	if (vm.count("compile-dir"))  // batch mode, keep standard output machine readable
+	{
+		try {
+			return compile_directory(vm["compile-dir"].as<string>(), vm["jobs"].as<unsigned>(), cout) > 0 ? 1 : 0;
+		}
+		catch (std::exception & e) {
+			std::cerr << "error: " << e.what() << std::endl;
+			return 2;
+		}
+	}
+
+	if (vm.count("pack"))  // no window needed
+	{
+		string shader_program = vm.count("shader") ? vm["shader"].as<string>() : default_shader_program;
+		string bundle = vm["pack"].as<string>();
+		try {
+			size_t size = io::pack_project(shader_program, bundle);
+			cout << "'" << shader_program << "' packed into '" << bundle << "' (" << size << " bytes)" << std::endl;
+			return 0;
+		}
+		catch (std::exception & e) {
+			std::cerr << "error: " << e.what() << std::endl;
+			return 2;
+		}
+	}
+
+	if (vm.count("thumbnails"))
+	{
+		thumbnail_options opts;
+		opts.size = parse_size(vm["thumbnail-size"].as<string>(), opts.size);
+		opts.time = vm["thumbnail-time"].as<float>();
+		opts.jobs = vm["jobs"].as<unsigned>();
+		if (vm.count("thumbnail-dir"))
+			opts.output = vm["thumbnail-dir"].as<string>();
+
+		try {
+			return render_thumbnails(vm["thumbnails"].as<string>(), opts, cout) > 0 ? 1 : 0;
+		}
+		catch (std::exception & e) {
+			std::cerr << "error: " << e.what() << std::endl;
+			return 2;
+		}
+	}
+
+	if (vm.count("golden"))  // regression check, keep standard output machine readable
+	{
+		golden_options opts;
+		if (vm.count("size"))
+			opts.size = parse_size(vm["size"].as<string>(), opts.size);
+		if (vm.count("golden-ref"))
+			opts.reference = vm["golden-ref"].as<string>();
+		opts.update = vm.count("golden-update") ? true : false;
+		opts.jobs = vm["jobs"].as<unsigned>();
+
+		try {
+			opts.times.clear();
+			std::istringstream times{vm["golden-times"].as<string>()};
+			for (string t; getline(times, t, ',');)
+			{
+				size_t used = 0;
+				try {
+					opts.times.push_back(std::stof(t, &used));
+				}
+				catch (std::logic_error &) {}  // invalid_argument, out_of_range
+
+				if (used == 0 || used != t.size())
+					throw std::invalid_argument{"invalid --golden-times value '" + t + "'"};
+			}
+
+			return check_golden_images(vm["golden"].as<string>(), opts, cout) > 0 ? 1 : 0;
+		}
+		catch (std::exception & e) {
+			std::cerr << "error: " << e.what() << std::endl;
+			return 2;
+		}
+	}
+
+	if (vm.count("output") && vm["output"].as<string>() == "-")  // standard output is reserved for video stream
+		cout.rdbuf(std::cerr.rdbuf());
+
 	// dump help
 	cout
 		<< help_use() << "\n"
@@ -45,9 +180,51 @@ int main(int argc, char * argv[])
 	ivec2 size = parse_size(vm.count("size") ? vm["size"].as<string>() : "400x300", ivec2{400, 300});
 	bool compile_only = vm.count("compile") ? true : false;
 
-	shadertoy_app app{size, shader_program};
-	if (!compile_only)
-		app.start();
+	shadertoy_options opts;
+	opts.optimize = vm.count("optimize") ? true : false;
+	opts.compile_report = compile_only;
+	opts.specialize = vm.count("specialize") ? true : false;
+	opts.playlist = vm.count("playlist") ? vm["playlist"].as<string>() : string{};
+	opts.dwell = vm["dwell"].as<float>();
+	opts.fade = vm["fade"].as<float>();
+	opts.output = vm.count("output") ? vm["output"].as<string>() : string{};
+	opts.fps = std::max(1u, vm["fps"].as<unsigned>());
+	opts.frames = vm["frames"].as<unsigned>();
+	opts.shm = vm.count("shm") ? vm["shm"].as<string>() : string{};
+	opts.shm_slots = vm["shm-slots"].as<unsigned>();
+	opts.http_port = vm.count("http") ? vm["http"].as<unsigned>() : 0;
+	opts.http_fps = std::max(0.1f, vm["http-fps"].as<float>());
+	opts.record = vm.count("record") ? vm["record"].as<string>() : string{};
+	opts.replay = vm.count("replay") ? vm["replay"].as<string>() : string{};
+	opts.startup_trace = vm.count("startup-trace") ? true : false;
+	opts.time_offset = vm["time-offset"].as<double>();
+	opts.time_wrap = std::max(0.0, vm["time-wrap"].as<double>());
+
+	{
+		shadertoy_app app{size, shader_program, opts};
+
+		if (vm.count("sound"))
+			app.render_sound(vm["sound"].as<string>(), vm["sound-duration"].as<double>());
+
+		if (vm.count("replay"))
+			app.replay();
+		else if (vm.count("bench"))
+			app.bench(vm["bench"].as<unsigned>());
+		else if (!compile_only)
+			app.start();
+	}  // all GPU objects are expected to be freed there
+
+	if (opts.startup_trace && !trace.finished())  // UI overlay not created (compile only, load failure)
+		trace.write(cerr);
+
+	gles2::gpu_memory & gpu_mem = gles2::gpu_memory::instance();
+	if (vm.count("gpu-report"))
+	{
+		std::ofstream fout{vm["gpu-report"].as<string>()};
+		gpu_mem.write_json(fout);
+	}
+
+	gpu_mem.report_leaks(cerr);
 
 	return 0;
 }
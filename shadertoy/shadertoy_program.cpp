@@ -2,15 +2,21 @@
 #include <sstream>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string/join.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
+#include "glsl_optimizer.hpp"
 #include "shadertoy_program.hpp"
 
 using std::string;
 using std::to_string;
 using std::shared_ptr;
+using std::make_shared;
+using std::cout;
 using std::cerr;
 using std::vector;
 using std::istringstream;
@@ -24,19 +30,165 @@ using glm::vec3;
 using glm::vec4;
 using gles2::texture_property;
 
-static void correct_log_line_numbers(string & log, int line_offset);
+static shadertoy_program::compile_stats compile_program(gles2::shader::program & p, string const & source);
 
 shadertoy_program::shadertoy_program()
+	: _optimize{false}
+	, _optimize_report{false}
 {}
 
 shadertoy_program::shadertoy_program(string const & fname)
+	: shadertoy_program{}
 {
 	load(fname);
 }
 
 bool shadertoy_program::load(string const & fname)
 {
-	string prolog = R"(
+	return load(fname, _spec);
+}
+
+bool shadertoy_program::load(string const & fname, specialization const & spec)
+{
+	shader_source mainImage;
+	try {
+		mainImage = default_shader_preprocessor().expand(fname);
+	}
+	catch (std::runtime_error & e) {
+		_error_log = e.what();
+		cerr << "error: " << e.what() << std::endl;
+		return false;
+	}
+
+	return load_source(fname, mainImage, spec);
+}
+
+bool shadertoy_program::load_source(string const & name, shader_source const & source, specialization const & spec)
+{
+	if (source.hash != _source.hash || _fname != name)  // variants are out of date
+	{
+		_variants.clear();
+		_prog.reset();
+	}
+
+	string code = source.code;
+	vector<shader_param> params = promote_params(code, source);
+	for (shader_param & p : params)  // keep tweaked values
+	{
+		for (shader_param const & old : _params)
+			if (old.name == p.name && old.initial == p.initial)
+				p.value = old.value;
+	}
+
+	_fname = name;
+	_source = source;
+	_code = code;
+	_params = params;
+
+	return specialize(spec);
+}
+
+bool shadertoy_program::specialize(specialization const & spec)
+{
+	_spec = spec;
+
+	auto it = _variants.find(variant_key(spec));
+	if (it != _variants.end())
+	{
+		_prog = it->second;
+		return true;
+	}
+
+	if (_fname.empty())  // nothing loaded yet
+		return false;
+
+	return compile_variant(spec);
+}
+
+shadertoy_program::specialization const & shadertoy_program::current_specialization() const
+{
+	return _spec;
+}
+
+bool shadertoy_program::compile_variant(specialization const & spec)
+{
+	string prolog = this->prolog(spec);
+	string source = prolog + _code + epilog(spec);
+
+	_error_log.clear();
+
+	try {
+		compile_stats unoptimized;
+		glsl_optimizer_stats opt_stats;
+
+		if (_optimize)
+		{
+			if (_optimize_report)
+			{
+				gles2::shader::program p;
+				unoptimized = compile_program(p, source);
+			}
+
+			source = optimize_glsl(source, &opt_stats);  // line structure is kept
+		}
+
+		shared_ptr<gles2::shader::program> prog = make_shared<gles2::shader::program>();
+		_stats = compile_program(*prog, source);
+		_variants[variant_key(spec)] = prog;
+		_prog = prog;
+
+		if (_optimize && _optimize_report)
+		{
+			cout << "optimizer: " << opt_stats.source_size << " -> " << opt_stats.optimized_size << " bytes, "
+				<< opt_stats.removed_functions << " function(s) and " << opt_stats.removed_globals << " global(s) removed, "
+				<< opt_stats.folded_constants << " constant(s) folded\n"
+				<< "compile/link time: " << unoptimized.compile_time << "/" << unoptimized.link_time << " ms -> "
+				<< _stats.compile_time << "/" << _stats.link_time << " ms" << std::endl;
+		}
+	}
+	catch (gles2::shader::exception & e) {
+		// #version and #define _FRAGMENT_ lines are prepended by shader::module
+		int line_offset = 2 + std::count(prolog.begin(), prolog.end(), '\n');
+		correct_log_line_numbers(e.error_log, line_offset, _source);
+		_error_log = e.error_log;
+
+		cerr << "error: " << e.what() << ", what:\n"
+			<< e.error_log << std::endl;
+
+		_prog.reset();
+		return false;
+	}
+
+	return true;
+}
+
+string shadertoy_program::variant_key(specialization const & spec) const
+{
+	string result;
+
+	if (spec.resolution != vec2{0, 0})
+		result += "r" + to_string(spec.resolution.x) + "x" + to_string(spec.resolution.y) + ";";
+
+	if (spec.channel_resolution)
+	{
+		result += "c";
+		for (texture_property const & prop : _textures)
+			result += to_string(prop._tex->width()) + "x" + to_string(prop._tex->height()) + ",";
+		result += ";";
+	}
+
+	if (spec.origin != vec2{0, 0})
+		result += "o" + to_string(spec.origin.x) + "x" + to_string(spec.origin.y) + ";";
+
+	for (auto const & def : spec.defines)
+		result += def.first + "=" + def.second + ";";
+
+	return result;
+}
+
+string shadertoy_program::prolog(specialization const & spec) const
+{
+	string result = R"(
 		#ifdef _VERTEX_
 		attribute vec3 position;
 		void main() {
@@ -45,8 +197,27 @@ bool shadertoy_program::load(string const & fname)
 		#endif  // _VERTEX_
 		#ifdef _FRAGMENT_
 		precision mediump float;
+	)";
+
+	for (auto const & def : spec.defines)
+		result += "#define " + def.first + " " + def.second + "\n";
+
+	if (spec.resolution != vec2{0, 0})
+	{
+		vec2 const & r = spec.resolution;
+		result += "const vec3 iResolution = vec3(" + to_string(r.x) + ", " + to_string(r.y) + ", "
+			+ to_string(r.x/r.y) + ");\n";
+	}
+	else
+		result += "uniform vec3 iResolution;\n";
+
+	if (spec.channel_resolution)
+		result += "vec3 iChannelResolution[4];  // initialized in main()\n";
+	else
+		result += "uniform vec3 iChannelResolution[4];\n";
+
+	result += R"(
 		uniform float iTime;
-		uniform vec3 iResolution;
 		uniform int iFrame;
 		uniform vec4 iMouse;
 		uniform sampler2D iChannel0;
@@ -55,29 +226,94 @@ bool shadertoy_program::load(string const & fname)
 		uniform sampler2D iChannel3;
 	)";
 
-	string mainImage = gles2::shader::read_file(fname);
+	return result;
+}
 
-	string epilog = R"(
+string shadertoy_program::epilog(specialization const & spec) const
+{
+	string result = R"(
 		void main() {
-			mainImage(gl_FragColor, gl_FragCoord.xy);
+	)";
+
+	if (spec.channel_resolution)
+	{
+		for (size_t i = 0; i < 4; ++i)
+		{
+			vec3 res = i < _textures.size() ?
+				vec3{_textures[i]._tex->width(), _textures[i]._tex->height(), 1} : vec3{0, 0, 0};
+
+			result += "iChannelResolution[" + to_string(i) + "] = vec3(" + to_string(res.x) + ", "
+				+ to_string(res.y) + ", " + to_string(res.z) + ");\n";
+		}
+	}
+
+	static regex const main_image{R"(\bvoid\s+mainImage\s*\()"};
+	if (!std::regex_search(_source.code, main_image))  // sound only shader
+		result += "gl_FragColor = vec4(0.0, 0.0, 0.0, 1.0);\n";
+	else if (spec.origin != vec2{0, 0})
+	{
+		result += "mainImage(gl_FragColor, gl_FragCoord.xy - vec2(" + to_string(spec.origin.x) + ", "
+			+ to_string(spec.origin.y) + "));\n";
+	}
+	else
+		result += "mainImage(gl_FragColor, gl_FragCoord.xy);\n";
+
+	result += R"(
 		}
 		#endif
 	)";
 
-	try {
-		_prog.free();
-		_prog.from_memory(prolog + mainImage + epilog, 100);
-	}
-	catch (gles2::shader::exception & e) {
-		correct_log_line_numbers(e.error_log, -7);
+	return result;
+}
 
-		cerr << "error: " << e.what() << ", what:\n"
-			<< e.error_log << std::endl;
+bool shadertoy_program::has_sound() const
+{
+	static regex const pat{R"(\bvec2\s+mainSound\s*\()"};
+	return std::regex_search(_source.code, pat);
+}
 
-		return false;
-	}
+shader_source const & shadertoy_program::source() const
+{
+	return _source;
+}
 
-	return true;
+vector<shader_param> & shadertoy_program::params()
+{
+	return _params;
+}
+
+vector<shader_param> const & shadertoy_program::params() const
+{
+	return _params;
+}
+
+bool shadertoy_program::outdated() const
+{
+	return !_fname.empty() && default_shader_preprocessor().modified(_fname);
+}
+
+string const & shadertoy_program::filename() const
+{
+	return _fname;
+}
+
+shadertoy_program::compile_stats const & shadertoy_program::stats() const
+{
+	return _stats;
+}
+
+string const & shadertoy_program::error_log() const
+{
+	return _error_log;
+}
+
+void shadertoy_program::optimize(bool enable, bool report)
+{
+	if (_optimize != enable)
+		_variants.clear();  // force recompilation
+
+	_optimize = enable;
+	_optimize_report = report;
 }
 
 bool shadertoy_program::attach(shared_ptr<gles2::texture2d> tex)
@@ -89,26 +325,42 @@ bool shadertoy_program::attach(shared_ptr<gles2::texture2d> tex)
 
 void shadertoy_program::use()
 {
-	_prog.use();
+	if (!_prog)
+		return;
+
+	_prog->use();
 
-	_time = float_uniform{_prog.uniform_variable("iTime")};
-	_resolution = vec3_uniform{_prog.uniform_variable("iResolution")};
-	_frame = int_uniform{_prog.uniform_variable("iFrame")};
-	_mouse = vec4_uniform{_prog.uniform_variable("iMouse")};
+	_time = float_uniform{_prog->uniform_variable("iTime")};
+	_resolution = vec3_uniform{_prog->uniform_variable("iResolution")};
+	_frame = int_uniform{_prog->uniform_variable("iFrame")};
+	_mouse = vec4_uniform{_prog->uniform_variable("iMouse")};
+	_channel_resolution = uniform_variable<vector<vec3>>{_prog->uniform_variable("iChannelResolution")};
 
 	// iChannelN
+	vector<vec3> channel_resolution(4, vec3{0, 0, 0});
 	for (auto & prop : _textures)
 	{
-		if (_prog.uniform_variable(prop._uname))
-			prop.bind(_prog);
+		if (_prog->uniform_variable(prop._uname))
+			prop.bind(*_prog);
 		else
 			std::cerr << "warning: uniform variable '" << prop._uname << "' not used" << std::endl;
+
+		if (prop._bind_unit < channel_resolution.size())
+			channel_resolution[prop._bind_unit] = vec3{prop._tex->width(), prop._tex->height(), 1};
 	}
+
+	_channel_resolution = channel_resolution;
+
+	for (shader_param const & p : _params)
+		float_uniform{_prog->uniform_variable(p.name)} = p.value;
 }
 
 void shadertoy_program::update(float t, glm::vec2 const & resolution, int frame, glm::vec4 const & mouse)
 {
-	assert(_prog.used());
+	if (!_prog)
+		return;
+
+	assert(_prog->used());
 
 	_time = t;
 	_resolution = vec3{resolution, resolution.x/resolution.y};
@@ -121,12 +373,34 @@ void shadertoy_program::free_textures()
 	_textures.clear();
 }
 
-void correct_log_line_numbers(string & log, int line_offset)
+shadertoy_program::compile_stats compile_program(gles2::shader::program & p, string const & source)
+{
+	using clock = std::chrono::steady_clock;
+	using ms = std::chrono::duration<double, std::milli>;
+
+	shadertoy_program::compile_stats result;
+	result.source_size = source.size();
+
+	clock::time_point t0 = clock::now();
+	shared_ptr<gles2::shader::module> m = make_shared<gles2::shader::module>();
+	m->from_memory(source, 100);
+
+	clock::time_point t1 = clock::now();
+	p.attach(m);
+
+	clock::time_point t2 = clock::now();
+	result.compile_time = ms{t1 - t0}.count();
+	result.link_time = ms{t2 - t1}.count();
+
+	return result;
+}
+
+void correct_log_line_numbers(string & log, int line_offset, shader_source const & src)
 {
 	vector<string> errors;
 
-	// (prefix)(line)(error)
-	static regex pat{R"((\d:\d+)\((\d+)\)(:.+))"};
+	// (source):(line)(column)(error)
+	static regex pat{R"((\d+):(\d+)(\(\d+\))(:.+))"};
 
 	istringstream in{log};
 	string line;
@@ -135,8 +409,11 @@ void correct_log_line_numbers(string & log, int line_offset)
 		smatch what;
 		if (regex_match(line, what, pat))
 		{
-			int lineno = lexical_cast<int>(what[2]);
-			errors.push_back(string{what[1]} + "(" + to_string(lineno + line_offset) + ")" + string{what[3]});
+			int lineno = lexical_cast<int>(what[2]) - line_offset;
+			string loc = lineno > 0 ? src.location(lineno) : string{};
+			if (loc.empty())
+				loc = string{what[1]} + ":" + string{what[2]};
+			errors.push_back(loc + string{what[3]} + string{what[4]});
 		}
 	}
 
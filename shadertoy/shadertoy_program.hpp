@@ -1,20 +1,72 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <map>
 #include <glm/vec2.hpp>
 #include "gles2/program_gles2.hpp"
 #include "gles2/texture_gles2.hpp"
 #include "gles2/property.hpp"
 #include "uniform_variable.hpp"
+#include "shader_preprocessor.hpp"
+#include "shader_params.hpp"
+
+/*! Rewrites 'source:line(column): error' log lines to 'file:line(column): error'
+with respect to included files. Locations out of the shader code (prolog,
+epilog) are kept. */
+void correct_log_line_numbers(std::string & log, int line_offset, shader_source const & src);
 
 class shadertoy_program
 {
 public:
+	struct compile_stats
+	{
+		size_t source_size = 0;  //!< in bytes
+		double compile_time = 0.0,  //!< in ms
+			link_time = 0.0;
+	};
+
+	/*! program inputs baked into a program variant as compile time constants
+	(injected through the prolog), so compiler can fold them */
+	struct specialization
+	{
+		glm::vec2 resolution = glm::vec2{0, 0};  //!< bakes iResolution if not zero
+		bool channel_resolution = false;  //!< bakes iChannelResolution of attached textures
+		glm::vec2 origin = glm::vec2{0, 0};  //!< fragCoord origin in window coordinates (for rendering into sub-viewport)
+		std::map<std::string, std::string> defines;  //!< user defines as (NAME, VALUE) pairs
+	};
+
 	shadertoy_program();
 	shadertoy_program(std::string const & fname);
 	bool load(std::string const & fname);
+	bool load(std::string const & fname, specialization const & spec);
+
+	/*! loads already preprocessed source (e.g. from a project bundle), name
+	is used as program file name \sa io::project_bundle */
+	bool load_source(std::string const & name, shader_source const & source, specialization const & spec);
+
+	/*! switches to the spec program variant, variant is compiled on first use
+	and cached (until next load) so switching between variants is free */
+	bool specialize(specialization const & spec);
+	specialization const & current_specialization() const;
+
 	bool attach(std::shared_ptr<gles2::texture2d> tex);
 	void use();
+	bool outdated() const;  //!< true if shader or any of its includes changed since load
+	std::string const & filename() const;
+	compile_stats const & stats() const;  //!< last compilation statistics
+	std::string const & error_log() const;  //!< last compilation error log (with corrected line numbers)
+	bool has_sound() const;  //!< true if shader defines `vec2 mainSound(...)` \sa sound_renderer
+	shader_source const & source() const;  //!< expanded shader source
+
+	/*! parameters promoted from annotated constants (see promote_params()),
+	changed values are uploaded in use() without recompilation, values are
+	kept across reloads unless the constant changes in the source */
+	std::vector<shader_param> & params();
+	std::vector<shader_param> const & params() const;
+
+	/*! enables source level optimizer pass (see optimize_glsl()), with report
+	enabled unoptimized source is compiled as well to compare compile and link times */
+	void optimize(bool enable, bool report = false);
 
 	void update(
 		float t,
@@ -26,10 +78,25 @@ public:
 	void free_textures();
 
 private:
-	gles2::shader::program _prog;
+	bool compile_variant(specialization const & spec);
+	std::string variant_key(specialization const & spec) const;
+	std::string prolog(specialization const & spec) const;
+	std::string epilog(specialization const & spec) const;
+
+	std::shared_ptr<gles2::shader::program> _prog;  //!< current program variant
+	std::map<std::string, std::shared_ptr<gles2::shader::program>> _variants;
+	specialization _spec;
+	std::string _fname;
+	shader_source _source;  //!< expanded shader source
+	std::string _code;  //!< expanded source with parameters promoted to uniforms
+	std::vector<shader_param> _params;
+	compile_stats _stats;
+	std::string _error_log;
+	bool _optimize, _optimize_report;
 	float_uniform _time;
 	vec3_uniform _resolution;
 	int_uniform _frame;
 	vec4_uniform _mouse;
+	uniform_variable<std::vector<glm::vec3>> _channel_resolution;
 	std::vector<gles2::texture_property> _textures;
 };
@@ -0,0 +1,226 @@
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <ctime>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "shm_frame_ring.hpp"
+
+namespace shm {
+
+using std::string;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::memory_order_relaxed;
+
+static size_t round_up(size_t n, size_t alignment);
+static long futex(std::atomic<uint32_t> const * addr, int op, uint32_t val, timespec const * timeout);
+static std::runtime_error system_error(string const & what);
+
+uint64_t monotonic_time()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return uint64_t(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+frame_writer::frame_writer(string const & name, unsigned slots, size_t slot_size)
+	: _name{name}
+	, _mem{nullptr}
+	, _next{1}
+{
+	if (slots < 2 || slots > max_slots)
+		throw std::invalid_argument{"slot count out of <2, " + std::to_string(max_slots) + "> range"};
+
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t slot_stride = round_up(slot_size, page);
+	size_t data_offset = round_up(sizeof(ring_header) + slots * sizeof(slot_header), page);
+	_mem_size = data_offset + slots * slot_stride;
+
+	shm_unlink(_name.c_str());  // remove stale object from crashed run
+	int fd = shm_open(_name.c_str(), O_CREAT|O_EXCL|O_RDWR, 0644);
+	if (fd < 0)
+		throw system_error("unable to create '" + _name + "' shared memory");
+
+	if (ftruncate(fd, _mem_size) < 0)
+	{
+		close(fd);
+		shm_unlink(_name.c_str());
+		throw system_error("unable to resize '" + _name + "' shared memory");
+	}
+
+	_mem = mmap(nullptr, _mem_size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (_mem == MAP_FAILED)
+	{
+		shm_unlink(_name.c_str());
+		throw system_error("unable to map '" + _name + "' shared memory");
+	}
+
+	_header = new (_mem) ring_header;
+	_slots = new (static_cast<uint8_t *>(_mem) + sizeof(ring_header)) slot_header[slots];
+
+	_header->version = ring_version;
+	_header->slot_count = slots;
+	_header->page_size = page;
+	_header->slot_size = slot_size;
+	_header->slot_stride = slot_stride;
+	_header->data_offset = data_offset;
+	_header->sequence.store(0, memory_order_relaxed);
+	_header->futex.store(0, memory_order_relaxed);
+
+	for (unsigned i = 0; i < slots; ++i)
+		_slots[i].sequence.store(0, memory_order_relaxed);
+
+	std::atomic_thread_fence(memory_order_release);
+	_header->magic = ring_magic;  // readers can attach
+}
+
+frame_writer::~frame_writer()
+{
+	munmap(_mem, _mem_size);
+	shm_unlink(_name.c_str());
+}
+
+size_t frame_writer::slot_size() const
+{
+	return _header->slot_size;
+}
+
+uint8_t * frame_writer::acquire()
+{
+	unsigned slot = _next % _header->slot_count;
+	_slots[slot].sequence.store(0, memory_order_release);  // invalidates frame being overwritten
+	std::atomic_thread_fence(memory_order_release);
+	return static_cast<uint8_t *>(_mem) + _header->data_offset + slot * _header->slot_stride;
+}
+
+void frame_writer::publish(unsigned width, unsigned height, pixel_format format, size_t size)
+{
+	unsigned slot = _next % _header->slot_count;
+	slot_header & s = _slots[slot];
+	s.timestamp = monotonic_time();
+	s.width = width;
+	s.height = height;
+	s.format = static_cast<uint32_t>(format);
+	s.size = size;
+	s.sequence.store(_next, memory_order_release);
+
+	_header->sequence.store(_next, memory_order_release);
+	_header->futex.fetch_add(1, memory_order_release);
+	futex(&_header->futex, FUTEX_WAKE, INT_MAX, nullptr);
+
+	++_next;
+}
+
+frame_reader::frame_reader(string const & name)
+	: _mem{nullptr}
+{
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		throw system_error("unable to open '" + name + "' shared memory");
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(ring_header))
+	{
+		close(fd);
+		throw std::runtime_error{"'" + name + "' is not a frame ring"};
+	}
+
+	_mem_size = st.st_size;
+	_mem = mmap(nullptr, _mem_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (_mem == MAP_FAILED)
+		throw system_error("unable to map '" + name + "' shared memory");
+
+	_header = static_cast<ring_header const *>(_mem);
+	_slots = reinterpret_cast<slot_header const *>(static_cast<uint8_t const *>(_mem) + sizeof(ring_header));
+
+	if (_header->magic != ring_magic || _header->version != ring_version
+		|| _header->data_offset + _header->slot_count * _header->slot_stride > _mem_size)
+	{
+		munmap(_mem, _mem_size);
+		throw std::runtime_error{"'" + name + "' is not a compatible frame ring"};
+	}
+}
+
+frame_reader::~frame_reader()
+{
+	munmap(_mem, _mem_size);
+}
+
+bool frame_reader::wait(uint64_t last, frame & result, int timeout_ms)
+{
+	uint64_t deadline = monotonic_time() + uint64_t(timeout_ms) * 1000000ull;
+
+	while (true)
+	{
+		uint32_t f = _header->futex.load(memory_order_acquire);
+		uint64_t seq = _header->sequence.load(memory_order_acquire);
+		if (seq > last && read_slot(seq, result))
+			return true;
+
+		uint64_t now = monotonic_time();
+		if (now >= deadline)
+			return false;
+
+		timespec timeout;
+		timeout.tv_sec = (deadline - now) / 1000000000ull;
+		timeout.tv_nsec = (deadline - now) % 1000000000ull;
+		futex(&_header->futex, FUTEX_WAIT, f, &timeout);  // returns immediately if a frame was published meanwhile
+	}
+}
+
+bool frame_reader::valid(frame const & f) const
+{
+	std::atomic_thread_fence(memory_order_acquire);
+	return _slots[f.slot].sequence.load(memory_order_acquire) == f.sequence;
+}
+
+unsigned frame_reader::slot_count() const
+{
+	return _header->slot_count;
+}
+
+bool frame_reader::read_slot(uint64_t sequence, frame & result) const
+{
+	unsigned slot = sequence % _header->slot_count;
+	slot_header const & s = _slots[slot];
+	if (s.sequence.load(memory_order_acquire) != sequence)
+		return false;  // already overwritten
+
+	result.sequence = sequence;
+	result.timestamp = s.timestamp;
+	result.width = s.width;
+	result.height = s.height;
+	result.format = static_cast<pixel_format>(s.format);
+	result.size = s.size;
+	result.slot = slot;
+	result.pixels = static_cast<uint8_t const *>(_mem) + _header->data_offset + slot * _header->slot_stride;
+
+	return valid(result);  // header was not overwritten while read
+}
+
+size_t round_up(size_t n, size_t alignment)
+{
+	return (n + alignment - 1) / alignment * alignment;
+}
+
+long futex(std::atomic<uint32_t> const * addr, int op, uint32_t val, timespec const * timeout)
+{
+	// shared (not FUTEX_PRIVATE_FLAG) futex, object is mapped in more processes
+	return syscall(SYS_futex, reinterpret_cast<uint32_t const *>(addr), op, val, timeout, nullptr, 0);
+}
+
+std::runtime_error system_error(string const & what)
+{
+	return std::runtime_error{what + ", what: " + strerror(errno)};
+}
+
+}  // shm
@@ -0,0 +1,125 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/*! POSIX shared memory frame ring.
+
+Memory layout (`shm_open(name)` object):
+- page 0: ring_header followed by slot_count slot_header structures,
+- slot i data at `data_offset + i*slot_stride` (page aligned).
+
+Writer fills slots round-robin, each published frame gets a new sequence
+number (starting from 1), readers are woken by a futex on
+ring_header::futex. Readers use frame data in place (zero copy) and check
+with shm_frame_reader::valid() that the slot was not overwritten in the
+meantime (writer needs slot_count-1 frames to reuse the slot). */
+namespace shm {
+
+uint32_t const ring_magic = 0x52465453;  // 'STFR'
+uint32_t const ring_version = 1;
+uint32_t const max_slots = 32;
+
+enum class pixel_format : uint32_t
+{
+	rgba8 = 1  //!< 8-bit RGBA with bottom-up rows (glReadPixels() layout)
+};
+
+struct alignas(64) ring_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slot_count;
+	uint32_t page_size;
+	uint64_t slot_size;  //!< maximum frame size in bytes
+	uint64_t slot_stride;
+	uint64_t data_offset;
+	std::atomic<uint64_t> sequence;  //!< last published frame, 0 if none
+	std::atomic<uint32_t> futex;  //!< incremented on each publish
+};
+
+struct alignas(64) slot_header
+{
+	std::atomic<uint64_t> sequence;  //!< frame sequence number, 0 while written
+	uint64_t timestamp;  //!< CLOCK_MONOTONIC time in ns
+	uint32_t width, height;
+	uint32_t format;  //!< \sa pixel_format
+	uint32_t size;  //!< frame size in bytes
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "lock free 64-bit atomics required in shared memory");
+
+//! published frame view
+struct frame
+{
+	uint64_t sequence = 0,
+		timestamp = 0;
+	uint32_t width = 0,
+		height = 0;
+	pixel_format format = pixel_format::rgba8;
+	uint8_t const * pixels = nullptr;
+	size_t size = 0;
+	unsigned slot = 0;
+};
+
+uint64_t monotonic_time();  //!< in ns
+
+/*! \code
+shm::frame_writer ring{"/shadertoy", 3, w*h*4};
+glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, ring.acquire());
+ring.publish(w, h, shm::pixel_format::rgba8);
+\endcode */
+class frame_writer
+{
+public:
+	frame_writer(std::string const & name, unsigned slots, size_t slot_size);  //!< creates (or replaces) shared memory object
+	~frame_writer();  //!< unlinks shared memory object
+	size_t slot_size() const;
+	uint8_t * acquire();  //!< returns next slot data to write frame into
+	void publish(unsigned width, unsigned height, pixel_format format, size_t size);
+
+	frame_writer(frame_writer const &) = delete;
+	void operator=(frame_writer const &) = delete;
+
+private:
+	std::string _name;
+	void * _mem;
+	size_t _mem_size;
+	ring_header * _header;
+	slot_header * _slots;
+	uint64_t _next;  //!< next frame sequence number
+};
+
+/*! \code
+shm::frame_reader ring{"/shadertoy"};
+shm::frame f;
+while (ring.wait(f.sequence, f))
+{
+	process(f.pixels, f.size);
+	if (!ring.valid(f))
+		;  // overwritten while processed, result is torn
+}
+\endcode */
+class frame_reader
+{
+public:
+	frame_reader(std::string const & name);
+	~frame_reader();
+	bool wait(uint64_t last, frame & result, int timeout_ms = 1000);  //!< waits for a frame newer than last (latest is returned), false on timeout
+	bool valid(frame const & f) const;  //!< true if f was not overwritten yet
+	unsigned slot_count() const;
+
+	frame_reader(frame_reader const &) = delete;
+	void operator=(frame_reader const &) = delete;
+
+private:
+	bool read_slot(uint64_t sequence, frame & result) const;
+
+	void * _mem;
+	size_t _mem_size;
+	ring_header const * _header;
+	slot_header const * _slots;
+};
+
+}  // shm
@@ -0,0 +1,155 @@
+// shared memory frame ring sample reader and throughput benchmark
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <numeric>
+#include <cstring>
+#include <boost/program_options.hpp>
+#include "shm_frame_ring.hpp"
+
+using std::cout;
+using std::cerr;
+using std::string;
+using std::thread;
+using std::atomic;
+namespace po = boost::program_options;
+
+struct read_stats
+{
+	uint64_t frames = 0,
+		dropped = 0,  //!< frames published but not seen by reader
+		torn = 0,  //!< frames overwritten while processed
+		bytes = 0;
+	double latency = 0.0;  //!< publish to read latency sum in ms
+};
+
+static volatile uint64_t __checksum;  // keeps frame reads from being optimized out
+
+static void read_frames(shm::frame_reader & ring, double duration, unsigned max_frames);
+static void synthetic_writer(string const & name, unsigned slots, unsigned w, unsigned h, atomic<bool> & quit);
+static void print_stats(read_stats const & s, double dt);
+
+int main(int argc, char * argv[])
+{
+	po::options_description desc{"shm_reader options"};
+	desc.add_options()
+		("help", "produce help messages")
+		("name", po::value<string>()->default_value("/shadertoy"), "shared memory frame ring name")
+		("frames", po::value<unsigned>()->default_value(0), "quit after N frames (0 for unlimited)")
+		("duration", po::value<double>()->default_value(0.0), "quit after N seconds (0 for unlimited)")
+		("bench", "run throughput benchmark against synthetic in-process writer")
+		("size", po::value<string>()->default_value("1920x1080"), "benchmark frame size")
+		("slots", po::value<unsigned>()->default_value(3), "benchmark ring slots");
+
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	po::notify(vm);
+
+	if (vm.count("help"))
+	{
+		cout << desc << std::endl;
+		return 1;
+	}
+
+	string name = vm["name"].as<string>();
+	double duration = vm["duration"].as<double>();
+
+	try {
+		if (vm.count("bench"))
+		{
+			unsigned w = 1920, h = 1080;
+			sscanf(vm["size"].as<string>().c_str(), "%ux%u", &w, &h);
+
+			name += "_bench";
+			atomic<bool> quit{false};
+			thread writer{synthetic_writer, name, vm["slots"].as<unsigned>(), w, h, std::ref(quit)};
+
+			std::this_thread::sleep_for(std::chrono::milliseconds{100});  // wait for writer to create ring
+			{
+				shm::frame_reader ring{name};
+				read_frames(ring, duration > 0 ? duration : 5.0, vm["frames"].as<unsigned>());
+			}
+
+			quit = true;
+			writer.join();
+		}
+		else
+		{
+			shm::frame_reader ring{name};
+			read_frames(ring, duration, vm["frames"].as<unsigned>());
+		}
+	}
+	catch (std::exception & e) {
+		cerr << "error: " << e.what() << std::endl;
+		return 2;
+	}
+
+	return 0;
+}
+
+void read_frames(shm::frame_reader & ring, double duration, unsigned max_frames)
+{
+	read_stats total, second;
+	uint64_t t0 = shm::monotonic_time(),
+		t_report = t0;
+
+	shm::frame f;
+	while (true)
+	{
+		uint64_t now = shm::monotonic_time();
+		if ((duration > 0 && (now - t0) * 1e-9 >= duration) || (max_frames > 0 && total.frames >= max_frames))
+			break;
+
+		uint64_t last = f.sequence;
+		if (!ring.wait(last, f, 1000))
+		{
+			cerr << "waiting for frames ..." << std::endl;
+			continue;
+		}
+
+		// consume in place, touch every byte
+		__checksum = std::accumulate(f.pixels, f.pixels + f.size, uint64_t{0});
+
+		for (read_stats * s : {&total, &second})
+		{
+			if (!ring.valid(f))
+				++s->torn;
+			if (last > 0)
+				s->dropped += f.sequence - last - 1;
+			++s->frames;
+			s->bytes += f.size;
+			s->latency += (shm::monotonic_time() - f.timestamp) * 1e-6;
+		}
+
+		now = shm::monotonic_time();
+		if (now - t_report >= 1000000000ull)
+		{
+			cout << f.width << "x" << f.height << " #" << f.sequence << ": ";
+			print_stats(second, (now - t_report) * 1e-9);
+			second = read_stats{};
+			t_report = now;
+		}
+	}
+
+	cout << "total: ";
+	print_stats(total, (shm::monotonic_time() - t0) * 1e-9);
+}
+
+void synthetic_writer(string const & name, unsigned slots, unsigned w, unsigned h, atomic<bool> & quit)
+{
+	size_t size = size_t(w) * h * 4;
+	shm::frame_writer ring{name, slots, size};
+
+	for (uint8_t value = 0; !quit; ++value)
+	{
+		memset(ring.acquire(), value, size);
+		ring.publish(w, h, shm::pixel_format::rgba8, size);
+	}
+}
+
+void print_stats(read_stats const & s, double dt)
+{
+	cout << s.frames / dt << " fps, " << s.bytes / dt / (1024.0*1024.0) << " MiB/s, "
+		<< s.dropped << " dropped, " << s.torn << " torn, "
+		<< (s.frames > 0 ? s.latency / s.frames : 0.0) << " ms latency" << std::endl;
+}
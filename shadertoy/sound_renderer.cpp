@@ -0,0 +1,201 @@
+#include <regex>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+#include "gl/shapes.hpp"
+#include "frame_sink.hpp"
+#include "uniform_variable.hpp"
+#include "sound_renderer.hpp"
+
+using std::string;
+using std::to_string;
+using std::vector;
+using std::min;
+using std::regex;
+using std::cerr;
+using std::make_shared;
+using glm::vec2;
+using gl::make_quad_xy;
+
+//! decodes rendered blocks in a worker thread
+class block_decoder : public frame_sink
+{
+public:
+	block_decoder(sound_renderer::consumer out, size_t frames)
+		: frame_sink{2}, _out{out}, _frames{frames}
+	{}
+
+	~block_decoder() override
+	{
+		stop();
+	}
+
+private:
+	bool consume(video_frame const & block) override
+	{
+		size_t n = min(size_t(block.width) * block.height, _frames);
+		_samples.resize(2*n);
+
+		// texel (left low, left high, right low, right high) bytes, rows in sample order
+		uint8_t const * p = block.pixels.data();
+		for (size_t i = 0; i < 2*n; ++i, p += 2)
+			_samples[i] = (p[0] + 256 * p[1]) / 65535.0f * 2.0f - 1.0f;
+
+		_out(_samples.data(), n);
+		_frames -= n;
+		return true;
+	}
+
+	sound_renderer::consumer _out;
+	size_t _frames;  //!< remaining
+	vector<float> _samples;
+};
+
+sound_renderer::sound_renderer(unsigned sample_rate, unsigned block_width, unsigned block_height)
+	: _sample_rate{sample_rate}
+	, _block_width{block_width}
+	, _block_height{block_height}
+	, _targets{{block_width, block_height}, {block_width, block_height}}
+{
+	_quad = make_quad_xy<gles2::mesh>(vec2{-1,-1}, 2);
+}
+
+bool sound_renderer::load(shadertoy_program const & prog)
+{
+	_prog.reset();
+	_error_log.clear();
+
+	if (!prog.has_sound())
+		return false;
+
+	static regex const sample_index_pat{R"(\bmainSound\s*\(\s*int\b)"};
+	bool sample_index = std::regex_search(prog.source().code, sample_index_pat);
+
+	string prolog = this->prolog(prog);
+	try {
+		auto m = make_shared<gles2::shader::module>();
+		m->from_memory(prolog + prog.source().code + epilog(sample_index), 100);
+
+		auto p = make_shared<gles2::shader::program>();
+		p->attach(m);
+		_prog = p;
+	}
+	catch (gles2::shader::exception & e) {
+		int line_offset = 2 + std::count(prolog.begin(), prolog.end(), '\n');  // #version and #define _FRAGMENT_ lines
+		correct_log_line_numbers(e.error_log, line_offset, prog.source());
+		_error_log = e.error_log;
+
+		cerr << "error: " << e.what() << " (sound program), what:\n" << e.error_log << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void sound_renderer::render(double duration, consumer out)
+{
+	if (!_prog)
+		return;
+
+	size_t const frames = size_t(duration * _sample_rate);
+	size_t const block_size = size_t(_block_width) * _block_height;
+	size_t const blocks = (frames + block_size - 1) / block_size;
+
+	int viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	_prog->use();
+	float_uniform{_prog->uniform_variable("iSampleRate")} = float(_sample_rate);
+	float_uniform block_offset{_prog->uniform_variable("iBlockOffset")};
+
+	block_decoder decoder{out, frames};
+
+	for (size_t b = 0; b <= blocks; ++b)
+	{
+		if (b < blocks)
+		{
+			_targets[b % 2].bind();
+			block_offset = float(b * block_size);
+			_quad.render();
+		}
+
+		if (b > 0)  // previous block is read back after the next one is queued
+		{
+			gles2::framebuffer & prev = _targets[(b - 1) % 2];
+			prev.bind();
+
+			size_t remaining = frames - (b - 1) * block_size;
+			unsigned rows = unsigned(min(block_size, remaining) + _block_width - 1) / _block_width;
+
+			video_frame block;
+			block.width = _block_width;
+			block.height = rows;
+			block.pixels.resize(size_t(_block_width) * rows * 4);
+			prev.read_pixels(0, 0, _block_width, rows, block.pixels.data());
+			decoder.write(std::move(block));
+		}
+	}
+
+	_targets[0].unbind();
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	glEnable(GL_DEPTH_TEST);
+}
+
+string sound_renderer::prolog(shadertoy_program const & prog) const
+{
+	string result = R"(
+		#ifdef _VERTEX_
+		attribute vec3 position;
+		void main() {
+			gl_Position = vec4(position, 1);
+		}
+		#endif  // _VERTEX_
+		#ifdef _FRAGMENT_
+		precision highp float;
+	)";
+
+	for (auto const & def : prog.current_specialization().defines)
+		result += "#define " + def.first + " " + def.second + "\n";
+
+	// image inputs are declared so shaders with both mainImage() and mainSound() compile
+	result += R"(
+		uniform vec3 iResolution;
+		uniform vec3 iChannelResolution[4];
+		uniform float iTime;
+		uniform int iFrame;
+		uniform vec4 iMouse;
+		uniform sampler2D iChannel0;
+		uniform sampler2D iChannel1;
+		uniform sampler2D iChannel2;
+		uniform sampler2D iChannel3;
+		uniform float iSampleRate;
+		uniform float iBlockOffset;  // index of the first block sample
+	)";
+
+	return result;
+}
+
+string sound_renderer::epilog(bool sample_index) const
+{
+	string result = R"(
+		void main() {
+			float idx = iBlockOffset + floor(gl_FragCoord.y) * )" + to_string(_block_width) + R"(.0 + floor(gl_FragCoord.x);
+			float t = idx / iSampleRate;
+	)";
+
+	result += sample_index ? "vec2 s = mainSound(int(idx), t);\n" : "vec2 s = mainSound(t);\n";
+
+	result += R"(
+			vec2 v = floor((0.5 + 0.5 * clamp(s, -1.0, 1.0)) * 65535.0 + 0.5);
+			vec2 hi = floor(v / 256.0);
+			vec2 lo = v - hi * 256.0;
+			gl_FragColor = vec4(lo.x, hi.x, lo.y, hi.y) / 255.0;
+		}
+		#endif
+	)";
+
+	return result;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <functional>
+#include "gles2/program_gles2.hpp"
+#include "gles2/mesh_gles2.hpp"
+#include "gles2/framebuffer_gles2.hpp"
+#include "shadertoy_program.hpp"
+
+/*! Renders `vec2 mainSound(float time)` (or `mainSound(int samp, float time)`)
+shader audio on the GPU.
+
+One draw call evaluates a block of block_width*block_height stereo samples,
+each sample is packed into one RGBA texel (16-bit left and right channels),
+so a minute of 44.1 kHz audio takes about ten draw calls with default block
+size. Blocks are rendered into two framebuffers (next block is rendered
+before the previous one is read back) and decoded in a worker thread
+which passes samples to the consumer.
+\note mainSound needs highp float support in the fragment shader.
+\code
+shadertoy_program prog{"sound.glsl"};
+sound_renderer sound;
+if (sound.load(prog))
+{
+	wav_writer wav{"sound.wav", 2, sound.sample_rate()};
+	sound.render(60.0, [&wav](float const * stereo, size_t frames){wav.write(stereo, frames);});
+}
+\endcode */
+class sound_renderer
+{
+public:
+	using consumer = std::function<void (float const * stereo, size_t frames)>;  //!< interleaved (left, right) samples
+
+	sound_renderer(unsigned sample_rate = 44100, unsigned block_width = 512, unsigned block_height = 512);
+	bool load(shadertoy_program const & prog);  //!< compiles sound program from prog shader, false if not a sound shader or on error
+	void render(double duration, consumer out);  //!< renders duration seconds of audio, called from consumer from worker thread
+	unsigned sample_rate() const {return _sample_rate;}
+	std::string const & error_log() const {return _error_log;}
+
+private:
+	std::string prolog(shadertoy_program const & prog) const;
+	std::string epilog(bool sample_index) const;
+
+	unsigned _sample_rate;
+	unsigned _block_width, _block_height;
+	std::shared_ptr<gles2::shader::program> _prog;
+	gles2::framebuffer _targets[2];
+	gles2::mesh _quad;
+	std::string _error_log;
+};
@@ -0,0 +1,63 @@
+#include <iomanip>
+#include "startup_trace.hpp"
+
+using std::string;
+using std::lock_guard;
+using std::mutex;
+
+startup_trace & startup_trace::instance()
+{
+	static startup_trace * result = new startup_trace;  // leaked, can be used from worker threads during exit
+	return *result;
+}
+
+startup_trace::startup_trace()
+	: _t0{clock::now()}
+	, _main_thread{std::this_thread::get_id()}
+	, _finished{false}
+{}
+
+void startup_trace::phase(string const & name)
+{
+	double t = elapsed();
+	bool main_thread = std::this_thread::get_id() == _main_thread;
+
+	lock_guard<mutex> lock{_lock};
+	if (!_finished)
+		_phases.push_back(entry{t, name, main_thread});
+}
+
+void startup_trace::finish()
+{
+	lock_guard<mutex> lock{_lock};
+	_finished = true;
+}
+
+bool startup_trace::finished() const
+{
+	lock_guard<mutex> lock{_lock};
+	return _finished;
+}
+
+double startup_trace::elapsed() const
+{
+	return std::chrono::duration<double, std::milli>{clock::now() - _t0}.count();
+}
+
+void startup_trace::write(std::ostream & out) const
+{
+	lock_guard<mutex> lock{_lock};
+
+	out << "startup trace (ms since start, +ms since previous phase of the same thread):\n";
+
+	double main_prev = 0.0, worker_prev = 0.0;
+	for (entry const & e : _phases)
+	{
+		double & prev = e.main_thread ? main_prev : worker_prev;
+		out << std::fixed << std::setprecision(1) << std::setw(9) << e.t << "  +" << std::setw(7) << e.t - prev
+			<< (e.main_thread ? "  " : "  [worker] ") << e.name << "\n";
+		prev = e.t;
+	}
+
+	out << std::flush;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <ostream>
+
+/*! Global (thread-safe) startup phase log, each phase is recorded with the
+time since the first instance() call (the beginning of main()) and with
+the thread it finished in.
+\code
+startup_trace & trace = startup_trace::instance();
+trace.phase("window created");
+// ...
+trace.finish();
+trace.write(cerr);
+\endcode */
+class startup_trace
+{
+public:
+	static startup_trace & instance();
+
+	void phase(std::string const & name);  //!< records phase end, ignored after finish()
+	void finish();  //!< startup is done, stops recording
+	bool finished() const;
+	double elapsed() const;  //!< time since start in ms
+	void write(std::ostream & out) const;  //!< phase per line with start offset and phase duration
+
+private:
+	struct entry
+	{
+		double t;  //!< in ms
+		std::string name;
+		bool main_thread;
+	};
+
+	using clock = std::chrono::steady_clock;
+
+	startup_trace();
+
+	clock::time_point const _t0;
+	std::thread::id const _main_thread;
+	std::vector<entry> _phases;
+	bool _finished;
+	mutable std::mutex _lock;
+};
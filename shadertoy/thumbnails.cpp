@@ -0,0 +1,297 @@
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <Magick++.h>
+#include <boost/filesystem/operations.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <glm/vec4.hpp>
+#include "gl/shapes.hpp"
+#include "gles2/mesh_gles2.hpp"
+#include "gles2/framebuffer_gles2.hpp"
+#include "headless_context.hpp"
+#include "program_preloader.hpp"
+#include "project_file.hpp"
+#include "playlist.hpp"
+#include "utility.hpp"
+#include "thumbnails.hpp"
+
+using std::string;
+using std::to_string;
+using std::vector;
+using std::map;
+using std::thread;
+using std::atomic;
+using std::ifstream;
+using std::ofstream;
+using std::ostringstream;
+using std::min;
+using std::max;
+using boost::algorithm::ends_with;
+using glm::vec2;
+using glm::ivec2;
+using glm::vec4;
+using gl::make_quad_xy;
+using gles2::framebuffer;
+namespace fs = boost::filesystem;
+
+struct thumbnail
+{
+	string fname;  //!< shader or project file
+	string png;  //!< thumbnail file
+	size_t key = 0;  //!< cache key
+	bool cached = false,
+		failed = false;
+	vector<uint8_t> pixels;  //!< top-down RGBA pixels of rendered thumbnail
+};
+
+static ivec2 tile_origin(size_t i, thumbnail_options const & opts);
+static size_t cache_key(string const & fname, thumbnail_options const & opts);
+static map<string, size_t> load_cache(string const & fname);
+static void save_cache(string const & fname, vector<thumbnail> const & thumbs);
+static void write_thumbnails(vector<thumbnail *> const & thumbs, ivec2 const & size, unsigned jobs);
+static void write_contact_sheet(string const & fname, vector<thumbnail> const & thumbs, thumbnail_options const & opts);
+
+unsigned render_thumbnails(string const & dir, thumbnail_options const & opts, std::ostream & log)
+{
+	playlist files;
+	if (!files.load(dir))
+		throw std::runtime_error{"no shader found in '" + dir + "'"};
+
+	fs::path out = opts.output.empty() ? fs::path{dir} / "thumbnails" : fs::path{opts.output};
+	fs::create_directories(out);
+
+	string cache_fname = (out / "thumbnails.cache").string();
+	map<string, size_t> cache = load_cache(cache_fname);
+
+	vector<thumbnail> thumbs(files.size());
+	vector<thumbnail *> changed;
+	for (thumbnail & t : thumbs)
+	{
+		t.fname = files.current();
+		t.png = (out / (flattened_path(relative_path(t.fname, dir)) + ".png")).string();
+		t.key = cache_key(t.fname, opts);
+
+		auto it = cache.find(t.png);
+		t.cached = t.key != 0 && it != cache.end() && it->second == t.key && fs::exists(t.png);
+		if (!t.cached)
+			changed.push_back(&t);
+
+		files.next();
+	}
+
+	if (!glfwInit())
+		throw std::runtime_error{"unable to initialize GLFW"};
+
+	{
+		headless_context ctx;
+		ctx.make_current();
+
+		ivec2 const & size = opts.size;
+		unsigned const tiles = opts.columns * opts.rows;
+		framebuffer atlas{opts.columns * size.x, opts.rows * size.y};
+		gles2::mesh quad = make_quad_xy<gles2::mesh>(vec2{-1,-1}, 2);
+		vector<uint8_t> pixels(atlas.width() * atlas.height() * 4);
+
+		atlas.bind();
+		glDisable(GL_DEPTH_TEST);
+		glClearColor(0, 0, 0, 1);
+
+		for (size_t page = 0; page < changed.size(); page += tiles)
+		{
+			size_t count = min<size_t>(tiles, changed.size() - page);
+
+			glDisable(GL_SCISSOR_TEST);
+			glViewport(0, 0, atlas.width(), atlas.height());
+			glClear(GL_COLOR_BUFFER_BIT);
+			glEnable(GL_SCISSOR_TEST);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				thumbnail & t = *changed[page + i];
+
+				ivec2 origin = tile_origin(i, opts);
+				glViewport(origin.x, origin.y, size.x, size.y);
+				glScissor(origin.x, origin.y, size.x, size.y);
+
+				shadertoy_program::specialization spec;
+				spec.origin = vec2{origin};
+
+				prepared_program p;
+				try {
+					t.failed = !prepare_program(t.fname, spec, p);
+				}
+				catch (std::exception & e) {
+					log << "error: " << e.what() << std::endl;
+					t.failed = true;
+				}
+
+				if (t.failed)
+				{
+					log << "'" << t.fname << "' failed" << std::endl;
+					continue;
+				}
+
+				for (auto & ch : p.channels)
+					ch->update(opts.time);
+
+				p.prog.use();
+				p.prog.update(opts.time, vec2{size}, 0, vec4{0});
+				quad.render();
+			}
+
+			atlas.read_pixels(0, 0, atlas.width(), atlas.height(), pixels.data());
+			for (size_t i = 3; i < pixels.size(); i += 4)  // shaders often leave alpha zero or undefined
+				pixels[i] = 255;
+
+			// crop tiles (framebuffer rows are bottom-up)
+			for (size_t i = 0; i < count; ++i)
+			{
+				thumbnail & t = *changed[page + i];
+				if (t.failed)
+					continue;
+
+				ivec2 origin = tile_origin(i, opts);
+				t.pixels.resize(size.x * size.y * 4);
+				for (int y = 0; y < size.y; ++y)
+				{
+					uint8_t const * src = pixels.data() + ((origin.y + y) * atlas.width() + origin.x) * 4;
+					std::copy(src, src + size.x * 4, t.pixels.data() + (size.y - 1 - y) * size.x * 4);
+				}
+			}
+		}
+
+		atlas.unbind();
+		channel_texture_cache().clear();  // while context is current
+		ctx.release();
+	}  // context needs to be destroyed before glfwTerminate()
+
+	glfwTerminate();
+
+	vector<thumbnail *> rendered;
+	for (thumbnail * t : changed)
+		if (!t->failed)
+			rendered.push_back(t);
+
+	write_thumbnails(rendered, opts.size, opts.jobs);
+	save_cache(cache_fname, thumbs);
+	write_contact_sheet((out / "contact_sheet.png").string(), thumbs, opts);
+
+	unsigned failed = changed.size() - rendered.size();
+	log << rendered.size() << " thumbnail(s) rendered, " << thumbs.size() - changed.size() << " cached, "
+		<< failed << " failed, written to '" << out.string() << "'" << std::endl;
+
+	return failed;
+}
+
+//! tile position in atlas (bottom-left) and contact sheet (top-left)
+ivec2 tile_origin(size_t i, thumbnail_options const & opts)
+{
+	return ivec2{int(i % opts.columns) * opts.size.x, int(i / opts.columns) * opts.size.y};
+}
+
+//! returns 0 for unreadable shader
+size_t cache_key(string const & fname, thumbnail_options const & opts)
+{
+	string key = to_string(opts.size.x) + "x" + to_string(opts.size.y) + "@" + to_string(opts.time) + ";opaque;";
+	string shader = fname;
+
+	try {
+		if (ends_with(fname, ".stoy"))
+		{
+			ifstream fin{fname};
+			ostringstream content;
+			content << fin.rdbuf();
+			key += content.str();
+
+			io::project_file prj;
+			if (!prj.load(fname))
+				return 0;
+
+			shader = resolve_project_path(fname, prj.shader_program());
+		}
+
+		key += to_string(default_shader_preprocessor().expand(shader).hash);
+	}
+	catch (std::exception &) {
+		return 0;
+	}
+
+	return max<size_t>(std::hash<string>{}(key), 1);
+}
+
+//! cache file line format is 'KEY PNG_FILE'
+map<string, size_t> load_cache(string const & fname)
+{
+	map<string, size_t> result;
+
+	ifstream fin{fname};
+	size_t key;
+	string png;
+	while (fin >> key && getline(fin >> std::ws, png))
+		result[png] = key;
+
+	return result;
+}
+
+void save_cache(string const & fname, vector<thumbnail> const & thumbs)
+{
+	ofstream fout{fname};
+	for (thumbnail const & t : thumbs)
+		if (!t.failed && t.key != 0)
+			fout << t.key << " " << t.png << "\n";
+}
+
+void write_thumbnails(vector<thumbnail *> const & thumbs, ivec2 const & size, unsigned jobs)
+{
+	jobs = max(1u, min(jobs, (unsigned)thumbs.size()));
+	atomic<size_t> next{0};
+
+	vector<thread> writers;
+	for (unsigned i = 0; i < jobs; ++i)
+	{
+		writers.emplace_back([&thumbs, &size, &next]{
+			for (size_t i = next++; i < thumbs.size(); i = next++)
+			{
+				thumbnail const & t = *thumbs[i];
+				Magick::Image im{(size_t)size.x, (size_t)size.y, "RGBA", Magick::CharPixel, t.pixels.data()};
+				im.write(t.png);
+			}
+		});
+	}
+
+	for (thread & w : writers)
+		w.join();
+}
+
+void write_contact_sheet(string const & fname, vector<thumbnail> const & thumbs, thumbnail_options const & opts)
+{
+	ivec2 const & size = opts.size;
+	size_t rows = (thumbs.size() + opts.columns - 1) / opts.columns;
+	Magick::Image sheet{Magick::Geometry(opts.columns * size.x, rows * size.y), Magick::Color{"black"}};
+
+	for (size_t i = 0; i < thumbs.size(); ++i)
+	{
+		thumbnail const & t = thumbs[i];
+		if (t.failed)
+			continue;
+
+		Magick::Image im;
+		if (!t.pixels.empty())
+			im.read(size.x, size.y, "RGBA", Magick::CharPixel, t.pixels.data());
+		else
+			im.read(t.png);
+
+		ivec2 pos = tile_origin(i, opts);
+		sheet.composite(im, pos.x, pos.y, Magick::OverCompositeOp);
+	}
+
+	sheet.write(fname);
+}
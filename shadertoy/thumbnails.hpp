@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <ostream>
+#include <glm/vec2.hpp>
+
+//! thumbnail generator options \sa render_thumbnails()
+struct thumbnail_options
+{
+	glm::ivec2 size = glm::ivec2{160, 90};  //!< thumbnail size in pixels
+	float time = 1.0f;  //!< iTime value shaders are rendered for
+	unsigned columns = 8;  //!< atlas and contact sheet columns
+	unsigned rows = 8;  //!< atlas rows, columns*rows shaders are rendered in one atlas pass
+	unsigned jobs = 1;  //!< number of PNG writer threads
+	std::string output;  //!< output directory, DIR/thumbnails if empty
+};
+
+/*! Renders thumbnail for each shader program and project in a directory (or a
+playlist file) and a contact sheet with all thumbnails.
+
+Shaders are rendered into scissored sub-viewports of one atlas framebuffer
+(single headless context, no render target reallocation), thumbnails are
+written as opaque `PATH.png` files (path relative to dir with `/` replaced
+by `_`) in parallel. Thumbnails are cached by the expanded
+shader source hash (and project file content) so only changed shaders are
+rendered again.
+\note Channel texture content changes are not detected.
+\return number of shaders failed to render */
+unsigned render_thumbnails(std::string const & dir, thumbnail_options const & opts, std::ostream & log);
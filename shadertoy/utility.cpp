@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <regex>
 #include <iostream>
+#include <cstdio>
 #include <boost/filesystem/operations.hpp>
 #include <unistd.h>
 #include "utility.hpp"
@@ -33,7 +34,15 @@ string program_directory()
 	return result;
 }
 
+static string find_font_file();
+
 string locate_font()
+{
+	static string const result = find_font_file();  // filesystem is probed once (thread-safe)
+	return result;
+}
+
+string find_font_file()
 {
 	if (fs::exists(default_ubuntu_font_1804))
 		return default_ubuntu_font_1804;
@@ -65,3 +74,59 @@ ivec2 parse_size(string const & size, ivec2 const & default_value)
 		return default_value;
 	}
 }
+
+string json_quote(string const & s)
+{
+	string result{"\""};
+	for (char c : s)
+	{
+		switch (c)
+		{
+			case '"': result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			case '\n': result += "\\n"; break;
+			case '\r': result += "\\r"; break;
+			case '\t': result += "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20)
+				{
+					char buf[8];
+					snprintf(buf, sizeof buf, "\\u%04x", c);
+					result += buf;
+				}
+				else
+					result += c;
+		}
+	}
+	return result + "\"";
+}
+
+string relative_path(string const & fname, string const & root)
+{
+	fs::path base = fs::is_directory(root) ? fs::path{root} : fs::path{root}.parent_path();
+	fs::path rel = fs::absolute(fname).lexically_normal().lexically_relative(
+		fs::absolute(base).lexically_normal());
+	return rel.empty() ? fs::path{fname}.filename().generic_string() : rel.generic_string();
+}
+
+string flattened_path(string const & rel_path)
+{
+	string result = rel_path;
+	std::replace(result.begin(), result.end(), '/', '_');
+	if (!result.empty() && result[0] == '.')  // '../' prefix, not hidden file
+		result[0] = '_';
+	return result;
+}
+
+string resolve_project_path(string const & project, string const & fname)
+{
+	fs::path p{fname};
+	if (p.is_relative() && !fs::exists(p))
+	{
+		fs::path candidate = fs::path{project}.parent_path() / p;
+		if (fs::exists(candidate))
+			return candidate.string();
+	}
+
+	return fname;
+}
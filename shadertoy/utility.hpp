@@ -5,3 +5,7 @@
 std::string program_directory();
 std::string locate_font();
 glm::ivec2 parse_size(std::string const & size, glm::ivec2 const & default_value);
+std::string json_quote(std::string const & s);  //!< returns s as quoted and escaped JSON string
+std::string relative_path(std::string const & fname, std::string const & root);  //!< fname relative to root directory (or to directory of root file) in generic format
+std::string flattened_path(std::string const & rel_path);  //!< relative path as file name ('/' replaced by '_', no leading '.')
+std::string resolve_project_path(std::string const & project, std::string const & fname);  //!< project resources are relative to the working directory, falls back to the project directory
@@ -0,0 +1,311 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <Magick++.h>
+#include <boost/filesystem/operations.hpp>
+#include "yuv.hpp"
+#include "video_channel.hpp"
+
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::unique_ptr;
+using std::ifstream;
+using std::istringstream;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+using std::min;
+using gles2::texture2d;
+using gles2::pixel_format;
+using gles2::pixel_type;
+namespace fs = boost::filesystem;
+
+namespace detail {
+
+//! random access frame decoder, used from decoder thread only
+class frame_reader
+{
+public:
+	virtual ~frame_reader() {}
+	virtual bool read(size_t index, vector<uint8_t> & rgba) = 0;  //!< reads bottom-up RGBA frame
+	unsigned width() const {return _width;}
+	unsigned height() const {return _height;}
+	double fps() const {return _fps;}
+	size_t count() const {return _count;}
+
+protected:
+	unsigned _width = 0, _height = 0;
+	double _fps = 30.0;
+	size_t _count = 0;
+};
+
+/*! YUV4MPEG2 4:2:0 reader, expects frames without parameters (`FRAME\n`
+headers) so frame position can be computed */
+class y4m_reader : public frame_reader
+{
+public:
+	y4m_reader(string const & fname)
+		: _fin{fname, std::ios::binary}
+	{
+		string header;
+		if (!getline(_fin, header) || header.compare(0, 10, "YUV4MPEG2 ") != 0)
+			throw std::runtime_error{"'" + fname + "' is not a YUV4MPEG2 file"};
+
+		istringstream params{header.substr(10)};
+		string p;
+		while (params >> p)
+		{
+			if (p[0] == 'W')
+				_width = std::stoul(p.substr(1));
+			else if (p[0] == 'H')
+				_height = std::stoul(p.substr(1));
+			else if (p[0] == 'F')
+			{
+				unsigned num = 30, den = 1;
+				sscanf(p.c_str() + 1, "%u:%u", &num, &den);
+				_fps = den > 0 ? double(num) / den : 30.0;
+			}
+			else if (p[0] == 'C' && p.compare(0, 4, "C420") != 0)
+				throw std::runtime_error{"'" + fname + "' unsupported " + p + " chroma subsampling (only 4:2:0)"};
+		}
+
+		if (_width == 0 || _height == 0)
+			throw std::runtime_error{"'" + fname + "' without frame size"};
+
+		_chroma_size = size_t((_width + 1) / 2) * ((_height + 1) / 2);
+		_frame_size = size_t(_width) * _height + 2 * _chroma_size;
+		_data_offset = _fin.tellg();
+		_count = (fs::file_size(fname) - _data_offset) / (_frame_size + frame_header.size());
+
+		if (_count == 0)
+			throw std::runtime_error{"'" + fname + "' without frames"};
+	}
+
+	bool read(size_t index, vector<uint8_t> & rgba) override
+	{
+		_fin.clear();
+		_fin.seekg(_data_offset + index * (_frame_size + frame_header.size()));
+
+		string header(frame_header.size(), '\0');
+		_yuv.resize(_frame_size);
+		if (!_fin.read(&header[0], header.size()) || header != frame_header
+			|| !_fin.read(reinterpret_cast<char *>(_yuv.data()), _yuv.size()))
+		{
+			return false;
+		}
+
+		rgba.resize(size_t(_width) * _height * 4);
+		int stride = int(_width) * 4;
+		uint8_t const * y = _yuv.data(),
+			* u = y + size_t(_width) * _height,
+			* v = u + _chroma_size;
+		i420_to_rgba(y, u, v, _width, _height, rgba.data() + size_t(_height - 1) * stride, -stride);  // flip
+		return true;
+	}
+
+private:
+	string const frame_header = "FRAME\n";
+	ifstream _fin;
+	size_t _data_offset, _frame_size, _chroma_size;
+	vector<uint8_t> _yuv;
+};
+
+//! image sequence reader for `name_%04d.png[@FPS]` like sources
+class image_sequence_reader : public frame_reader
+{
+public:
+	image_sequence_reader(string const & source)
+		: _pattern{source}
+		, _first{0}
+	{
+		size_t at = source.rfind('@');
+		if (at != string::npos && at > source.rfind('%'))
+		{
+			_pattern = source.substr(0, at);
+			_fps = std::stod(source.substr(at + 1));
+		}
+
+		if (!fs::exists(file(0)))
+			_first = 1;
+
+		while (fs::exists(file(_first + _count)))
+			++_count;
+
+		if (_count == 0)
+			throw std::runtime_error{"no '" + _pattern + "' image sequence file found"};
+
+		Magick::Image im{file(_first)};
+		_width = im.columns();
+		_height = im.rows();
+	}
+
+	bool read(size_t index, vector<uint8_t> & rgba) override
+	{
+		try {
+			Magick::Image im{file(_first + index)};
+			if (im.columns() != _width || im.rows() != _height)
+				im.resize(Magick::Geometry(_width, _height));
+
+			im.flip();
+			rgba.resize(size_t(_width) * _height * 4);
+			im.write(0, 0, _width, _height, "RGBA", Magick::CharPixel, rgba.data());
+		}
+		catch (std::exception &) {
+			return false;
+		}
+
+		return true;
+	}
+
+private:
+	string file(size_t index) const
+	{
+		vector<char> buf(_pattern.size() + 32);
+		snprintf(buf.data(), buf.size(), _pattern.c_str(), int(index));
+		return string{buf.data()};
+	}
+
+	string _pattern;
+	size_t _first;
+};
+
+}  // detail
+
+video_channel::video_channel(string const & source)
+	: _ring_pos{0}
+	, _shown{std::numeric_limits<size_t>::max()}
+	, _next{0}
+	, _generation{0}
+	, _quit{false}
+{
+	if (source.find('%') != string::npos)
+		_reader.reset(new detail::image_sequence_reader{source});
+	else
+		_reader.reset(new detail::y4m_reader{source});
+
+	unsigned w = _reader->width(), h = _reader->height();
+	vector<uint8_t> black(size_t(w) * h * 4, 0);
+
+	auto params = texture2d::parameters{}.filter(gles2::texture_filter::linear);
+	_tex = shared_ptr<texture2d>{new texture2d{w, h, pixel_format::rgba, pixel_type::ub8, black.data(), params}};
+	_ring.reserve(texture_count);
+	for (size_t i = 0; i < texture_count; ++i)
+		_ring.emplace_back(w, h, pixel_format::rgba, pixel_type::ub8, params);
+
+	_decoder = std::thread{&video_channel::decode_loop, this};
+}
+
+video_channel::~video_channel()
+{
+	{
+		lock_guard<mutex> lock{_lock};
+		_quit = true;
+	}
+	_consumed.notify_all();
+	_decoder.join();
+}
+
+shared_ptr<texture2d> video_channel::texture() const
+{
+	return _tex;
+}
+
+double video_channel::fps() const
+{
+	return _reader->fps();
+}
+
+size_t video_channel::frame_count() const
+{
+	return _reader->count();
+}
+
+void video_channel::update(double t)
+{
+	size_t index = size_t(std::floor(std::max(t, 0.0) * _reader->fps())) % _reader->count();
+	if (index == _shown)
+		return;
+
+	frame f = take_frame(index);
+	_shown = index;
+
+	if (f.pixels.empty())  // decoding failed, keep previous frame
+		return;
+
+	// upload into a texture not used by the last frames, then swap it with the shown one
+	texture2d & tex = _ring[_ring_pos];
+	tex.write(0, 0, tex.width(), tex.height(), pixel_format::rgba, pixel_type::ub8, f.pixels.data());
+
+	*_tex = std::move(tex);  // swaps texture ids
+
+	_ring_pos = (_ring_pos + 1) % _ring.size();
+}
+
+video_channel::frame video_channel::take_frame(size_t index)
+{
+	size_t const count = _reader->count();
+	auto distance = [count](size_t from, size_t to){return (to + count - from) % count;};  // decoding order distance
+
+	unique_lock<mutex> lock{_lock};
+	while (true)
+	{
+		// skip frames decoded before index
+		while (!_frames.empty() && _frames.front().index != index
+			&& distance(_frames.front().index, index) <= 2 * queue_size)
+		{
+			_frames.pop_front();
+			_consumed.notify_one();
+		}
+
+		if (!_frames.empty() && _frames.front().index == index)
+		{
+			frame result = std::move(_frames.front());
+			_frames.pop_front();
+			_consumed.notify_one();
+			return result;
+		}
+
+		bool decoding_soon = _frames.empty() && distance(_next, index) <= 2 * queue_size;
+		if (!decoding_soon)  // seek
+		{
+			_frames.clear();
+			_next = index;
+			++_generation;
+			_consumed.notify_one();
+		}
+
+		_decoded.wait(lock);
+	}
+}
+
+void video_channel::decode_loop()
+{
+	vector<uint8_t> pixels;
+
+	unique_lock<mutex> lock{_lock};
+	while (true)
+	{
+		_consumed.wait(lock, [this]{return _frames.size() < queue_size || _quit;});
+		if (_quit)
+			break;
+
+		size_t index = _next;
+		unsigned generation = _generation;
+		_next = (_next + 1) % _reader->count();
+
+		lock.unlock();
+		bool ok = _reader->read(index, pixels);
+		lock.lock();
+
+		if (generation != _generation)  // seek while decoding
+			continue;
+
+		_frames.push_back(frame{index, ok ? pixels : vector<uint8_t>{}});
+		_decoded.notify_one();
+	}
+}
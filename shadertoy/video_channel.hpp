@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "channel_source.hpp"
+
+namespace detail {
+
+class frame_reader;
+
+}  // detail
+
+/*! Moving iChannel input from a YUV4MPEG2 (4:2:0) video file or an image
+sequence.
+
+Image sequence is given by a printf like pattern with optional frame rate
+(30 by default), e.g. `plates/shot_%04d.png@24`, numbering starts at 0 or 1.
+Frames are decoded ahead in a background thread into a bounded queue and
+uploaded (glTexSubImage2D) into a ring of preallocated textures, the shown
+one is swapped into the channel texture. Frame is selected from iTime and
+update() waits for it, so exports are deterministic. Video loops.
+\code
+# project file
+composite.glsl
+plate.y4m
+\endcode */
+class video_channel : public channel_source
+{
+public:
+	video_channel(std::string const & source);  //!< throws std::runtime_error for unsupported source
+	~video_channel() override;
+	std::shared_ptr<gles2::texture2d> texture() const override;
+	void update(double t) override;
+	double fps() const;
+	size_t frame_count() const;
+
+private:
+	static size_t const queue_size = 8;
+	static size_t const texture_count = 3;
+
+	struct frame
+	{
+		size_t index;
+		std::vector<uint8_t> pixels;  //!< bottom-up RGBA rows, empty if decoding failed
+	};
+
+	void decode_loop();
+	frame take_frame(size_t index);  //!< waits for decoded index frame
+
+	std::unique_ptr<detail::frame_reader> _reader;
+	std::shared_ptr<gles2::texture2d> _tex;  //!< shown frame
+	std::vector<gles2::texture2d> _ring;  //!< textures frames are uploaded into
+	size_t _ring_pos;
+	size_t _shown;  //!< shown frame index
+
+	std::deque<frame> _frames;  //!< decoded frames
+	size_t _next;  //!< next frame to decode
+	unsigned _generation;  //!< incremented on seek
+	bool _quit;
+	std::mutex _lock;
+	std::condition_variable _decoded, _consumed;
+	std::thread _decoder;
+};
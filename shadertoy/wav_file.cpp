@@ -0,0 +1,190 @@
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include "wav_file.hpp"
+
+using std::string;
+using std::vector;
+
+static uint32_t read_u32(char const * p);
+static uint16_t read_u16(char const * p);
+static void write_u32(char * p, uint32_t v);
+static void write_u16(char * p, uint16_t v);
+
+wav_reader::wav_reader(string const & fname)
+	: _fin{fname, std::ios::binary}
+	, _frames_read{0}
+{
+	if (!_fin.is_open())
+		throw std::runtime_error{"unable to open '" + fname + "' file"};
+
+	char riff[12];
+	if (!_fin.read(riff, 12) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+		throw std::runtime_error{"'" + fname + "' is not a WAV file"};
+
+	bool has_format = false;
+	char chunk[8];
+	while (_fin.read(chunk, 8))
+	{
+		uint32_t size = read_u32(chunk + 4);
+
+		if (memcmp(chunk, "fmt ", 4) == 0)
+		{
+			vector<char> fmt(size);
+			if (size < 16 || !_fin.read(fmt.data(), size))
+				break;
+
+			uint16_t tag = read_u16(fmt.data());
+			if (tag == 0xfffe && size >= 26)  // WAVE_FORMAT_EXTENSIBLE, sub-format GUID starts with the format tag
+				tag = read_u16(fmt.data() + 24);
+
+			_fmt.channels = read_u16(fmt.data() + 2);
+			_fmt.sample_rate = read_u32(fmt.data() + 4);
+			_fmt.bits = read_u16(fmt.data() + 14);
+			_fmt.floating = tag == 3;
+
+			bool pcm = tag == 1 && (_fmt.bits == 8 || _fmt.bits == 16 || _fmt.bits == 24 || _fmt.bits == 32);
+			if (!(pcm || (_fmt.floating && _fmt.bits == 32)) || _fmt.channels == 0)
+				throw std::runtime_error{"unsupported '" + fname + "' WAV sample format"};
+
+			has_format = true;
+			if (size & 1)
+				_fin.ignore(1);  // chunks are word aligned
+		}
+		else if (memcmp(chunk, "data", 4) == 0)
+		{
+			if (!has_format)
+				break;
+
+			_fmt.frames = size / (_fmt.channels * (_fmt.bits / 8));
+			return;  // file is positioned at sample data
+		}
+		else
+			_fin.ignore(size + (size & 1));
+	}
+
+	throw std::runtime_error{"'" + fname + "' is corrupted WAV file"};
+}
+
+size_t wav_reader::read(float * mono, size_t frames)
+{
+	frames = std::min(frames, _fmt.frames - _frames_read);
+
+	unsigned const sample_size = _fmt.bits / 8;
+	unsigned const frame_size = sample_size * _fmt.channels;
+	vector<uint8_t> buf(frames * frame_size);
+	_fin.read(reinterpret_cast<char *>(buf.data()), buf.size());
+	frames = _fin.gcount() / frame_size;
+
+	for (size_t i = 0; i < frames; ++i)
+	{
+		float sum = 0.0f;
+		for (unsigned c = 0; c < _fmt.channels; ++c)
+		{
+			uint8_t const * p = buf.data() + i * frame_size + c * sample_size;
+			switch (_fmt.bits)
+			{
+				case 8: sum += (p[0] - 128) / 128.0f; break;  // unsigned
+				case 16: sum += int16_t(p[0] | (p[1] << 8)) / 32768.0f; break;
+				case 24: sum += int32_t((p[0] << 8) | (p[1] << 16) | (uint32_t(p[2]) << 24)) / 2147483648.0f; break;
+				case 32:
+				{
+					uint32_t u = p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+					if (_fmt.floating)
+					{
+						float f;
+						memcpy(&f, &u, 4);
+						sum += f;
+					}
+					else
+						sum += int32_t(u) / 2147483648.0f;
+					break;
+				}
+			}
+		}
+
+		mono[i] = sum / _fmt.channels;
+	}
+
+	_frames_read += frames;
+	return frames;
+}
+
+wav_writer::wav_writer(string const & fname, unsigned channels, unsigned sample_rate)
+	: _fout{fname, std::ios::binary}
+	, _channels{channels}
+	, _sample_rate{sample_rate}
+	, _frames{0}
+{
+	if (!_fout.is_open())
+		throw std::runtime_error{"unable to create '" + fname + "' file"};
+
+	write_header();  // rewritten with the final size in destructor
+}
+
+wav_writer::~wav_writer()
+{
+	_fout.seekp(0);
+	write_header();
+}
+
+void wav_writer::write(float const * samples, size_t frames)
+{
+	vector<char> buf(frames * _channels * 2);
+	for (size_t i = 0; i < frames * _channels; ++i)
+	{
+		float s = std::max(-1.0f, std::min(samples[i], 1.0f));
+		write_u16(buf.data() + 2*i, uint16_t(int16_t(std::lround(s * 32767.0f))));
+	}
+
+	_fout.write(buf.data(), buf.size());
+	_frames += frames;
+}
+
+void wav_writer::write_header()
+{
+	uint32_t data_size = _frames * _channels * 2;
+
+	char h[44];
+	memcpy(h, "RIFF", 4);
+	write_u32(h + 4, 36 + data_size);
+	memcpy(h + 8, "WAVEfmt ", 8);
+	write_u32(h + 16, 16);  // fmt chunk size
+	write_u16(h + 20, 1);  // PCM
+	write_u16(h + 22, _channels);
+	write_u32(h + 24, _sample_rate);
+	write_u32(h + 28, _sample_rate * _channels * 2);  // byte rate
+	write_u16(h + 32, _channels * 2);  // block align
+	write_u16(h + 34, 16);  // bits per sample
+	memcpy(h + 36, "data", 4);
+	write_u32(h + 40, data_size);
+
+	_fout.write(h, sizeof(h));
+}
+
+uint32_t read_u32(char const * p)
+{
+	uint8_t const * u = reinterpret_cast<uint8_t const *>(p);
+	return u[0] | (u[1] << 8) | (u[2] << 16) | (uint32_t(u[3]) << 24);
+}
+
+uint16_t read_u16(char const * p)
+{
+	uint8_t const * u = reinterpret_cast<uint8_t const *>(p);
+	return uint16_t(u[0] | (u[1] << 8));
+}
+
+void write_u32(char * p, uint32_t v)
+{
+	for (int i = 0; i < 4; ++i)
+		p[i] = char((v >> (8*i)) & 0xff);
+}
+
+void write_u16(char * p, uint16_t v)
+{
+	p[0] = char(v & 0xff);
+	p[1] = char(v >> 8);
+}
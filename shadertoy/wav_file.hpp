@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <fstream>
+#include <cstddef>
+
+struct wav_format
+{
+	unsigned channels = 0,
+		sample_rate = 0,
+		bits = 0;  //!< bits per sample
+	bool floating = false;  //!< IEEE float samples
+	size_t frames = 0;  //!< number of sample frames (samples per channel)
+};
+
+/*! WAV (RIFF) file reader for 8/16/24/32-bit PCM and 32-bit float data.
+\code
+wav_reader wav{"music.wav"};
+vector<float> mono(wav.format().frames);
+wav.read(mono.data(), mono.size());
+\endcode */
+class wav_reader
+{
+public:
+	wav_reader(std::string const & fname);  //!< throws std::runtime_error for unsupported or corrupted file
+	wav_format const & format() const {return _fmt;}
+	size_t read(float * mono, size_t frames);  //!< reads next frames mixed down to mono <-1, 1> samples, returns number of frames read
+
+private:
+	std::ifstream _fin;
+	wav_format _fmt;
+	size_t _frames_read;
+};
+
+/*! 16-bit PCM WAV file writer.
+\code
+wav_writer wav{"sound.wav", 2, 44100};
+wav.write(stereo.data(), stereo.size()/2);
+\endcode */
+class wav_writer
+{
+public:
+	wav_writer(std::string const & fname, unsigned channels, unsigned sample_rate);  //!< throws std::runtime_error
+	~wav_writer();  //!< finalizes file header
+	void write(float const * samples, size_t frames);  //!< writes interleaved <-1, 1> samples
+
+	wav_writer(wav_writer const &) = delete;
+	void operator=(wav_writer const &) = delete;
+
+private:
+	void write_header();
+
+	std::ofstream _fout;
+	unsigned _channels, _sample_rate;
+	size_t _frames;  //!< written
+};
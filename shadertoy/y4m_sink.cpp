@@ -0,0 +1,101 @@
+#include <iostream>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include "yuv.hpp"
+#include "y4m_sink.hpp"
+
+using std::string;
+using std::to_string;
+using std::cerr;
+
+y4m_sink::y4m_sink(string const & path, unsigned fps, size_t queue_size)
+	: frame_sink{queue_size}
+	, _fd{-1}
+	, _fps{fps}
+	, _width{0}
+	, _height{0}
+{
+	if (path == "-")
+		_fd = STDOUT_FILENO;
+	else
+	{
+		_fd = open(path.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);  // blocks for named pipe until reader is connected
+		if (_fd < 0)
+			throw std::runtime_error{"unable to open '" + path + "' output, what: " + strerror(errno)};
+	}
+
+	signal(SIGPIPE, SIG_IGN);  // closed pipe is reported as EPIPE error
+}
+
+y4m_sink::~y4m_sink()
+{
+	stop();
+
+	if (_fd != STDOUT_FILENO)
+		close(_fd);
+}
+
+bool y4m_sink::consume(video_frame const & frame)
+{
+	if (_width == 0)  // first frame, write stream header
+	{
+		_width = frame.width;
+		_height = frame.height;
+
+		string header = "YUV4MPEG2 W" + to_string(_width) + " H" + to_string(_height) + " F" + to_string(_fps)
+			+ ":1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+
+		if (!write_all(header.data(), header.size()))
+			return false;
+
+		cerr << "y4m: " << _width << "x" << _height << "@" << _fps << " stream, "
+			<< rgba_to_i420_kernel() << " converter" << std::endl;
+	}
+
+	if (frame.width != _width || frame.height != _height)
+	{
+		cerr << "warning: " << frame.width << "x" << frame.height << " frame dropped (stream size is "
+			<< _width << "x" << _height << ")" << std::endl;
+		return true;
+	}
+
+	unsigned chroma_size = ((_width + 1) / 2) * ((_height + 1) / 2);
+	_yuv.resize(_width * _height + 2 * chroma_size);
+
+	uint8_t * y = _yuv.data(),
+		* u = y + _width * _height,
+		* v = u + chroma_size;
+
+	// frame rows are bottom-up
+	int stride = int(_width) * 4;
+	rgba_to_i420(frame.pixels.data() + (_height - 1) * stride, -stride, _width, _height, y, u, v);
+
+	static char const frame_header[] = "FRAME\n";
+	return write_all(frame_header, sizeof(frame_header) - 1) && write_all(_yuv.data(), _yuv.size());
+}
+
+bool y4m_sink::write_all(void const * data, size_t size)
+{
+	char const * p = static_cast<char const *>(data);
+	while (size > 0)
+	{
+		ssize_t n = ::write(_fd, p, size);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			cerr << "error: unable to write y4m stream, what: " << strerror(errno) << std::endl;
+			return false;
+		}
+
+		p += n;
+		size -= n;
+	}
+
+	return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "frame_sink.hpp"
+
+/*! YUV4MPEG2 (4:2:0) video stream writer.
+
+Frames are converted to I420 and written in the worker thread. Stream size
+is given by the first frame, frames with different size are dropped.
+\code
+y4m_sink out{"-", 30};  // standard output, e.g. `shadertoy ... | ffmpeg -i - out.mp4`
+out.write(read_frame(w, h));
+\endcode */
+class y4m_sink : public frame_sink
+{
+public:
+	//! path is a file or a named pipe, "-" for standard output
+	y4m_sink(std::string const & path, unsigned fps, size_t queue_size = 4);
+	~y4m_sink() override;
+
+private:
+	bool consume(video_frame const & frame) override;
+	bool write_all(void const * data, size_t size);
+
+	int _fd;
+	unsigned _fps;
+	unsigned _width, _height;  //!< stream size
+	std::vector<uint8_t> _yuv;  //!< I420 frame buffer
+};
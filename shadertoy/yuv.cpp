@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstddef>
+#include "yuv.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define HAVE_X86_KERNELS
+	#include <immintrin.h>
+#endif
+
+using std::min;
+
+namespace {
+
+using row_function = void (*)(uint8_t const * rgba, unsigned width, uint8_t * y);
+using chroma_row_function = void (*)(uint8_t const * row0, uint8_t const * row1, unsigned width,
+	uint8_t * u, uint8_t * v);
+
+/* BT.601 limited range
+	Y = ((66*R + 129*G + 25*B + 128) >> 8) + 16
+	U = ((-38*R - 74*G + 112*B + 128) >> 8) + 128
+	V = ((112*R - 94*G - 18*B + 128) >> 8) + 128
+chroma is computed from sum of 2x2 block pixels (hence >> 10) */
+
+inline uint8_t luma(uint8_t const * p)
+{
+	return uint8_t(((66*p[0] + 129*p[1] + 25*p[2] + 128) >> 8) + 16);
+}
+
+void luma_row_scalar(uint8_t const * rgba, unsigned width, uint8_t * y)
+{
+	for (unsigned i = 0; i < width; ++i)
+		y[i] = luma(rgba + 4*i);
+}
+
+//! computes chroma for pixel pairs starting at from
+void chroma_row_scalar(uint8_t const * row0, uint8_t const * row1, unsigned from, unsigned width,
+	uint8_t * u, uint8_t * v)
+{
+	for (unsigned i = from; i < width; i += 2)
+	{
+		unsigned j = min(i + 1, width - 1);  // odd width replicates last column
+		uint8_t const * p[4] = {row0 + 4*i, row0 + 4*j, row1 + 4*i, row1 + 4*j};
+
+		int r = p[0][0] + p[1][0] + p[2][0] + p[3][0],
+			g = p[0][1] + p[1][1] + p[2][1] + p[3][1],
+			b = p[0][2] + p[1][2] + p[2][2] + p[3][2];
+
+		u[i/2] = uint8_t(((-38*r - 74*g + 112*b + 512) >> 10) + 128);
+		v[i/2] = uint8_t(((112*r - 94*g - 18*b + 512) >> 10) + 128);
+	}
+}
+
+#if !defined(HAVE_X86_KERNELS)  // SIMD kernels are used instead
+void chroma_row_scalar(uint8_t const * row0, uint8_t const * row1, unsigned width, uint8_t * u, uint8_t * v)
+{
+	chroma_row_scalar(row0, row1, 0, width, u, v);
+}
+#endif
+
+#if defined(HAVE_X86_KERNELS)
+
+//! sums (a0, b0, a1, b1) and (a2, b2, a3, b3) pairs into (a0+b0, a1+b1, a2+b2, a3+b3)
+inline __m128i hadd_pairs_sse2(__m128i lo, __m128i hi)
+{
+	__m128 a = _mm_castsi128_ps(lo), b = _mm_castsi128_ps(hi);
+	__m128i even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0))),
+		odd = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3,1,3,1)));
+	return _mm_add_epi32(even, odd);
+}
+
+//! Y for 4 pixels as 32-bit integers
+inline __m128i luma4_sse2(__m128i px, __m128i coef)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), coef),  // (R0*66+G0*129, B0*25, R1*66+G1*129, B1*25)
+		hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), coef);
+	__m128i sum = hadd_pairs_sse2(lo, hi);
+	return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8), _mm_set1_epi32(16));
+}
+
+void luma_row_sse2(uint8_t const * rgba, unsigned width, uint8_t * y)
+{
+	__m128i const coef = _mm_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0);
+
+	unsigned i = 0;
+	for (; i + 16 <= width; i += 16)
+	{
+		__m128i const * src = reinterpret_cast<__m128i const *>(rgba + 4*i);
+		__m128i y0 = luma4_sse2(_mm_loadu_si128(src), coef),
+			y1 = luma4_sse2(_mm_loadu_si128(src + 1), coef),
+			y2 = luma4_sse2(_mm_loadu_si128(src + 2), coef),
+			y3 = luma4_sse2(_mm_loadu_si128(src + 3), coef);
+
+		__m128i packed = _mm_packus_epi16(_mm_packs_epi32(y0, y1), _mm_packs_epi32(y2, y3));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(y + i), packed);
+	}
+
+	luma_row_scalar(rgba + 4*i, width - i, y + i);
+}
+
+//! sums 2x2 blocks of 4x2 pixels into two (R,G,B,A) 16-bit sums
+inline __m128i block_sums_sse2(uint8_t const * row0, uint8_t const * row1)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i p = _mm_loadu_si128(reinterpret_cast<__m128i const *>(row0)),
+		q = _mm_loadu_si128(reinterpret_cast<__m128i const *>(row1));
+
+	__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(p, zero), _mm_unpacklo_epi8(q, zero)),  // pixels 0, 1
+		hi = _mm_add_epi16(_mm_unpackhi_epi8(p, zero), _mm_unpackhi_epi8(q, zero));  // pixels 2, 3
+
+	lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+	hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+	return _mm_unpacklo_epi64(lo, hi);
+}
+
+//! U or V for 4 blocks as 32-bit integers
+inline __m128i chroma4_sse2(__m128i s01, __m128i s23, __m128i coef)
+{
+	__m128i sum = hadd_pairs_sse2(_mm_madd_epi16(s01, coef), _mm_madd_epi16(s23, coef));
+	return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(512)), 10), _mm_set1_epi32(128));
+}
+
+void chroma_row_sse2(uint8_t const * row0, uint8_t const * row1, unsigned width, uint8_t * u, uint8_t * v)
+{
+	__m128i const ucoef = _mm_setr_epi16(-38, -74, 112, 0, -38, -74, 112, 0),
+		vcoef = _mm_setr_epi16(112, -94, -18, 0, 112, -94, -18, 0);
+
+	unsigned i = 0;
+	for (; i + 16 <= width; i += 16)  // 8 blocks
+	{
+		__m128i s[4];
+		for (unsigned k = 0; k < 4; ++k)
+			s[k] = block_sums_sse2(row0 + 4*(i + 4*k), row1 + 4*(i + 4*k));
+
+		__m128i u8 = _mm_packus_epi16(_mm_packs_epi32(chroma4_sse2(s[0], s[1], ucoef), chroma4_sse2(s[2], s[3], ucoef)), _mm_setzero_si128()),
+			v8 = _mm_packus_epi16(_mm_packs_epi32(chroma4_sse2(s[0], s[1], vcoef), chroma4_sse2(s[2], s[3], vcoef)), _mm_setzero_si128());
+
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(u + i/2), u8);
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(v + i/2), v8);
+	}
+
+	chroma_row_scalar(row0, row1, i, width, u, v);
+}
+
+//! Y for 8 pixels as 32-bit integers (in order)
+__attribute__((target("avx2")))
+inline __m256i luma8_avx2(__m256i px, __m256i coef)
+{
+	__m256i zero = _mm256_setzero_si256();
+	__m256 lo = _mm256_castsi256_ps(_mm256_madd_epi16(_mm256_unpacklo_epi8(px, zero), coef)),  // per lane pixels 0,1 (4,5)
+		hi = _mm256_castsi256_ps(_mm256_madd_epi16(_mm256_unpackhi_epi8(px, zero), coef));  // pixels 2,3 (6,7)
+	__m256i sum = _mm256_add_epi32(
+		_mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2,0,2,0))),
+		_mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3,1,3,1))));
+	return _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(128)), 8), _mm256_set1_epi32(16));
+}
+
+__attribute__((target("avx2")))
+void luma_row_avx2(uint8_t const * rgba, unsigned width, uint8_t * y)
+{
+	__m256i const coef = _mm256_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0, 66, 129, 25, 0, 66, 129, 25, 0);
+	__m256i const order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);  // packs work per 128-bit lane
+
+	unsigned i = 0;
+	for (; i + 32 <= width; i += 32)
+	{
+		__m256i const * src = reinterpret_cast<__m256i const *>(rgba + 4*i);
+		__m256i y0 = luma8_avx2(_mm256_loadu_si256(src), coef),
+			y1 = luma8_avx2(_mm256_loadu_si256(src + 1), coef),
+			y2 = luma8_avx2(_mm256_loadu_si256(src + 2), coef),
+			y3 = luma8_avx2(_mm256_loadu_si256(src + 3), coef);
+
+		__m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(y0, y1), _mm256_packs_epi32(y2, y3));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(y + i), _mm256_permutevar8x32_epi32(packed, order));
+	}
+
+	luma_row_sse2(rgba + 4*i, width - i, y + i);
+}
+
+#endif  // HAVE_X86_KERNELS
+
+struct kernel
+{
+	row_function luma_row;
+	chroma_row_function chroma_row;
+	char const * name;
+};
+
+kernel const & select_kernel()
+{
+#if defined(HAVE_X86_KERNELS)
+	static kernel const k = __builtin_cpu_supports("avx2") ?
+		kernel{luma_row_avx2, chroma_row_sse2, "avx2"} : kernel{luma_row_sse2, chroma_row_sse2, "sse2"};
+#else
+	static kernel const k{luma_row_scalar, chroma_row_scalar, "scalar"};
+#endif
+	return k;
+}
+
+}  // namespace
+
+void rgba_to_i420(uint8_t const * rgba, int stride, unsigned width, unsigned height,
+	uint8_t * y, uint8_t * u, uint8_t * v)
+{
+	kernel const & k = select_kernel();
+	unsigned const chroma_width = (width + 1) / 2;
+
+	for (unsigned r = 0; r < height; ++r)
+		k.luma_row(rgba + ptrdiff_t(r)*stride, width, y + r*width);
+
+	for (unsigned r = 0; r < height; r += 2)
+	{
+		uint8_t const * row0 = rgba + ptrdiff_t(r)*stride,
+			* row1 = rgba + ptrdiff_t(min(r + 1, height - 1))*stride;  // odd height replicates last row
+
+		k.chroma_row(row0, row1, width, u + (r/2)*chroma_width, v + (r/2)*chroma_width);
+	}
+}
+
+char const * rgba_to_i420_kernel()
+{
+	return select_kernel().name;
+}
+
+void i420_to_rgba(uint8_t const * y, uint8_t const * u, uint8_t const * v, unsigned width, unsigned height,
+	uint8_t * rgba, int stride)
+{
+	unsigned const chroma_width = (width + 1) / 2;
+
+	for (unsigned r = 0; r < height; ++r)
+	{
+		uint8_t * dst = rgba + ptrdiff_t(r)*stride;
+		for (unsigned i = 0; i < width; ++i, dst += 4)
+		{
+			int c = 298 * (y[r*width + i] - 16),
+				d = u[(r/2)*chroma_width + i/2] - 128,
+				e = v[(r/2)*chroma_width + i/2] - 128;
+
+			dst[0] = uint8_t(std::clamp((c + 409*e + 128) >> 8, 0, 255));
+			dst[1] = uint8_t(std::clamp((c - 100*d - 208*e + 128) >> 8, 0, 255));
+			dst[2] = uint8_t(std::clamp((c + 516*d + 128) >> 8, 0, 255));
+			dst[3] = 255;
+		}
+	}
+}
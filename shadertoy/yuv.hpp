@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+
+/*! Converts RGBA image to I420 (planar YUV 4:2:0, BT.601 limited range).
+
+Chroma is averaged from 2x2 pixel blocks (odd width or height is handled by
+edge pixel replication), plane sizes are width*height for y and
+((width+1)/2)*((height+1)/2) for u and v. Uses AVX2 or SSE2 kernel when
+available (chosen at run time).
+\param stride row to row distance in bytes, negative stride can be used to
+flip bottom-up image (e.g. glReadPixels() output), in that case rgba points
+to the last row in memory.
+\code
+vector<uint8_t> y(w*h), u(cw*ch), v(cw*ch);
+rgba_to_i420(pixels + (h-1)*w*4, -w*4, w, h, y.data(), u.data(), v.data());
+\endcode */
+void rgba_to_i420(uint8_t const * rgba, int stride, unsigned width, unsigned height,
+	uint8_t * y, uint8_t * u, uint8_t * v);
+
+char const * rgba_to_i420_kernel();  //!< returns name of the kernel used ("avx2", "sse2" or "scalar")
+
+/*! Converts I420 (BT.601 limited range) image to RGBA (alpha is 255), inverse
+of rgba_to_i420(), stride has the same meaning. */
+void i420_to_rgba(uint8_t const * y, uint8_t const * u, uint8_t const * v, unsigned width, unsigned height,
+	uint8_t * rgba, int stride);